@@ -1,8 +1,8 @@
 /// @file adc_inputs.c
 
-#include <math.h>
 #include "hardware/adc.h"
 #include "adc_inputs.h"
+#include "conversions.h"
 
 //---------------------------------------------------------------------------------------------------
 // Macro directives
@@ -12,13 +12,6 @@
 #define GPIO_FOR_ADC0			26
 #define GPIO_FOR_ADC1			27
 
-//---------------------------------------------------------------------------------------------------
-// Local constants
-//---------------------------------------------------------------------------------------------------
-
-static const float GetVoltageCoefficient = 20.0 / (ADC_RAW_BUFFER_SIZE * 4096.0);
-static const float GetVoltageOffset = 10.0;
-
 //---------------------------------------------------------------------------------------------------
 // Local variables
 //---------------------------------------------------------------------------------------------------
@@ -33,6 +26,10 @@ static uint16_t RawBufferAdc1[ADC_RAW_BUFFER_SIZE];
 /// Index for writing new samples from ADC0 and ADC1
 static volatile uint32_t AdcBuffersHead = 0;
 
+/// @brief These variables are used in timer interrupt handler
+/// Running sums of all the samples in RawBufferAdc0 and RawBufferAdc1 (updated with every new sample)
+static volatile uint32_t AccumulatorAdc0, AccumulatorAdc1;
+
 //---------------------------------------------------------------------------------------------------
 // Function definitions
 //---------------------------------------------------------------------------------------------------
@@ -40,6 +37,12 @@ static volatile uint32_t AdcBuffersHead = 0;
 /// @brief This function initializes peripherals for ADC measuring and the state machine for measurements
 void initializeAdcMeasurements(void){
 	AdcBuffersHead = 0;
+	AccumulatorAdc0 = 0;
+	AccumulatorAdc1 = 0;
+	for (uint8_t J = 0; J < ADC_RAW_BUFFER_SIZE; J++){
+		RawBufferAdc0[J] = 0;
+		RawBufferAdc1[J] = 0;
+	}
 	adc_init();
 	adc_gpio_init(GPIO_FOR_ADC0);
 	adc_gpio_init(GPIO_FOR_ADC1);
@@ -51,12 +54,16 @@ void getVoltageSamples(void){
 	// Measure ADC0
     adc_select_input(0);
     (void)adc_read();                // dummy read
-    RawBufferAdc0[AdcBuffersHead] = adc_read();
+    uint16_t NewSample = adc_read();
+    AccumulatorAdc0 = AccumulatorAdc0 - RawBufferAdc0[AdcBuffersHead] + NewSample;
+    RawBufferAdc0[AdcBuffersHead] = NewSample;
 
     // Measure ADC1
     adc_select_input(1);
     (void)adc_read();                // dummy read
-    RawBufferAdc1[AdcBuffersHead] = adc_read();
+    NewSample = adc_read();
+    AccumulatorAdc1 = AccumulatorAdc1 - RawBufferAdc1[AdcBuffersHead] + NewSample;
+    RawBufferAdc1[AdcBuffersHead] = NewSample;
 
     AdcBuffersHead++;
     if (AdcBuffersHead >= ADC_RAW_BUFFER_SIZE){
@@ -65,22 +72,15 @@ void getVoltageSamples(void){
 }
 
 /// @brief This function measures the voltage at ADC input and make some calculations
-/// The function acts in the main loop
-float getVoltage( uint8_t AdcIndex ){
-	if (0 == AdcIndex){
-		uint32_t Accumulator = 0;
-		for (uint8_t J = 0; J < ADC_RAW_BUFFER_SIZE; J++){
-			Accumulator += RawBufferAdc0[J];
-		}
-		return (float)Accumulator * GetVoltageCoefficient - GetVoltageOffset;
+/// The function acts in the main loop and in the timer interrupt (the running sums are read with single loads)
+/// The channel 1 is measured with ADC0, the other channels with ADC1; the calibration of the given channel is applied.
+/// @param Channel index of the power supply unit
+/// @return voltage in microvolts (the average of the last ADC_RAW_BUFFER_SIZE samples)
+/// @return ADC_INVALID_VOLTAGE if Channel is incorrect
+int32_t getVoltage( uint8_t Channel ){
+	if (Channel >= NUMBER_OF_POWER_SUPPLIES){
+		return ADC_INVALID_VOLTAGE;
 	}
-	if (1 == AdcIndex){
-		uint32_t Accumulator = 0;
-		for (uint8_t J = 0; J < ADC_RAW_BUFFER_SIZE; J++){
-			Accumulator += RawBufferAdc1[J];
-		}
-		return (float)Accumulator * GetVoltageCoefficient - GetVoltageOffset;
-	}
-	return NAN;
+	uint32_t Accumulator = (0 == Channel)? AccumulatorAdc0 : AccumulatorAdc1;
+	return convertAdcSumToMicroVolts( Channel, Accumulator, ADC_RAW_BUFFER_SIZE );
 }
-
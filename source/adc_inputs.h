@@ -6,6 +6,16 @@
 
 #include "pico/stdlib.h"
 
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+/// Number of analog inputs (ADC0 measures the channel 1, ADC1 the other channels)
+#define NUMBER_OF_ADC_INPUTS	2
+
+/// This value is returned by getVoltage in the case of an incorrect channel index
+#define ADC_INVALID_VOLTAGE		INT32_MIN
+
 //---------------------------------------------------------------------------------------------------
 // Function prototypes
 //---------------------------------------------------------------------------------------------------
@@ -17,6 +27,9 @@ void initializeAdcMeasurements(void);
 void getVoltageSamples(void);
 
 /// @brief This function measures the voltage at ADC input and make some calculations
-float getVoltage( uint8_t AdcIndex );
+/// @param Channel index of the power supply unit
+/// @return voltage in microvolts
+/// @return ADC_INVALID_VOLTAGE if Channel is incorrect
+int32_t getVoltage( uint8_t Channel );
 
 #endif // SOURCE_ADC_INPUTS_H_
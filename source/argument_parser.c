@@ -0,0 +1,203 @@
+/// @file argument_parser.c
+
+#include <assert.h>
+#include <stdbool.h>
+#include "argument_parser.h"
+#include "conversions.h"
+
+static_assert( (int64_t)(DECIMAL_ARGUMENT_INTEGER_SATURATION+1) * MICRO_UNITS_IN_ONE <= INT32_MAX,
+		"static_assert a saturated argument fits in int32_t micro-units" );
+
+//---------------------------------------------------------------------------------------------------
+// Local constants
+//---------------------------------------------------------------------------------------------------
+
+/// Weights of the decimal places in micro-units (the Cortex-M0+ has no division instruction)
+static const int32_t FractionalWeights[MICRO_UNITS_DECIMAL_DIGITS] = {
+		100000, 10000, 1000, 100, 10, 1
+};
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function parses a decimal fraction (e.g. " -1.25") and converts it to micro-units
+/// The value is accumulated while the characters are validated, so the text is scanned once;
+/// no character at or beyond EndPtr is read.
+int32_t parseDecimalArgument( int32_t *Result, const char *TextPtr, const char *EndPtr ){
+	uint8_t CharacterIndex = 0;
+	uint8_t Spaces = 0;
+	uint8_t Pluses = 0;
+	uint8_t Minuses = 0;
+	uint8_t Points = 0;
+	uint8_t DecimalDigits = 0;
+	int32_t IntegerPart = 0;
+	int32_t FractionalPart = 0;
+	uint8_t FractionalDigits = 0;
+
+	while( CharacterIndex < DECIMAL_ARGUMENT_MAX_LENGTH ){
+		if (&TextPtr[CharacterIndex] == EndPtr){
+			if (0 == DecimalDigits){
+				// no digit
+				return -12;
+			}
+			int32_t MicroUnits = IntegerPart * MICRO_UNITS_IN_ONE + FractionalPart;
+			*Result = (0 != Minuses)? -MicroUnits : MicroUnits;
+			return CharacterIndex;
+		}
+		char Character = TextPtr[CharacterIndex];
+		if (' ' == Character){
+			Spaces++;
+			if (Spaces > 1){
+				// too many spaces
+				return -11;
+			}
+			if ((Pluses != 0) || (Minuses != 0) || (DecimalDigits != 0)){
+				// improper position of space
+				return -10;
+			}
+		}
+		else if ('+' == Character){
+			Pluses++;
+			if (Pluses > 1){
+				// too many pluses
+				return -9;
+			}
+			if ((Minuses != 0) || (DecimalDigits != 0)){
+				// improper position of plus
+				return -8;
+			}
+		}
+		else if ('-' == Character){
+			Minuses++;
+			if (Minuses > 1){
+				// too many minuses
+				return -7;
+			}
+			if ((Pluses != 0) || (DecimalDigits != 0)){
+				// improper position of minus
+				return -6;
+			}
+		}
+		else if ('.' == Character){
+			Points++;
+			if (Points > 1){
+				// too many points
+				return -5;
+			}
+			if (0 == DecimalDigits){
+				// improper position of point
+				return -4;
+			}
+		}
+		else if (('0' <= Character) && ('9' >= Character)){
+			DecimalDigits++;
+			if (DecimalDigits > DECIMAL_ARGUMENT_DIGITS_LIMIT){
+				// too many digits
+				return -3;
+			}
+			if (0 != Points){
+				if (FractionalDigits < MICRO_UNITS_DECIMAL_DIGITS){
+					FractionalPart += (Character - '0') * FractionalWeights[FractionalDigits];
+					FractionalDigits++;
+				}
+			}
+			else{
+				// saturated, so the conversion to micro-units below cannot overflow
+				IntegerPart = 10 * IntegerPart + (Character - '0');
+				if (IntegerPart > DECIMAL_ARGUMENT_INTEGER_SATURATION){
+					IntegerPart = DECIMAL_ARGUMENT_INTEGER_SATURATION;
+				}
+			}
+		}
+		else{
+			// improper character
+			return -2;
+		}
+		CharacterIndex++;
+	}
+	// improper length
+	return -1;
+}
+
+/// @brief This function parses an unsigned decimal argument (an optional space followed by up to DigitsLimit digits)
+int32_t parseUnsignedArgument( uint32_t *Result, const char *TextPtr, const char *EndPtr, uint8_t DigitsLimit ){
+	uint32_t UInt32_Argument = 0;
+	uint8_t CharacterIndex = 0;
+	uint8_t Spaces = 0;
+	uint8_t DecimalDigits = 0;
+
+	while( CharacterIndex < DigitsLimit+2 ){
+		if (&TextPtr[CharacterIndex] == EndPtr){
+			if (0 == DecimalDigits){
+				// no digit
+				return -5;
+			}
+			*Result = UInt32_Argument;
+			return CharacterIndex;
+		}
+		else if (' ' == TextPtr[CharacterIndex]){
+			Spaces++;
+			if ((Spaces > 1) || (DecimalDigits != 0)){
+				// too many spaces
+				return -4;
+			}
+		}
+		else if (('0' <= TextPtr[CharacterIndex]) && ('9' >= TextPtr[CharacterIndex])){
+			DecimalDigits++;
+			if (DecimalDigits > DigitsLimit){
+				// too many digits
+				return -3;
+			}
+			UInt32_Argument = 10 * UInt32_Argument + (uint32_t)(TextPtr[CharacterIndex] - '0');
+		}
+		else{
+			// improper character
+			return -2;
+		}
+		CharacterIndex++;
+	}
+	// improper length
+	return -1;
+}
+
+/// @brief This function parses a one-digit argument (the digit may be preceded or followed by a space)
+int32_t parseOneDigitArgument( uint8_t *Result, const char *TextPtr, const char *EndPtr ){
+	uint8_t UInt8_Argument = 0;
+	uint8_t CharacterIndex = 0;
+	uint8_t Spaces = 0;
+	uint8_t DecimalDigits = 0;
+
+	while( CharacterIndex < 3 ){
+		if (&TextPtr[CharacterIndex] == EndPtr){
+			if (0 == DecimalDigits){
+				// no digit
+				return -5;
+			}
+			*Result = UInt8_Argument;
+			return CharacterIndex;
+		}
+		else if (' ' == TextPtr[CharacterIndex]){
+			Spaces++;
+			if (Spaces > 1){
+				// too many spaces
+				return -4;
+			}
+		}
+		else if (('0' <= TextPtr[CharacterIndex]) && ('9' >= TextPtr[CharacterIndex])){
+			DecimalDigits++;
+			if (DecimalDigits > 1){
+				// too many digits
+				return -3;
+			}
+			UInt8_Argument = (uint8_t)(TextPtr[CharacterIndex] - '0');
+		}
+		else{
+			// improper character
+			return -2;
+		}
+		CharacterIndex++;
+	}
+	// improper length
+	return -1;
+}
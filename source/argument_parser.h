@@ -0,0 +1,45 @@
+/// @file argument_parser.h
+/// @brief This module parses the numeric arguments of the RSTL commands
+///
+/// The functions check the syntax and convert the text in a single pass, without the C library
+/// (no atof/strtol, no floating-point arithmetic). Each function returns the number of characters
+/// of the argument if it is correct, or a negative error code (the codes are printed in debug messages).
+/// The argument ends at EndPtr (the terminator of the command, or the end of the frame); the functions never read
+/// the character at EndPtr or any character beyond it, so the text needs no terminator and no slack after it.
+
+#ifndef SOURCE_ARGUMENT_PARSER_H_
+#define SOURCE_ARGUMENT_PARSER_H_
+
+#include <stdint.h>
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+#define DECIMAL_ARGUMENT_MAX_LENGTH			9	// " -9.12345"
+#define DECIMAL_ARGUMENT_DIGITS_LIMIT		6
+
+/// An integer part above this limit is replaced by the limit, so the value in micro-units fits in int32_t;
+/// the limit is above the range of every command, so a saturated value is always rejected by the command
+#define DECIMAL_ARGUMENT_INTEGER_SATURATION	100
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function parses a decimal fraction (e.g. " -1.25") and converts it to micro-units
+/// The syntax: an optional space, an optional sign, up to 6 digits with an optional point after the first digit.
+/// Digits beyond the sixth decimal place are ignored; an integer part above DECIMAL_ARGUMENT_INTEGER_SATURATION is
+/// saturated.
+/// @return number of characters or a negative error code (-1...-12)
+int32_t parseDecimalArgument( int32_t *Result, const char *TextPtr, const char *EndPtr );
+
+/// @brief This function parses an unsigned decimal argument (an optional space followed by up to DigitsLimit digits)
+/// @return number of characters or a negative error code (-1...-5)
+int32_t parseUnsignedArgument( uint32_t *Result, const char *TextPtr, const char *EndPtr, uint8_t DigitsLimit );
+
+/// @brief This function parses a one-digit argument (the digit may be preceded or followed by a space)
+/// @return number of characters or a negative error code (-1...-5)
+int32_t parseOneDigitArgument( uint8_t *Result, const char *TextPtr, const char *EndPtr );
+
+#endif // SOURCE_ARGUMENT_PARSER_H_
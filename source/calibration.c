@@ -0,0 +1,163 @@
+/// @file calibration.c
+
+#include <string.h>
+#include <stddef.h>
+#include <assert.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+
+#include "calibration.h"
+#include "conversions.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+/// The calibration record occupies the last sector of the flash memory
+#define CALIBRATION_FLASH_OFFSET		(PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+
+#define CALIBRATION_SIGNATURE			0x4C414331u		// "CAL1"
+#define CALIBRATION_VERSION				1u
+
+#define CRC32_POLYNOMIAL				0xEDB88320u
+
+//---------------------------------------------------------------------------------------------------
+// Local constants
+//---------------------------------------------------------------------------------------------------
+
+/// The layout of the calibration record in flash
+typedef struct {
+	uint32_t Signature;
+	uint32_t Version;
+	ChannelCalibration Channels[NUMBER_OF_POWER_SUPPLIES];
+	uint32_t Checksum;				// CRC-32 of all the preceding fields
+} CalibrationRecord;
+
+static_assert( sizeof(CalibrationRecord) <= FLASH_PAGE_SIZE, "static_assert sizeof(CalibrationRecord) <= FLASH_PAGE_SIZE" );
+
+//---------------------------------------------------------------------------------------------------
+// Local variables
+//---------------------------------------------------------------------------------------------------
+
+/// Working copy of the calibration data (the conversion factors are derived from it)
+static ChannelCalibration Calibration[NUMBER_OF_POWER_SUPPLIES];
+
+//---------------------------------------------------------------------------------------------------
+// Local function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function calculates CRC-32 (the same as in zlib) of a block of data
+static uint32_t calculateCrc32( const uint8_t *DataPtr, size_t Length );
+
+static void setNominalCalibration( ChannelCalibration *CalibrationPtr );
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function loads the calibration data from flash (or sets nominal values) and updates the conversion factors
+void initializeCalibration(void){
+	const CalibrationRecord *StoredRecordPtr = (const CalibrationRecord *)(XIP_BASE + CALIBRATION_FLASH_OFFSET);
+	bool IsStoredRecordValid =
+			(CALIBRATION_SIGNATURE == StoredRecordPtr->Signature) &&
+			(CALIBRATION_VERSION == StoredRecordPtr->Version) &&
+			(calculateCrc32( (const uint8_t *)StoredRecordPtr, offsetof(CalibrationRecord, Checksum) ) == StoredRecordPtr->Checksum);
+
+	for (uint8_t J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++){
+		if (IsStoredRecordValid){
+			Calibration[J] = StoredRecordPtr->Channels[J];
+		}
+		else{
+			setNominalCalibration( &Calibration[J] );
+		}
+		updateConversionFactors( J, &Calibration[J] );
+	}
+}
+
+/// @brief This function returns the calibration data of a given channel
+const ChannelCalibration* getChannelCalibration( uint8_t Channel ){
+	if (Channel >= NUMBER_OF_POWER_SUPPLIES){
+		Channel = 0;
+	}
+	return &Calibration[Channel];
+}
+
+/// @brief This function sets the DAC value corresponding to zero current
+bool setDacZeroOffset( uint8_t Channel, uint16_t DacValue ){
+	if ((Channel >= NUMBER_OF_POWER_SUPPLIES) || (DacValue > FULL_SCALE_IN_DAC_UNITS)){
+		return false;
+	}
+	Calibration[Channel].DacZeroOffset = DacValue;
+	updateConversionFactors( Channel, &Calibration[Channel] );
+	return true;
+}
+
+/// @brief This function sets the DAC gain (in ppm of the nominal value)
+bool setDacGain( uint8_t Channel, int32_t Gain ){
+	if ((Channel >= NUMBER_OF_POWER_SUPPLIES) || (Gain < CALIBRATION_MIN_GAIN) || (Gain > CALIBRATION_MAX_GAIN)){
+		return false;
+	}
+	Calibration[Channel].DacGain = Gain;
+	updateConversionFactors( Channel, &Calibration[Channel] );
+	return true;
+}
+
+/// @brief This function sets the ADC offset correction (in microvolts)
+bool setAdcOffset( uint8_t Channel, int32_t MicroVolts ){
+	if ((Channel >= NUMBER_OF_POWER_SUPPLIES) || (MicroVolts < -CALIBRATION_MAX_ADC_OFFSET) || (MicroVolts > CALIBRATION_MAX_ADC_OFFSET)){
+		return false;
+	}
+	Calibration[Channel].AdcOffset = MicroVolts;
+	updateConversionFactors( Channel, &Calibration[Channel] );
+	return true;
+}
+
+/// @brief This function sets the ADC gain (in ppm of the nominal value)
+bool setAdcGain( uint8_t Channel, int32_t Gain ){
+	if ((Channel >= NUMBER_OF_POWER_SUPPLIES) || (Gain < CALIBRATION_MIN_GAIN) || (Gain > CALIBRATION_MAX_GAIN)){
+		return false;
+	}
+	Calibration[Channel].AdcGain = Gain;
+	updateConversionFactors( Channel, &Calibration[Channel] );
+	return true;
+}
+
+/// @brief This function writes the calibration data of all channels to flash
+bool saveCalibration(void){
+	static uint8_t PageBuffer[FLASH_PAGE_SIZE];
+	CalibrationRecord *NewRecordPtr = (CalibrationRecord *)PageBuffer;
+
+	memset( PageBuffer, 0xFF, sizeof(PageBuffer) );
+	NewRecordPtr->Signature = CALIBRATION_SIGNATURE;
+	NewRecordPtr->Version = CALIBRATION_VERSION;
+	memcpy( NewRecordPtr->Channels, Calibration, sizeof(Calibration) );
+	NewRecordPtr->Checksum = calculateCrc32( PageBuffer, offsetof(CalibrationRecord, Checksum) );
+
+	// the code is executed from flash, so no interrupt handler may run while the flash is busy
+	uint32_t InterruptsState = save_and_disable_interrupts();
+	flash_range_erase( CALIBRATION_FLASH_OFFSET, FLASH_SECTOR_SIZE );
+	flash_range_program( CALIBRATION_FLASH_OFFSET, PageBuffer, FLASH_PAGE_SIZE );
+	restore_interrupts( InterruptsState );
+
+	return 0 == memcmp( (const void *)(XIP_BASE + CALIBRATION_FLASH_OFFSET), PageBuffer, sizeof(CalibrationRecord) );
+}
+
+static void setNominalCalibration( ChannelCalibration *CalibrationPtr ){
+	CalibrationPtr->DacZeroOffset = OFFSET_IN_DAC_UNITS;
+	CalibrationPtr->Reserved = 0;
+	CalibrationPtr->DacGain = CALIBRATION_NOMINAL_GAIN;
+	CalibrationPtr->AdcOffset = 0;
+	CalibrationPtr->AdcGain = CALIBRATION_NOMINAL_GAIN;
+}
+
+static uint32_t calculateCrc32( const uint8_t *DataPtr, size_t Length ){
+	uint32_t Crc = 0xFFFFFFFFu;
+	for (size_t J = 0; J < Length; J++){
+		Crc ^= DataPtr[J];
+		for (uint8_t K = 0; K < 8; K++){
+			Crc = (Crc >> 1) ^ (CRC32_POLYNOMIAL & (0u - (Crc & 1u)));
+		}
+	}
+	return ~Crc;
+}
@@ -0,0 +1,78 @@
+/// @file calibration.h
+/// @brief This module stores per-channel calibration data of DACs and ADC inputs
+///
+/// The calibration data are kept in RAM and can be saved in the last sector of the flash memory.
+/// The record in flash is protected with a CRC-32 checksum; if it is missing or damaged,
+/// nominal values are used. Every change of the calibration data updates the precomputed integer factors
+/// used by the conversions module, so the cost of a single conversion does not depend on the calibration.
+
+#ifndef SOURCE_CALIBRATION_H_
+#define SOURCE_CALIBRATION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+/// Gains are expressed in ppm (parts per million) of the nominal value
+#define CALIBRATION_NOMINAL_GAIN		1000000
+#define CALIBRATION_MIN_GAIN			500000
+#define CALIBRATION_MAX_GAIN			2000000
+
+/// The limit of the ADC offset correction in microvolts
+#define CALIBRATION_MAX_ADC_OFFSET		1000000
+
+//---------------------------------------------------------------------------------------------------
+// Global constants
+//---------------------------------------------------------------------------------------------------
+
+/// Calibration data of a single channel
+typedef struct {
+	uint16_t DacZeroOffset;				// DAC value corresponding to zero output current
+	uint16_t Reserved;					// padding; always zero
+	int32_t DacGain;					// DAC gain in ppm of the nominal value (4096 DAC units per 20 A)
+	int32_t AdcOffset;					// correction added to the measured voltage in microvolts
+	int32_t AdcGain;					// ADC gain in ppm of the nominal value (4096 ADC units per 20 V)
+} ChannelCalibration;
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function loads the calibration data from flash (or sets nominal values) and updates the conversion factors
+void initializeCalibration(void);
+
+/// @brief This function returns the calibration data of a given channel
+const ChannelCalibration* getChannelCalibration( uint8_t Channel );
+
+/// @brief This function sets the DAC value corresponding to zero current
+/// @return true on success
+/// @return false if the argument is out of range
+bool setDacZeroOffset( uint8_t Channel, uint16_t DacValue );
+
+/// @brief This function sets the DAC gain (in ppm of the nominal value)
+/// @return true on success
+/// @return false if the argument is out of range
+bool setDacGain( uint8_t Channel, int32_t Gain );
+
+/// @brief This function sets the ADC offset correction (in microvolts)
+/// @return true on success
+/// @return false if the argument is out of range
+bool setAdcOffset( uint8_t Channel, int32_t MicroVolts );
+
+/// @brief This function sets the ADC gain (in ppm of the nominal value)
+/// @return true on success
+/// @return false if the argument is out of range
+bool setAdcGain( uint8_t Channel, int32_t Gain );
+
+/// @brief This function writes the calibration data of all channels to flash
+/// The function disables interrupts for the time of erasing and programming the flash sector (tens of milliseconds),
+/// so it may be called only when the power supplies are stopped.
+/// @return true on success
+/// @return false if verification of the written data failed
+bool saveCalibration(void);
+
+#endif // SOURCE_CALIBRATION_H_
@@ -0,0 +1,114 @@
+/// @file command_trie.c
+
+#include <assert.h>
+#include "command_trie.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+/// The root is never a child nor a sibling, so its index marks the end of a list
+#define NO_NODE			0
+
+//---------------------------------------------------------------------------------------------------
+// Global constants
+//---------------------------------------------------------------------------------------------------
+
+/// A node of the tree: one character of a name; the children of a node form a list
+typedef struct {
+	char Character;
+	uint8_t CommandIndex;			// COMMAND_TRIE_NO_COMMAND if no name ends at this node
+	uint8_t FirstChild;
+	uint8_t NextSibling;
+} CommandTrieNode;
+
+static_assert( COMMAND_TRIE_MAX_NODES <= 256, "static_assert COMMAND_TRIE_MAX_NODES <= 256 (8-bit indexes)" );
+
+//---------------------------------------------------------------------------------------------------
+// Local variables
+//---------------------------------------------------------------------------------------------------
+
+static CommandTrieNode Nodes[COMMAND_TRIE_MAX_NODES];
+
+static uint16_t NodesInUse;
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function finds the child of a node for a given character
+/// @return index of the child or NO_NODE
+static uint8_t findChild( uint8_t Parent, char Character );
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function removes all the names from the tree
+void clearCommandTrie(void){
+	Nodes[0].Character = 0;
+	Nodes[0].CommandIndex = COMMAND_TRIE_NO_COMMAND;
+	Nodes[0].FirstChild = NO_NODE;
+	Nodes[0].NextSibling = NO_NODE;
+	NodesInUse = 1;
+}
+
+/// @brief This function adds a name to the tree
+bool addCommandToTrie( const char *Name, uint8_t CommandIndex ){
+	if ((0 == NodesInUse) || (0 == Name[0]) || (COMMAND_TRIE_NO_COMMAND == CommandIndex)){
+		return false;
+	}
+	uint8_t Node = 0;
+	for (uint8_t J = 0; 0 != Name[J]; J++){
+		uint8_t Child = findChild( Node, Name[J] );
+		if (NO_NODE == Child){
+			if (NodesInUse >= COMMAND_TRIE_MAX_NODES){
+				return false;
+			}
+			Child = (uint8_t)NodesInUse;
+			NodesInUse++;
+			Nodes[Child].Character = Name[J];
+			Nodes[Child].CommandIndex = COMMAND_TRIE_NO_COMMAND;
+			Nodes[Child].FirstChild = NO_NODE;
+			Nodes[Child].NextSibling = Nodes[Node].FirstChild;
+			Nodes[Node].FirstChild = Child;
+		}
+		Node = Child;
+	}
+	if (COMMAND_TRIE_NO_COMMAND != Nodes[Node].CommandIndex){
+		return false;	// duplicated name
+	}
+	Nodes[Node].CommandIndex = CommandIndex;
+	return true;
+}
+
+/// @brief This function finds the longest name at the beginning of the text
+uint8_t findCommandInTrie( const char *Text, uint16_t Length, uint8_t *NameLengthPtr ){
+	uint8_t Result = COMMAND_TRIE_NO_COMMAND;
+	uint8_t Node = 0;
+	*NameLengthPtr = 0;
+	for (uint16_t J = 0; J < Length; J++){
+		Node = findChild( Node, Text[J] );
+		if (NO_NODE == Node){
+			break;
+		}
+		if (COMMAND_TRIE_NO_COMMAND != Nodes[Node].CommandIndex){
+			Result = Nodes[Node].CommandIndex;
+			*NameLengthPtr = (uint8_t)(J+1);
+		}
+	}
+	return Result;
+}
+
+/// @brief This function returns the number of nodes in use (for diagnostics)
+uint16_t getCommandTrieSize(void){
+	return NodesInUse;
+}
+
+static uint8_t findChild( uint8_t Parent, char Character ){
+	uint8_t Child = Nodes[Parent].FirstChild;
+	while ((NO_NODE != Child) && (Character != Nodes[Child].Character)){
+		Child = Nodes[Child].NextSibling;
+	}
+	return Child;
+}
@@ -0,0 +1,50 @@
+/// @file command_trie.h
+/// @brief This module finds command names at the beginning of a text using a prefix tree (trie)
+///
+/// The tree is built once (at initialization) from the command table of the protocol module.
+/// The lookup is a single pass over the text: one step per character of the name, independent of
+/// the number of commands. The longest matching name is returned, so the order of the commands
+/// in the table does not matter (e.g. "?CAL" and "?CALZ").
+
+#ifndef SOURCE_COMMAND_TRIE_H_
+#define SOURCE_COMMAND_TRIE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+/// Maximum number of nodes (characters of all names, without common prefixes, plus the root)
+#ifndef COMMAND_TRIE_MAX_NODES
+#define COMMAND_TRIE_MAX_NODES			160
+#endif
+
+/// This value is returned by findCommandInTrie if no name matches
+#define COMMAND_TRIE_NO_COMMAND			0xFF
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function removes all the names from the tree
+void clearCommandTrie(void);
+
+/// @brief This function adds a name to the tree
+/// @param Name command name (printable characters)
+/// @param CommandIndex value returned by findCommandInTrie for this name (less than COMMAND_TRIE_NO_COMMAND)
+/// @return false if the tree is full or the name is already there
+bool addCommandToTrie( const char *Name, uint8_t CommandIndex );
+
+/// @brief This function finds the longest name at the beginning of the text
+/// @param Text the text to be searched (it need not be terminated)
+/// @param Length the number of characters of the text
+/// @param NameLengthPtr the length of the name found is stored here
+/// @return index of the command or COMMAND_TRIE_NO_COMMAND
+uint8_t findCommandInTrie( const char *Text, uint16_t Length, uint8_t *NameLengthPtr );
+
+/// @brief This function returns the number of nodes in use (for diagnostics)
+uint16_t getCommandTrieSize(void);
+
+#endif // SOURCE_COMMAND_TRIE_H_
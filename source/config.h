@@ -10,7 +10,8 @@
 
 #define SIMULATE_HARDWARE_PSU			0
 
-// This is a digital value for DAC corresponding to analog zero current
+// This is a nominal digital value for DAC corresponding to analog zero current
+// (the value used at run time is calibrated for each channel, see calibration.h)
 #define OFFSET_IN_DAC_UNITS				2048
 
 #define NUMBER_OF_POWER_SUPPLIES		4
@@ -22,6 +23,26 @@
 /// i2c error messages will be sent without prompting.
 #define SEND_I2C_ERROR_MESSAGE_ASYNCHRONOUSLY	1
 
+/// If this directive has a value of 1, the message "SETTLED <channel>" is sent without prompting
+/// when the ramp of a channel reaches the user's setpoint (the ?ETA command gives the remaining time anyway).
+#define SEND_SETTLED_MESSAGE_ASYNCHRONOUSLY		0
+
+/// If this directive has a value of 1, a command is complete as soon as its terminator "\r\n" is received;
+/// the silence detection is used only for frames without the terminator. If it has a value of 0,
+/// a command is complete after a period of silence (3 bytes) on the serial line.
+#define COMMAND_FRAMING_BY_TERMINATOR			1
+
+/// If this directive has a value of 1, the baud rate of the serial port is detected at boot: the firmware waits
+/// (up to 3 s) for characters from the master (e.g. "\r") and measures the shortest low pulse on the RX line;
+/// the characters used for the measurement are lost.
+/// Otherwise the port starts at 4800 Bd; in both cases the rate can be changed by the BAUD command.
+#define UART_AUTO_BAUD_AT_BOOT					0
+
+/// If this directive has a value of 1, the measured currents are compared with the values written to the DACs;
+/// a channel that deviates too much (or whose measurement reaches the end of the ADC range) switches the power supplies
+/// off (see trip_monitor.h). With the default settings only the overcurrent (end of the range) check is active.
+#define ENABLE_TRIP_MONITOR				1
+
 /// The 1'st PCF8574 address (A0=A1=A2=high)
 #define PCF8574_ADDRESS_2				0x27
 
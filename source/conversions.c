@@ -0,0 +1,189 @@
+/// @file conversions.c
+
+#include "conversions.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+/// The ADC range (4096 units) corresponds to 20 V, so 1 ADC unit = 20000000/4096 uV = 78125/16 uV (exactly)
+#define MICROVOLTS_PER_ADC_UNIT_NUMERATOR		78125
+#define MICROVOLTS_PER_ADC_UNIT_DENOMINATOR		16
+
+/// The voltage corresponding to the ADC value equal to zero
+#define ADC_OFFSET_IN_MICROVOLTS			10000000
+
+/// Fractional bits of the precomputed factors
+#define DAC_FACTOR_FRACTIONAL_BITS			36
+#define INVERSE_DAC_FACTOR_FRACTIONAL_BITS	16
+#define ADC_FACTOR_FRACTIONAL_BITS			24
+
+/// Above this value (approx. 40 A) the DAC value is saturated anyway; the limit prevents overflows
+#define MICROAMPERES_SATURATION				(2 * MICROAMPERES_PER_DAC_UNIT_NUMERATOR / MICROAMPERES_PER_DAC_UNIT_DENOMINATOR * (FULL_SCALE_IN_DAC_UNITS+1))
+
+//---------------------------------------------------------------------------------------------------
+// Local constants
+//---------------------------------------------------------------------------------------------------
+
+static const int32_t PowersOfTen[MICRO_UNITS_DECIMAL_DIGITS+1] = {
+		1, 10, 100, 1000, 10000, 100000, 1000000
+};
+
+/// Precomputed conversion factors of a single channel
+typedef struct {
+	uint16_t DacZeroOffset;
+	bool IsNominalDacGain;				// the exact conversion is used for the nominal gain
+	bool IsNominalAdcGain;
+	uint32_t DacUnitsPerMicroAmpere;	// fixed-point number with DAC_FACTOR_FRACTIONAL_BITS fractional bits
+	uint32_t MicroAmperesPerDacUnit;	// fixed-point number with INVERSE_DAC_FACTOR_FRACTIONAL_BITS fractional bits
+	uint32_t AdcGain;					// fixed-point number with ADC_FACTOR_FRACTIONAL_BITS fractional bits
+	int32_t AdcOffset;					// in microvolts
+} ConversionFactors;
+
+//---------------------------------------------------------------------------------------------------
+// Local variables
+//---------------------------------------------------------------------------------------------------
+
+/// These factors are modified only when the power supplies are stopped (or during initialization)
+static ConversionFactors Factors[NUMBER_OF_POWER_SUPPLIES];
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function recalculates the conversion factors of a given channel after a change of its calibration data
+void updateConversionFactors( uint8_t Channel, const ChannelCalibration *CalibrationPtr ){
+	if (Channel >= NUMBER_OF_POWER_SUPPLIES){
+		return;
+	}
+	ConversionFactors *FactorsPtr = &Factors[Channel];
+	uint64_t Gain = (uint64_t)CalibrationPtr->DacGain;
+
+	FactorsPtr->DacZeroOffset = CalibrationPtr->DacZeroOffset;
+	FactorsPtr->IsNominalDacGain = (CALIBRATION_NOMINAL_GAIN == CalibrationPtr->DacGain);
+	// round( 2^36 * (16/78125) * Gain/10^6 )
+	FactorsPtr->DacUnitsPerMicroAmpere = (uint32_t)((((uint64_t)1 << (DAC_FACTOR_FRACTIONAL_BITS + 4)) * Gain +
+			(uint64_t)MICROAMPERES_PER_DAC_UNIT_NUMERATOR * CALIBRATION_NOMINAL_GAIN / 2) /
+			((uint64_t)MICROAMPERES_PER_DAC_UNIT_NUMERATOR * CALIBRATION_NOMINAL_GAIN));
+	// round( 2^16 * (78125/16) * 10^6/Gain )
+	FactorsPtr->MicroAmperesPerDacUnit = (uint32_t)(((uint64_t)MICROAMPERES_PER_DAC_UNIT_NUMERATOR * CALIBRATION_NOMINAL_GAIN *
+			(1u << (INVERSE_DAC_FACTOR_FRACTIONAL_BITS - 4)) + Gain / 2) / Gain);
+
+	FactorsPtr->IsNominalAdcGain = (CALIBRATION_NOMINAL_GAIN == CalibrationPtr->AdcGain);
+	FactorsPtr->AdcGain = (uint32_t)((((uint64_t)CalibrationPtr->AdcGain << ADC_FACTOR_FRACTIONAL_BITS) +
+			CALIBRATION_NOMINAL_GAIN / 2) / CALIBRATION_NOMINAL_GAIN);
+	FactorsPtr->AdcOffset = CalibrationPtr->AdcOffset;
+}
+
+/// @brief This function returns the DAC value corresponding to zero output current of a given channel
+uint16_t getDacZeroOffset( uint8_t Channel ){
+	if (Channel >= NUMBER_OF_POWER_SUPPLIES){
+		return OFFSET_IN_DAC_UNITS;
+	}
+	return Factors[Channel].DacZeroOffset;
+}
+
+/// @brief This function converts the current in microamperes to the value for the DAC
+/// The result is rounded to the nearest DAC unit (half away from zero) and clamped to 0 ... FULL_SCALE_IN_DAC_UNITS
+/// For the nominal gain, the intermediate results fit in 32 bits; otherwise one 32x32->64-bit multiplication is used.
+/// @param Channel index of the power supply unit
+/// @param MicroAmperes current (negative or positive)
+/// @return DAC value (including the zero offset of the channel)
+uint16_t convertMicroAmperesToDacValue( uint8_t Channel, int32_t MicroAmperes ){
+	if (Channel >= NUMBER_OF_POWER_SUPPLIES){
+		Channel = 0;
+	}
+	const ConversionFactors *FactorsPtr = &Factors[Channel];
+	uint32_t Magnitude = (MicroAmperes < 0)? (uint32_t)(-MicroAmperes) : (uint32_t)MicroAmperes;
+	if (Magnitude > MICROAMPERES_SATURATION){
+		Magnitude = MICROAMPERES_SATURATION; // far beyond the range anyway
+	}
+	int32_t DacUnits;
+	if (FactorsPtr->IsNominalDacGain){
+		// round( Magnitude * 16 / 78125 )
+		DacUnits = (int32_t)((2 * MICROAMPERES_PER_DAC_UNIT_DENOMINATOR * Magnitude + MICROAMPERES_PER_DAC_UNIT_NUMERATOR) /
+				(2 * MICROAMPERES_PER_DAC_UNIT_NUMERATOR));
+	}
+	else{
+		DacUnits = (int32_t)(((uint64_t)Magnitude * FactorsPtr->DacUnitsPerMicroAmpere +
+				((uint64_t)1 << (DAC_FACTOR_FRACTIONAL_BITS - 1))) >> DAC_FACTOR_FRACTIONAL_BITS);
+	}
+	if (MicroAmperes < 0){
+		DacUnits = -DacUnits;
+	}
+	DacUnits += FactorsPtr->DacZeroOffset;
+	if (DacUnits < 0){
+		DacUnits = 0;
+	}
+	if (DacUnits > FULL_SCALE_IN_DAC_UNITS){
+		DacUnits = FULL_SCALE_IN_DAC_UNITS;
+	}
+	return (uint16_t)DacUnits;
+}
+
+/// @brief This function converts the DAC value to the current in microamperes
+/// The result is rounded to the nearest microampere (half away from zero)
+/// @param Channel index of the power supply unit
+/// @param DacValue DAC value (including the zero offset of the channel)
+/// @return current in microamperes
+int32_t convertDacValueToMicroAmperes( uint8_t Channel, uint16_t DacValue ){
+	if (Channel >= NUMBER_OF_POWER_SUPPLIES){
+		Channel = 0;
+	}
+	const ConversionFactors *FactorsPtr = &Factors[Channel];
+	int32_t DacUnits = (int32_t)DacValue - FactorsPtr->DacZeroOffset;
+	uint32_t Magnitude = (DacUnits < 0)? (uint32_t)(-DacUnits) : (uint32_t)DacUnits;
+	int32_t MicroAmperes;
+	if (FactorsPtr->IsNominalDacGain){
+		// round( Magnitude * 78125 / 16 )
+		MicroAmperes = (int32_t)((2 * MICROAMPERES_PER_DAC_UNIT_NUMERATOR * Magnitude + MICROAMPERES_PER_DAC_UNIT_DENOMINATOR) /
+				(2 * MICROAMPERES_PER_DAC_UNIT_DENOMINATOR));
+	}
+	else{
+		MicroAmperes = (int32_t)(((uint64_t)Magnitude * FactorsPtr->MicroAmperesPerDacUnit +
+				(1u << (INVERSE_DAC_FACTOR_FRACTIONAL_BITS - 1))) >> INVERSE_DAC_FACTOR_FRACTIONAL_BITS);
+	}
+	return (DacUnits < 0)? -MicroAmperes : MicroAmperes;
+}
+
+/// @brief This function converts the sum of ADC samples to microvolts
+/// The calculation is split into the integer and the fractional part of Accumulator/Divider,
+/// so that all intermediate results fit in 32 bits.
+/// @param Channel index of the power supply unit (selects the ADC calibration)
+/// @param Accumulator sum of SamplesNumber 12-bit ADC samples
+/// @param SamplesNumber number of samples in the sum (must be a power of two, not greater than 1024)
+/// @return voltage in microvolts (nominally, the ADC range 0 ... 4096 corresponds to -10 V ... +10 V)
+int32_t convertAdcSumToMicroVolts( uint8_t Channel, uint32_t Accumulator, uint32_t SamplesNumber ){
+	if (Channel >= NUMBER_OF_POWER_SUPPLIES){
+		Channel = 0;
+	}
+	const ConversionFactors *FactorsPtr = &Factors[Channel];
+	uint32_t Divider = MICROVOLTS_PER_ADC_UNIT_DENOMINATOR * SamplesNumber;
+	uint32_t Quotient = Accumulator / Divider;
+	uint32_t Remainder = Accumulator % Divider;
+	uint32_t MicroVolts = Quotient * MICROVOLTS_PER_ADC_UNIT_NUMERATOR +
+			(Remainder * MICROVOLTS_PER_ADC_UNIT_NUMERATOR + Divider / 2) / Divider;
+	int32_t Result = (int32_t)MicroVolts - ADC_OFFSET_IN_MICROVOLTS;
+	if (!FactorsPtr->IsNominalAdcGain){
+		uint32_t Magnitude = (Result < 0)? (uint32_t)(-Result) : (uint32_t)Result;
+		Magnitude = (uint32_t)(((uint64_t)Magnitude * FactorsPtr->AdcGain +
+				(1u << (ADC_FACTOR_FRACTIONAL_BITS - 1))) >> ADC_FACTOR_FRACTIONAL_BITS);
+		Result = (Result < 0)? -(int32_t)Magnitude : (int32_t)Magnitude;
+	}
+	return Result + FactorsPtr->AdcOffset;
+}
+
+/// @brief This function rounds the fixed-point value (in micro-units) to the given number of decimal places
+/// @param MicroUnits value to be rounded
+/// @param Decimals number of decimal places (0 ... MICRO_UNITS_DECIMAL_DIGITS)
+/// @return rounded value expressed in units of 10^-Decimals
+int32_t roundMicroUnits( int32_t MicroUnits, uint8_t Decimals ){
+	if (Decimals >= MICRO_UNITS_DECIMAL_DIGITS){
+		return MicroUnits;
+	}
+	int32_t Divider = PowersOfTen[MICRO_UNITS_DECIMAL_DIGITS - Decimals];
+	if (MicroUnits < 0){
+		return -((-MicroUnits + Divider / 2) / Divider);
+	}
+	return (MicroUnits + Divider / 2) / Divider;
+}
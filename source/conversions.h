@@ -0,0 +1,71 @@
+/// @file conversions.h
+/// @brief This module converts physical quantities to digital values and vice versa
+///
+/// The RP2040 has no floating-point unit, so all conversions are done in integer (fixed-point) arithmetic.
+/// Currents are represented in microamperes and voltages in microvolts (int32_t).
+/// The conversions use the per-channel calibration data (see calibration.h) in the form of precomputed integer factors.
+/// The conversion between microamperes and DAC units is exact in the sense that for every 12-bit DAC value:
+/// convertMicroAmperesToDacValue( Channel, convertDacValueToMicroAmperes( Channel, X )) == X
+
+#ifndef SOURCE_CONVERSIONS_H_
+#define SOURCE_CONVERSIONS_H_
+
+#include <stdint.h>
+#include "config.h"
+#include "calibration.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+#define FULL_SCALE_IN_DAC_UNITS				4095	// 4095 = 0xFFF
+
+/// 4096 DAC units correspond to 20 A, so 1 DAC unit = 20000000/4096 uA = 78125/16 uA (exactly)
+#define MICROAMPERES_PER_DAC_UNIT_NUMERATOR		78125
+#define MICROAMPERES_PER_DAC_UNIT_DENOMINATOR	16
+
+/// Number of decimal digits in the fractional part of the fixed-point representation (micro-units)
+#define MICRO_UNITS_DECIMAL_DIGITS			6
+#define MICRO_UNITS_IN_ONE					1000000
+
+/// The range of the current setpoints (PC command, binary SET_CURRENTS): -10 A ... +10 A
+#define SETPOINT_LIMIT_IN_MICROAMPERES		10000000
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function recalculates the conversion factors of a given channel after a change of its calibration data
+void updateConversionFactors( uint8_t Channel, const ChannelCalibration *CalibrationPtr );
+
+/// @brief This function returns the DAC value corresponding to zero output current of a given channel
+uint16_t getDacZeroOffset( uint8_t Channel );
+
+/// @brief This function converts the current in microamperes to the value for the DAC
+/// The result is rounded to the nearest DAC unit (half away from zero) and clamped to 0 ... FULL_SCALE_IN_DAC_UNITS
+/// @param Channel index of the power supply unit
+/// @param MicroAmperes current (negative or positive)
+/// @return DAC value (including the zero offset of the channel)
+uint16_t convertMicroAmperesToDacValue( uint8_t Channel, int32_t MicroAmperes );
+
+/// @brief This function converts the DAC value to the current in microamperes
+/// The result is rounded to the nearest microampere (half away from zero)
+/// @param Channel index of the power supply unit
+/// @param DacValue DAC value (including the zero offset of the channel)
+/// @return current in microamperes
+int32_t convertDacValueToMicroAmperes( uint8_t Channel, uint16_t DacValue );
+
+/// @brief This function converts the sum of ADC samples to microvolts
+/// @param Channel index of the power supply unit (selects the ADC calibration)
+/// @param Accumulator sum of SamplesNumber 12-bit ADC samples
+/// @param SamplesNumber number of samples in the sum (must be a power of two, not greater than 1024)
+/// @return voltage in microvolts (nominally, the ADC range 0 ... 4096 corresponds to -10 V ... +10 V)
+int32_t convertAdcSumToMicroVolts( uint8_t Channel, uint32_t Accumulator, uint32_t SamplesNumber );
+
+/// @brief This function rounds the fixed-point value (in micro-units) to the given number of decimal places
+/// @param MicroUnits value to be rounded
+/// @param Decimals number of decimal places (0 ... MICRO_UNITS_DECIMAL_DIGITS)
+/// @return rounded value expressed in units of 10^-Decimals
+int32_t roundMicroUnits( int32_t MicroUnits, uint8_t Decimals );
+
+#endif // SOURCE_CONVERSIONS_H_
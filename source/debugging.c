@@ -19,6 +19,9 @@
 
 uint16_t DebugValueWrittenToPCFs, DebugValueWrittenToDac[NUMBER_OF_POWER_SUPPLIES], DebugCounter1, DebugCounter2;
 
+/// The debug output is on; the variable is modified in the main loop and read in the interrupt handlers too
+static atomic_bool IsDebugOutputEnabled;
+
 //---------------------------------------------------------------------------------------------------
 // Function definitions
 //---------------------------------------------------------------------------------------------------
@@ -36,6 +39,7 @@ void initializeDebugDevices(void){
 
 	DebugCounter1 = 0;
 	DebugCounter2 = 0;
+	atomic_store_explicit( &IsDebugOutputEnabled, false, memory_order_relaxed );
 }
 
 bool getPushButtonState(void){
@@ -74,13 +78,35 @@ void changeDebugPin2( bool NewValue ){
 	gpio_put( GPIO_FOR_DEBUG_PIN_2, NewValue );
 }
 
-char* timeTextForDebugging(void){
-	static char TimeText[20];
-	snprintf( TimeText, sizeof(TimeText)-1, "%12lu", time_us_32() );
-	TimeText[10] = 0; // shorten the text
-	TimeText[9] = TimeText[8];
-	TimeText[8] = TimeText[7];
-	TimeText[7] = TimeText[6];
-	TimeText[6] = '.';	// insert a period after full seconds
-	return TimeText;
+/// @brief This function appends the current time (seconds with milliseconds) to a debug line
+void appendTimeForDebugging( TextBuffer *TextPtr ){
+	appendTimestamp( TextPtr, time_us_32() );
+}
+
+/// @brief This function turns the debug output on or off
+void setDebugOutput( bool IsEnabled ){
+	atomic_store_explicit( &IsDebugOutputEnabled, IsEnabled, memory_order_relaxed );
+}
+
+/// @brief This function returns true if the debug output is on
+bool isDebugOutputEnabled(void){
+	return atomic_load_explicit( &IsDebugOutputEnabled, memory_order_relaxed );
+}
+
+/// @brief This function sends the text to the debug console (stdio) without the printf machinery
+void printDebugText( const char *Text ){
+	if (atomic_load_explicit( &IsDebugOutputEnabled, memory_order_relaxed )){
+		fputs( Text, stdout );
+	}
+}
+
+/// @brief This function sends the current time followed by a tab and the text to the debug console
+void printTimedDebugText( const char *Text ){
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	initializeTextBuffer( &Line, DebugLine, sizeof(DebugLine) );
+	appendTimeForDebugging( &Line );
+	appendCharacter( &Line, '\t' );
+	appendText( &Line, Text );
+	printDebugText( DebugLine );
 }
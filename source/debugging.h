@@ -6,8 +6,17 @@
 #define SOURCE_DEBUGGING_H_
 
 #include <stdbool.h>
+#include <stdatomic.h>
 #include "pico/stdlib.h"
 #include "config.h"
+#include "text_format.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+/// The size of the buffers used to build debug lines
+#define DEBUG_LINE_LENGTH		100
 
 //---------------------------------------------------------------------------------------------------
 // Global variables
@@ -33,6 +42,22 @@ void changeDebugPin1( bool NewValue );
 
 void changeDebugPin2( bool NewValue );
 
-char* timeTextForDebugging(void);
+/// @brief This function appends the current time (seconds with milliseconds) to a debug line
+void appendTimeForDebugging( TextBuffer *TextPtr );
+
+/// @brief This function turns the debug output on or off (DBG command; the output is off after reset)
+/// The debug console is the USB port, which also carries a command session; the debug lines would be mixed
+/// with its responses, so they are sent only on request.
+void setDebugOutput( bool IsEnabled );
+
+/// @brief This function returns true if the debug output is on
+bool isDebugOutputEnabled(void);
+
+/// @brief This function sends the text to the debug console (stdio) without the printf machinery
+/// Nothing is sent unless the debug output has been turned on by setDebugOutput.
+void printDebugText( const char *Text );
+
+/// @brief This function sends the current time followed by a tab and the text to the debug console
+void printTimedDebugText( const char *Text );
 
 #endif // SOURCE_DEBUGGING_H_
@@ -0,0 +1,126 @@
+/// @file line_store.h
+/// @brief Double-buffered store of received lines (frames) using C11 atomics.
+/// The filler (e.g. the UART interrupt) assembles a line in one buffer, while the reader (main context)
+/// interprets the previous line in place, in the other buffer; no copy of the line is made.
+/// Assumptions:
+/// - There is one filler and one reader.
+/// - The filler may be an ISR; the reader is main context. If the reader has to change the filler's state
+///   (e.g. to close a line after a period of silence), it must do so with the filler's interrupt disabled.
+/// - A line completed while the reader still holds the previous one is dropped (and counted).
+
+#ifndef LINE_STORE_H_
+#define LINE_STORE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+typedef struct {
+    char *buffers[2];                // storage of the lines
+    uint16_t size;                   // capacity of each buffer
+    uint16_t lengths[2];             // lengths of the completed lines (written by the filler before publishing)
+    uint8_t fill_index;              // buffer being filled (filler only)
+    uint16_t fill_length;            // number of bytes of the line being filled (filler only)
+    atomic_uint_fast8_t published;   // 0: no line for the reader; 1 or 2: index+1 of the line held by the reader
+    atomic_uint_fast32_t dropped;    // number of lines dropped because the reader held the previous one
+} line_store_t;
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief Initialize the line store; both buffers must have Size bytes.
+static inline void lineStoreInit(line_store_t *StorePtr, char *FirstBufferPtr, char *SecondBufferPtr, uint16_t Size){
+    StorePtr->buffers[0] = FirstBufferPtr;
+    StorePtr->buffers[1] = SecondBufferPtr;
+    StorePtr->size = Size;
+    StorePtr->lengths[0] = 0;
+    StorePtr->lengths[1] = 0;
+    StorePtr->fill_index = 0;
+    StorePtr->fill_length = 0;
+    atomic_init(&StorePtr->published, 0u);
+    atomic_init(&StorePtr->dropped, 0u);
+}
+
+/// @brief The function appends a byte to the line being filled
+/// Filler only.
+/// @return true on success
+/// @return false if the buffer is full (the byte is dropped)
+static inline bool lineStoreAppend(line_store_t *StorePtr, char NewCharacter){
+    if (StorePtr->fill_length >= StorePtr->size){
+        return false;
+    }
+    StorePtr->buffers[StorePtr->fill_index][StorePtr->fill_length] = NewCharacter;
+    StorePtr->fill_length++;
+    return true;
+}
+
+/// @brief The function returns the number of bytes of the line being filled
+/// Filler only.
+static inline uint16_t lineStoreLength(const line_store_t *StorePtr){
+    return StorePtr->fill_length;
+}
+
+/// @brief The function returns a byte of the line being filled (Index < lineStoreLength)
+/// Filler only.
+static inline char lineStoreByte(const line_store_t *StorePtr, uint16_t Index){
+    return StorePtr->buffers[StorePtr->fill_index][Index];
+}
+
+/// @brief The function drops the line being filled
+/// Filler only.
+static inline void lineStoreDiscard(line_store_t *StorePtr){
+    StorePtr->fill_length = 0;
+}
+
+/// @brief The function passes the line being filled to the reader and starts a new line in the other buffer
+/// Filler only.
+/// @return true on success
+/// @return false if the reader still holds the previous line (the new line is dropped)
+static inline bool lineStoreComplete(line_store_t *StorePtr){
+    if (0u != atomic_load_explicit(&StorePtr->published, memory_order_acquire)){
+        atomic_fetch_add_explicit(&StorePtr->dropped, 1u, memory_order_relaxed);
+        StorePtr->fill_length = 0;
+        return false;
+    }
+    StorePtr->lengths[StorePtr->fill_index] = StorePtr->fill_length;
+    // publish the line, so the reader can see its bytes and length
+    atomic_store_explicit(&StorePtr->published, (uint_fast8_t)(StorePtr->fill_index + 1u), memory_order_release);
+    StorePtr->fill_index ^= 1u;
+    StorePtr->fill_length = 0;
+    return true;
+}
+
+/// @brief The function gives the reader a view of the completed line (it stays valid until lineStoreRelease)
+/// Reader only.
+/// @return true and stores the pointer and the length of the line on success
+/// @return false if there is no completed line
+static inline bool lineStoreTake(line_store_t *StorePtr, const char **TextPtr, uint16_t *LengthPtr){
+    uint_fast8_t Published = atomic_load_explicit(&StorePtr->published, memory_order_acquire);
+    if (0u == Published){
+        return false;
+    }
+    *TextPtr = StorePtr->buffers[Published - 1u];
+    *LengthPtr = StorePtr->lengths[Published - 1u];
+    return true;
+}
+
+/// @brief The function returns the buffer of the line taken by the reader to the filler
+/// Reader only.
+static inline void lineStoreRelease(line_store_t *StorePtr){
+    atomic_store_explicit(&StorePtr->published, 0u, memory_order_release);
+}
+
+/// @brief The function checks if there is a line for the reader (taken or not)
+/// @return true if there is no completed line
+static inline bool lineStoreIsEmpty(line_store_t *StorePtr){
+    return 0u == atomic_load_explicit(&StorePtr->published, memory_order_acquire);
+}
+
+/// @brief The function returns the number of lines dropped so far
+static inline uint32_t lineStoreDropped(line_store_t *StorePtr){
+    return atomic_load_explicit(&StorePtr->dropped, memory_order_relaxed);
+}
+
+#endif // LINE_STORE_H_
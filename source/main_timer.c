@@ -5,6 +5,7 @@
 #include "adc_inputs.h"
 #include "psu_talks.h"
 #include "writing_to_dac.h"
+#include "trip_monitor.h"
 #include "main_timer.h"
 #include "debugging.h"
 
@@ -43,6 +44,9 @@ static int64_t timerInterruptHandler(alarm_id_t id, void *user_data){
 	if (TimeCounterAdc >= TIME_DIVIDER_ADC){
 		TimeCounterAdc = 0;
 		getVoltageSamples();
+#if ENABLE_TRIP_MONITOR == 1
+		monitorChannelCurrents();
+#endif
 	}
 
 	writeToDacStateMachine();
@@ -0,0 +1,78 @@
+/// @file metrics.c
+
+#include <assert.h>
+#include "metrics.h"
+
+//---------------------------------------------------------------------------------------------------
+// Global constants
+//---------------------------------------------------------------------------------------------------
+
+#define METRICS_DESCRIBE( Id, Name, Kind, Length )	{ Name, Kind, METRIC_##Id, (Length) },
+const MetricDescriptor MetricTable[] = {
+	METRICS_TABLE( METRICS_DESCRIBE )
+};
+#undef METRICS_DESCRIBE
+
+const uint8_t NumberOfMetrics = sizeof(MetricTable)/sizeof(MetricTable[0]);
+
+//---------------------------------------------------------------------------------------------------
+// Local constants
+//---------------------------------------------------------------------------------------------------
+
+/// The upper bounds (in microseconds) of the latency buckets; the last bucket has no bound
+static const uint32_t LatencyBounds[METRICS_LATENCY_BUCKETS-1] = METRICS_LATENCY_BOUNDS;
+
+//---------------------------------------------------------------------------------------------------
+// Global variables
+//---------------------------------------------------------------------------------------------------
+
+atomic_uint_least32_t MetricValues[METRICS_NUMBER_OF_VALUES];
+
+//---------------------------------------------------------------------------------------------------
+// Local variables
+//---------------------------------------------------------------------------------------------------
+
+/// The values of the counters at the last reset (main loop only); 0 for the gauges
+static uint32_t Baselines[METRICS_NUMBER_OF_VALUES];
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function clears all the metrics (at start-up, before the interrupts are enabled)
+void initializeMetrics(void){
+	for (uint16_t J = 0; J < METRICS_NUMBER_OF_VALUES; J++){
+		atomic_store_explicit( &MetricValues[J], 0, memory_order_relaxed );
+		Baselines[J] = 0;
+	}
+}
+
+/// @brief This function starts the counters from 0 again (main loop only); the gauges are kept
+void resetMetrics(void){
+	// the writers keep counting; a counter that wraps around is still right, as the difference is taken modulo 2^32
+	for (uint8_t J = 0; J < NumberOfMetrics; J++){
+		if (METRIC_COUNTER == MetricTable[J].Kind){
+			for (uint16_t K = 0; K < MetricTable[J].Length; K++){
+				uint16_t Index = MetricTable[J].Index + K;
+				Baselines[Index] = (uint32_t)atomic_load_explicit( &MetricValues[Index], memory_order_relaxed );
+			}
+		}
+	}
+}
+
+/// @brief This function returns the value of a counter (since the last reset) or a gauge (main loop only)
+uint32_t getMetric( uint16_t Index ){
+	assert( Index < METRICS_NUMBER_OF_VALUES );
+	return (uint32_t)atomic_load_explicit( &MetricValues[Index], memory_order_relaxed ) - Baselines[Index];
+}
+
+/// @brief This function counts a command and puts its execution time into the latency histogram (main loop only)
+void recordCommand( uint8_t CommandIndex, uint32_t DurationInMicroseconds ){
+	assert( CommandIndex < METRICS_COMMAND_TYPES );
+	uint16_t Bucket = 0;
+	while ((Bucket < METRICS_LATENCY_BUCKETS-1) && (DurationInMicroseconds > LatencyBounds[Bucket])){
+		Bucket++;
+	}
+	incrementMetric( METRIC_COMMANDS + CommandIndex );
+	incrementMetric( METRIC_COMMAND_LATENCY + CommandIndex*METRICS_LATENCY_BUCKETS + Bucket );
+}
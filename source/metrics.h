@@ -0,0 +1,131 @@
+/// @file metrics.h
+/// @brief This module keeps the registry of the health metrics: named 32-bit counters and gauges
+///
+/// The metrics are defined by one table, METRICS_TABLE; a new metric costs one line there. A metric is a single
+/// value or an array (e.g. one counter per channel); all the values are kept in one array, MetricValues,
+/// indexed by METRIC_<Id> (+ the element number).
+/// Every value has a single writer (one interrupt handler or the main loop), so an increment is a load and
+/// a store, without a read-modify-write. The counters are never cleared: the reset (RE command) takes their
+/// present values as the baseline, and getMetric returns the difference. The gauges are set to the present
+/// value of a quantity and are not affected by the reset.
+/// The module uses no hardware, so it can be tested on the host (see tests/test-metrics.c).
+
+#ifndef SOURCE_METRICS_H_
+#define SOURCE_METRICS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "config.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+/// The number of command counters (and latency histograms); not less than the number of RSTL commands
+#define METRICS_COMMAND_TYPES				40
+
+/// The buckets of the latency histograms: up to 20 us, 50 us, 100 us, 500 us, 2 ms and longer
+#define METRICS_LATENCY_BUCKETS				6
+#define METRICS_LATENCY_BOUNDS				{ 20, 50, 100, 500, 2000 }
+
+/// @brief The table of the metrics: METRIC( Id, Name, Kind, Length )
+/// Name is used in the STATS response, Kind is METRIC_COUNTER or METRIC_GAUGE, Length is the number of values.
+/// i2c: bytes written to the PCF8574s, i2cr: writes repeated after an error, i2cs: bytes skipped (no new value),
+/// rx: frames received on UART0, tx: messages queued for transmission, ovf: frames dropped because the main loop
+/// held the previous one, drop: messages rejected (the transmit queue or the output buffer was full),
+/// usbd: messages dropped by the USB link (the host did not read them), baud: the baud rate of UART0,
+/// ramp: ramp steps per channel, cmd: executions of each command of the table,
+/// lat: execution time histogram of each command (METRICS_LATENCY_BUCKETS values per command).
+#define METRICS_TABLE( METRIC ) \
+	METRIC( I2C_TRANSACTIONS,		"i2c",	METRIC_COUNTER,	1 )												\
+	METRIC( I2C_RETRIES,			"i2cr",	METRIC_COUNTER,	1 )												\
+	METRIC( I2C_SKIPPED_BYTES,		"i2cs",	METRIC_COUNTER,	1 )												\
+	METRIC( UART_FRAMES_IN,			"rx",	METRIC_COUNTER,	1 )												\
+	METRIC( UART_FRAMES_OUT,		"tx",	METRIC_COUNTER,	1 )												\
+	METRIC( UART_OVERFLOWS,			"ovf",	METRIC_COUNTER,	1 )												\
+	METRIC( UART_DROPPED_RESPONSES,	"drop",	METRIC_COUNTER,	1 )												\
+	METRIC( USB_DROPPED_MESSAGES,	"usbd",	METRIC_COUNTER,	1 )												\
+	METRIC( UART_BAUD_RATE,			"baud",	METRIC_GAUGE,	1 )												\
+	METRIC( RAMP_STEPS,				"ramp",	METRIC_COUNTER,	NUMBER_OF_POWER_SUPPLIES )						\
+	METRIC( COMMANDS,				"cmd",	METRIC_COUNTER,	METRICS_COMMAND_TYPES )							\
+	METRIC( COMMAND_LATENCY,		"lat",	METRIC_COUNTER,	METRICS_COMMAND_TYPES*METRICS_LATENCY_BUCKETS )
+
+//---------------------------------------------------------------------------------------------------
+// Constants
+//---------------------------------------------------------------------------------------------------
+
+typedef enum {
+	METRIC_COUNTER,				// incremented; the reset starts it from 0
+	METRIC_GAUGE,				// set to the present value; kept by the reset
+} MetricKind;
+
+/// The index of the first value of each metric in MetricValues, and the number of all the values
+#define METRICS_ENUMERATE_INDEX( Id, Name, Kind, Length )	METRIC_##Id, METRIC_##Id##_LAST = METRIC_##Id + (Length) - 1,
+typedef enum {
+	METRICS_TABLE( METRICS_ENUMERATE_INDEX )
+	METRICS_NUMBER_OF_VALUES
+} MetricIndex;
+#undef METRICS_ENUMERATE_INDEX
+
+/// The description of a metric (for the STATS response)
+typedef struct {
+	const char *Name;
+	MetricKind Kind;
+	uint16_t Index;				// the index of its first value in MetricValues
+	uint16_t Length;
+} MetricDescriptor;
+
+//---------------------------------------------------------------------------------------------------
+// Global constants
+//---------------------------------------------------------------------------------------------------
+
+/// The descriptions of the metrics in the order of METRICS_TABLE
+extern const MetricDescriptor MetricTable[];
+
+extern const uint8_t NumberOfMetrics;
+
+//---------------------------------------------------------------------------------------------------
+// Global variables
+//---------------------------------------------------------------------------------------------------
+
+/// The values of all the metrics; written with incrementMetric, addToMetric and setMetric only
+extern atomic_uint_least32_t MetricValues[METRICS_NUMBER_OF_VALUES];
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function increments a counter (by its only writer)
+static inline void incrementMetric( uint16_t Index ){
+	atomic_store_explicit( &MetricValues[Index], atomic_load_explicit( &MetricValues[Index], memory_order_relaxed ) + 1, memory_order_relaxed );
+}
+
+/// @brief This function adds a value to a counter (by its only writer)
+static inline void addToMetric( uint16_t Index, uint32_t Value ){
+	atomic_store_explicit( &MetricValues[Index], atomic_load_explicit( &MetricValues[Index], memory_order_relaxed ) + Value, memory_order_relaxed );
+}
+
+/// @brief This function sets a gauge
+static inline void setMetric( uint16_t Index, uint32_t Value ){
+	atomic_store_explicit( &MetricValues[Index], Value, memory_order_relaxed );
+}
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function clears all the metrics (at start-up, before the interrupts are enabled)
+void initializeMetrics(void);
+
+/// @brief This function starts the counters from 0 again (main loop only); the gauges are kept
+void resetMetrics(void);
+
+/// @brief This function returns the value of a counter (since the last reset) or a gauge (main loop only)
+uint32_t getMetric( uint16_t Index );
+
+/// @brief This function counts a command and puts its execution time into the latency histogram (main loop only)
+/// @param CommandIndex the index of the command in the command table (less than METRICS_COMMAND_TYPES)
+void recordCommand( uint8_t CommandIndex, uint32_t DurationInMicroseconds );
+
+#endif // SOURCE_METRICS_H_
@@ -0,0 +1,130 @@
+/// @file order_queue.c
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "order_queue.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+#define ORDER_QUEUE_MASK				(ORDER_QUEUE_SIZE-1)
+
+static_assert( 0 == (ORDER_QUEUE_SIZE & ORDER_QUEUE_MASK), "static_assert ORDER_QUEUE_SIZE is a power of two" );
+
+//---------------------------------------------------------------------------------------------------
+// Local variables
+//---------------------------------------------------------------------------------------------------
+
+static PsuOrder Orders[ORDER_QUEUE_SIZE];
+
+/// The status of the order with a given sequence number is stored at the index (Sequence & ORDER_QUEUE_MASK)
+static uint8_t Statuses[ORDER_QUEUE_SIZE];
+
+/// Free-running counters: Head is the number of orders pushed (modified in the main loop),
+/// Tail is the number of orders completed (modified in the timer interrupt)
+static atomic_uint_fast32_t Head;
+
+static atomic_uint_fast32_t Tail;
+
+/// Modified and read in the main loop only
+static uint32_t Overflows;
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function empties the queue and clears the counters
+void initializeOrderQueue(void){
+	atomic_store_explicit( &Head, 0, memory_order_relaxed );
+	atomic_store_explicit( &Tail, 0, memory_order_release );
+	Overflows = 0;
+	for (uint8_t J = 0; J < ORDER_QUEUE_SIZE; J++){
+		Statuses[J] = ORDER_STATUS_UNKNOWN;		// no order has been issued
+	}
+}
+
+/// @brief This function checks that the next order can be pushed (main loop only)
+bool reserveOrderSlot(void){
+	uint32_t TemporaryHead = atomic_load_explicit( &Head, memory_order_relaxed );
+	if (TemporaryHead - atomic_load_explicit( &Tail, memory_order_acquire ) >= ORDER_QUEUE_SIZE){
+		Overflows++;
+		return false;
+	}
+	return true;
+}
+
+/// @brief This function appends an order to the queue (main loop only)
+bool pushOrder( uint16_t Code, uint16_t Channel, uint32_t *SequencePtr ){
+	uint32_t TemporaryHead = atomic_load_explicit( &Head, memory_order_relaxed );
+	uint32_t TemporaryTail = atomic_load_explicit( &Tail, memory_order_acquire );
+	if (TemporaryHead - TemporaryTail >= ORDER_QUEUE_SIZE){
+		Overflows++;
+		return false;
+	}
+	PsuOrder *OrderPtr = &Orders[TemporaryHead & ORDER_QUEUE_MASK];
+	OrderPtr->Code = Code;
+	OrderPtr->Channel = Channel;
+	OrderPtr->Sequence = TemporaryHead;
+	Statuses[TemporaryHead & ORDER_QUEUE_MASK] = ORDER_STATUS_PENDING;
+	atomic_store_explicit( &Head, TemporaryHead+1, memory_order_release );	// publishes the order
+	if (NULL != SequencePtr){
+		*SequencePtr = TemporaryHead;
+	}
+	return true;
+}
+
+/// @brief This function returns the status of an order (main loop only)
+OrderStatus getOrderStatus( uint32_t Sequence ){
+	uint32_t TemporaryHead = atomic_load_explicit( &Head, memory_order_relaxed );
+	uint32_t TemporaryTail = atomic_load_explicit( &Tail, memory_order_acquire );
+	if ((TemporaryHead - Sequence - 1) >= ORDER_QUEUE_SIZE){
+		return ORDER_STATUS_UNKNOWN;	// not issued yet or the status has been overwritten
+	}
+	if ((Sequence - TemporaryTail) < ORDER_QUEUE_SIZE){
+		return ORDER_STATUS_PENDING;
+	}
+	return (OrderStatus)Statuses[Sequence & ORDER_QUEUE_MASK];
+}
+
+/// @brief This function returns the number of orders pushed so far (the sequence number of the next order)
+uint32_t getIssuedOrders(void){
+	return atomic_load_explicit( &Head, memory_order_relaxed );
+}
+
+/// @brief This function returns the number of orders completed so far
+uint32_t getCompletedOrders(void){
+	return atomic_load_explicit( &Tail, memory_order_acquire );
+}
+
+/// @brief This function returns the number of orders refused because the queue was full
+uint32_t getOrderQueueOverflows(void){
+	return Overflows;
+}
+
+/// @brief This function copies the oldest order without removing it (timer interrupt only)
+bool peekOrder( PsuOrder *OrderPtr ){
+	uint32_t TemporaryTail = atomic_load_explicit( &Tail, memory_order_relaxed );
+	if (atomic_load_explicit( &Head, memory_order_acquire ) == TemporaryTail){
+		return false;
+	}
+	*OrderPtr = Orders[TemporaryTail & ORDER_QUEUE_MASK];
+	return true;
+}
+
+/// @brief This function removes the oldest order and records its status (timer interrupt only)
+void completeOrder( OrderStatus Status ){
+	uint32_t TemporaryTail = atomic_load_explicit( &Tail, memory_order_relaxed );
+	assert( atomic_load_explicit( &Head, memory_order_acquire ) != TemporaryTail );
+	Statuses[TemporaryTail & ORDER_QUEUE_MASK] = (uint8_t)Status;
+	atomic_store_explicit( &Tail, TemporaryTail+1, memory_order_release );	// publishes the status, frees the slot
+}
+
+/// @brief This function removes all the orders with ORDER_STATUS_DISCARDED (timer interrupt only)
+void discardOrders(void){
+	PsuOrder Order;
+	while (peekOrder( &Order )){
+		completeOrder( ORDER_STATUS_DISCARDED );
+	}
+}
@@ -0,0 +1,79 @@
+/// @file order_queue.h
+/// @brief This module passes the orders from the protocol layer (main loop) to the state machine (timer interrupt)
+///
+/// The queue is a bounded lock-free single-producer single-consumer ring: the orders are pushed only in the main loop
+/// and taken only by the state machine in psu_talks.c. Each order gets a sequence number (the number of orders
+/// pushed before it); the state machine completes the orders in sequence and records their status, so the main loop
+/// can check the status of any of the last ORDER_QUEUE_SIZE orders. A push into the full queue fails and is counted.
+
+#ifndef SOURCE_ORDER_QUEUE_H_
+#define SOURCE_ORDER_QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+#define ORDER_QUEUE_SIZE				8			// must be power-of-two
+
+//---------------------------------------------------------------------------------------------------
+// Constants
+//---------------------------------------------------------------------------------------------------
+
+typedef enum OrderStatusEnum{
+	ORDER_STATUS_PENDING,			// in the queue
+	ORDER_STATUS_EXECUTED,
+	ORDER_STATUS_REJECTED,			// the order does not apply to the state of the state machine
+	ORDER_STATUS_DISCARDED,			// the queue has been flushed (e.g. on a trip)
+	ORDER_STATUS_UNKNOWN,			// the sequence number has not been issued or is too old
+} OrderStatus;
+
+/// The order as seen by the state machine
+typedef struct {
+	uint16_t Code;					// takes values ORDER_COMMAND_...
+	uint16_t Channel;				// index of the channel or a bit mask of channels (ORDER_COMMAND_PC_CHANNELS)
+	uint32_t Sequence;
+} PsuOrder;
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function empties the queue and clears the counters
+void initializeOrderQueue(void);
+
+/// @brief This function checks that the next order can be pushed (main loop only)
+/// The main loop is the only producer, so the space lasts until the next pushOrder.
+/// @return false if the queue is full (the overflow is counted)
+bool reserveOrderSlot(void);
+
+/// @brief This function appends an order to the queue (main loop only)
+/// @param SequencePtr the sequence number of the order is stored here (may be NULL)
+/// @return false if the queue is full (the order is not placed)
+bool pushOrder( uint16_t Code, uint16_t Channel, uint32_t *SequencePtr );
+
+/// @brief This function returns the status of an order (main loop only)
+OrderStatus getOrderStatus( uint32_t Sequence );
+
+/// @brief This function returns the number of orders pushed so far (the sequence number of the next order)
+uint32_t getIssuedOrders(void);
+
+/// @brief This function returns the number of orders completed so far
+uint32_t getCompletedOrders(void);
+
+/// @brief This function returns the number of orders refused because the queue was full
+uint32_t getOrderQueueOverflows(void);
+
+/// @brief This function copies the oldest order without removing it (timer interrupt only)
+/// @return false if the queue is empty
+bool peekOrder( PsuOrder *OrderPtr );
+
+/// @brief This function removes the oldest order and records its status (timer interrupt only)
+void completeOrder( OrderStatus Status );
+
+/// @brief This function removes all the orders with ORDER_STATUS_DISCARDED (timer interrupt only)
+void discardOrders(void);
+
+#endif // SOURCE_ORDER_QUEUE_H_
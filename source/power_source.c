@@ -14,25 +14,29 @@
 /// - Analog voltage measurement (ADC0).
 /// #### 4.   Communication with the main unit via a serial port (UART0).
 /// The communication protocol is implemented in the `rstl_protocol.c` module.
+/// The same commands are accepted via the USB port (a second, independent session for maintenance tools).
 ///
 /// Abbreviations:
 ///   PSU = power source unit;
 ///   FSM = finite state machine
 
 #include <stdbool.h>	// just for Eclipse
-#include <stdio.h>		// just for debugging
 
 #include "pico/stdlib.h"
 #include "hardware/irq.h"
 #include "hardware/timer.h"
 
 #include "uart_talks.h"
+#include "usb_talks.h"
 #include "pwm_output.h"
 #include "psu_talks.h"
 #include "adc_inputs.h"
 #include "i2c_outputs.h"
 #include "main_timer.h"
+#include "calibration.h"
+#include "trip_monitor.h"
 #include "debugging.h"
+#include "metrics.h"
 
 //---------------------------------------------------------------------------------------------------
 // Macro directives
@@ -55,11 +59,15 @@ static void turnOnLedOnBoard(void);
 int main() {
 	stdio_init_all();
 
+	initializeMetrics();
 	serialPortInitialization();
+	usbPortInitialization();
 	initializePwm();
 	initializeI2cOutputs();
+	initializeCalibration();
 	initializePsuTalks();
 	initializeAdcMeasurements();
+	initializeTripMonitor();
 	initializeDebugDevices();
 	initializeRstlProtocol();
 	turnOnLedOnBoard();
@@ -69,9 +77,9 @@ int main() {
 	}
 	startPeriodicInterrupt();
 
-	printf("Hello guys\n");
+	printDebugText( "Hello guys\n" );
 	if (SIMULATE_HARDWARE_PSU == 1){
-		printf("simulation mode\n");
+		printDebugText( "simulation mode\n" );
 	}
 
     while (true) {
@@ -1,12 +1,18 @@
 /// @file psu_talks.c
 
-#include <stdio.h>
 #include <inttypes.h>
 #include <assert.h>
 #include "psu_talks.h"
+#include "seqlock.h"
 #include "rstl_protocol.h"
+#include "order_queue.h"
 #include "writing_to_dac.h"
+#include "conversions.h"
+#include "calibration.h"
+#include "trip_monitor.h"
+#include "adc_inputs.h"
 #include "debugging.h"
+#include "metrics.h"
 
 //---------------------------------------------------------------------------------------------------
 // Macro directives
@@ -19,7 +25,8 @@
 
 /// This constant is used to define the ramp according to which the current changes occur.
 /// The output current changes more slowly in this region:
-/// OFFSET_IN_DAC_UNITS-NEAR_ZERO_REGION_IN_DAC_UNITS ... OFFSET_IN_DAC_UNITS+NEAR_ZERO_REGION_IN_DAC_UNITS
+/// ZeroOffset-NEAR_ZERO_REGION_IN_DAC_UNITS ... ZeroOffset+NEAR_ZERO_REGION_IN_DAC_UNITS
+/// (ZeroOffset is the calibrated DAC value corresponding to zero current, see calibration.h)
 #define NEAR_ZERO_REGION_IN_DAC_UNITS	15
 
 /// This constant defines the maximum rate of change of current
@@ -33,6 +40,10 @@
 /// For RAMP_DELAY==8, one step of the ramp takes 88 ms (11.4 Hz)
 #define RAMP_DELAY						8
 
+/// psuStateMachine is called once per cycle of the lower-level state machine (4 timer interrupts, 600 us each);
+/// in the PSU_RUNNING state each channel is served every NUMBER_OF_POWER_SUPPLIES calls
+#define FSM_CALL_PERIOD_IN_MICROSECONDS	(4*600)
+
 #define ANALOG_SIGNALS_STABILIZATION		480
 #define ANALOG_SIGNALS_LONG_STABILIZATION	(2*ANALOG_SIGNALS_STABILIZATION)
 
@@ -62,6 +73,13 @@ atomic_bool IsMainContactorStateOn;
 /// for two DAC values: 0 and FULL_SCALE_IN_DAC_UNITS; additionally, a flag is used to indicate that the data is valid
 atomic_bool Sig2LastReadings[NUMBER_OF_POWER_SUPPLIES][SIG2_RECORD_SIZE];
 
+/// This array is used to store the last reading of Sig2 for each channel (for the value presently written to the DAC)
+atomic_bool Sig2PresentReading[NUMBER_OF_POWER_SUPPLIES];
+
+/// Bit J is set by the timer interrupt when the ramp of channel J has reached the user's setpoint;
+/// the bits are cleared by the user interface after the notification has been sent
+atomic_uint_fast16_t SettledChannels;
+
 //---------------------------------------------------------------------------------------------------
 // Local variables
 //---------------------------------------------------------------------------------------------------
@@ -69,12 +87,52 @@ atomic_bool Sig2LastReadings[NUMBER_OF_POWER_SUPPLIES][SIG2_RECORD_SIZE];
 // This variable is used only in the timer interrupt
 static uint32_t RampStepDelay[NUMBER_OF_POWER_SUPPLIES];
 
+// This variable is used only in the timer interrupt; true from a new setpoint until the ramp reaches it
+static bool IsRampRunning[NUMBER_OF_POWER_SUPPLIES];
+
 static uint32_t TransitionalDelay;
 
 static uint16_t FsmChannel;
 
 static bool IsInitialCall;
 
+// These variables are used by the zero-current calibration (binary search); only in the timer interrupt
+
+/// Sig2 for this DAC value is the same as for the DAC value 0
+static uint16_t ZeroSearchLow[NUMBER_OF_POWER_SUPPLIES];
+
+/// Sig2 for this DAC value is the same as for the DAC value FULL_SCALE_IN_DAC_UNITS
+static uint16_t ZeroSearchHigh[NUMBER_OF_POWER_SUPPLIES];
+
+/// The DAC value being tested
+static uint16_t ZeroSearchProbe[NUMBER_OF_POWER_SUPPLIES];
+
+static bool Sig2ForZeroDacValue[NUMBER_OF_POWER_SUPPLIES];
+
+static uint64_t ZeroCalibrationStartTime;
+
+/// If true, the DACs are set to the new zero offsets and the calibration ends
+static bool IsZeroCalibrationFinishing;
+
+/// The reports are written in the timer interrupt only in the PSU_CALIBRATION_... states
+static ZeroCalibrationReport ZeroCalibrationReports[NUMBER_OF_POWER_SUPPLIES];
+
+// These variables are used by the fast zeroing after a fault; only in the timer interrupt
+
+/// The channel that tripped; it is zeroed first
+static uint16_t TripZeroingChannel;
+
+/// Number of channels zeroed so far
+static uint16_t TripZeroingCounter;
+
+/// The state published by the timer interrupt (see publishPsuSnapshot); read only through SnapshotLock
+static PsuSnapshot PublishedSnapshot;
+
+static seqlock_t SnapshotLock;
+
+/// Number of snapshot copies repeated because the timer interrupt published a new state meanwhile
+static atomic_uint_fast32_t SnapshotRetries;
+
 //---------------------------------------------------------------------------------------------------
 // Function prototypes
 //---------------------------------------------------------------------------------------------------
@@ -82,16 +140,17 @@ static bool IsInitialCall;
 /// @brief The function calculates the value to be programmed into the DAC in the next step of the ramp.
 /// The current DAC status is represented by PresentValue. The target value set by the user (in DAC units) is given by TargetValue.
 /// The digital value to be programmed into the DAC is in the range 0 ... FULL_SCALE_IN_DAC_UNITS.
-/// The output current of the power supply is zeroed for a setpoint value approximately equal to OFFSET_IN_DAC_UNITS
-/// (you never know exactly what digital value corresponds to analog zero).
+/// The output current of the power supply is zeroed for a setpoint value approximately equal to ZeroOffset
+/// (you never know exactly what digital value corresponds to analog zero; ZeroOffset comes from the calibration data).
 /// The maximum rate of change of the setpoint in DAC units is FAST_RAMP_STEP_IN_DAC_UNITS per cycle period.
-/// Near zero output current (corresponding to the OFFSET_IN_DAC_UNITS value at the DAC input), there is an area of slower changes.
-/// This area extends from -OFFSET_IN_DAC_UNITS + NEAR_ZERO_REGION_IN_DAC_UNITS  to  OFFSET_IN_DAC_UNITS + NEAR_ZERO_REGION_IN_DAC_UNITS.
+/// Near zero output current (corresponding to the ZeroOffset value at the DAC input), there is an area of slower changes.
+/// This area extends from ZeroOffset - NEAR_ZERO_REGION_IN_DAC_UNITS  to  ZeroOffset + NEAR_ZERO_REGION_IN_DAC_UNITS.
 /// In this area, the rate of change of the setpoint (in DAC units) is SLOW_RAMP_STEP_IN_DAC_UNITS for the cycle period.
 /// @param TargetValue user-specified value (in DAC units)
 /// @param PresentValue present value at the DAC input
+/// @param ZeroOffset DAC value corresponding to zero current
 /// @return setpoint value for DAC in the present ramp step
-static uint16_t calculateRampStep( uint16_t TargetValue, uint16_t PresentValue );
+static uint16_t calculateRampStep( uint16_t TargetValue, uint16_t PresentValue, uint16_t ZeroOffset );
 
 static void psuFsmStopped(void);
 static void psuFsmSig2LowSetDac(void);
@@ -103,6 +162,17 @@ static void psuFsmTurnContactorOn(void);
 static void psuFsmRunning(void);
 static void psuFsmShutingDownZeroing(void);
 static void psuFsmShutingDownSwitchOff(void);
+static void psuFsmCalibrationSetDac(void);
+static void psuFsmCalibrationTest(void);
+static void psuFsmTripZeroing(void);
+
+/// @brief This function processes the Sig2 reading for the tested DAC value (one step of the binary search)
+/// @return true if the calibration of the channel is completed
+static bool evaluateZeroSearchStep( uint8_t Channel, bool Sig2Reading );
+
+/// @brief This function gathers the state of all the channels and publishes it for takePsuSnapshot
+/// The function is called only in the timer interrupt (the only writer of PublishedSnapshot).
+static void publishPsuSnapshot(void);
 
 //---------------------------------------------------------------------------------------------------
 // Function definitions
@@ -117,12 +187,21 @@ void initializePsuTalks(void){
 		atomic_store_explicit( &Sig2LastReadings[J][SIG2_FOR_0_DAC_SETTING],          false, memory_order_release );	// anything, but defined
 		atomic_store_explicit( &Sig2LastReadings[J][SIG2_FOR_FULL_SCALE_DAC_SETTING], false, memory_order_release );
 		atomic_store_explicit( &Sig2LastReadings[J][SIG2_IS_VALID_INFORMATION],       false, memory_order_release );
+		atomic_store_explicit( &Sig2PresentReading[J], false, memory_order_release );
+		IsRampRunning[J] = false;
+		ZeroCalibrationReports[J].Status = ZERO_CALIBRATION_NOT_DONE;
 	}
 
+	atomic_store_explicit( &SettledChannels, 0, memory_order_release );
+
 	initializeWritingToDacs();
 
 	IsInitialCall = true;
 
+	seqlockInit( &SnapshotLock );
+	atomic_store_explicit( &SnapshotRetries, 0, memory_order_release );
+	publishPsuSnapshot();
+
     gpio_init(GPIO_FOR_POWER_CONTACTOR);
     gpio_put(GPIO_FOR_POWER_CONTACTOR, false);
     gpio_set_dir(GPIO_FOR_POWER_CONTACTOR, true);  // true = output
@@ -143,7 +222,7 @@ bool getLogicFeedbackFromPsu( void ){
 #if SIMULATE_HARDWARE_PSU == 1
 	uint16_t TemporaryChannel = atomic_load_explicit(&UserSelectedChannel, memory_order_acquire);
 	assert(TemporaryChannel < NUMBER_OF_POWER_SUPPLIES);
-	bool Result = (WrittenToDacValue[TemporaryChannel] >= OFFSET_IN_DAC_UNITS);
+	bool Result = (WrittenToDacValue[TemporaryChannel] >= getDacZeroOffset( TemporaryChannel ));
 	return Result;
 
 #else
@@ -161,6 +240,24 @@ uint16_t psuStateMachine(void){
 	int TemporaryPsuState = atomic_load_explicit( &PsuState, memory_order_acquire );
 	assert( TemporaryPsuState < PSU_ILLEGAL_STATE );
 
+#if ENABLE_TRIP_MONITOR == 1
+	uint16_t TrippedChannel;
+	if (takeTripRequest( &TrippedChannel ) &&
+			((PSU_RUNNING == TemporaryPsuState) || (PSU_SHUTTING_DOWN_ZEROING == TemporaryPsuState)))
+	{
+		// the ramps are abandoned; the pending orders are discarded
+		for (int J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++ ){
+			atomic_store_explicit( &UserSetpointDacValue[J], getDacZeroOffset( J ), memory_order_release );
+			RampStepDelay[J] = 0;
+		}
+		discardOrders();
+		TripZeroingChannel = TrippedChannel;
+		TripZeroingCounter = 0;
+		TemporaryPsuState = PSU_TRIP_ZEROING;
+		atomic_store_explicit( &PsuState, PSU_TRIP_ZEROING, memory_order_release );
+	}
+#endif
+
 	switch( TemporaryPsuState ){
 	case PSU_STOPPED:
 		psuFsmStopped();
@@ -202,6 +299,18 @@ uint16_t psuStateMachine(void){
 		psuFsmShutingDownSwitchOff();
 		break;
 
+	case PSU_CALIBRATION_SET_DAC:
+		psuFsmCalibrationSetDac();
+		break;
+
+	case PSU_CALIBRATION_TEST:
+		psuFsmCalibrationTest();
+		break;
+
+	case PSU_TRIP_ZEROING:
+		psuFsmTripZeroing();
+		break;
+
 	default:
 
 	}
@@ -210,13 +319,20 @@ uint16_t psuStateMachine(void){
 	static int OldPsuState;
 	TemporaryPsuState = atomic_load_explicit( &PsuState, memory_order_acquire );
 	if (TemporaryPsuState != OldPsuState){
-		printf( "%s\tstate %d -> %d\n",
-				timeTextForDebugging(),
-				OldPsuState,
-				TemporaryPsuState );
+		char DebugLine[DEBUG_LINE_LENGTH];
+		TextBuffer Line;
+		initializeTextBuffer( &Line, DebugLine, sizeof(DebugLine) );
+		appendTimeForDebugging( &Line );
+		appendText( &Line, "\tstate " );
+		appendSigned( &Line, OldPsuState );
+		appendText( &Line, " -> " );
+		appendUnsigned( &Line, TemporaryPsuState );
+		appendText( &Line, "\n" );
+		printDebugText( DebugLine );
 		OldPsuState = TemporaryPsuState;
 	}
 #endif
+	publishPsuSnapshot();
 	return FsmChannel;
 }
 
@@ -235,17 +351,34 @@ static void psuFsmStopped(void){
 		FsmChannel = 0;
 	}
 
-	// orders
-	uint16_t TemporaryOrderCode = atomic_load_explicit( &OrderCode, memory_order_acquire );
-	assert( TemporaryOrderCode < ORDER_COMMAND_ILLEGAL_CODE );
-	assert( TemporaryOrderCode >= ORDER_NONE );
+	// orders; the orders that do not apply to the stopped state (e.g. left by a trip) are rejected
+	PsuOrder Order;
+	if (peekOrder( &Order )){
+		assert( Order.Code < ORDER_COMMAND_ILLEGAL_CODE );
+		assert( Order.Code > ORDER_NONE );
 
-	if (TemporaryOrderCode > ORDER_ACCEPTED){
-		if (ORDER_COMMAND_POWER_UP == TemporaryOrderCode){
-			atomic_store_explicit( &OrderCode, ORDER_ACCEPTED, memory_order_release );
+		if (ORDER_COMMAND_POWER_UP == Order.Code){
+			completeOrder( ORDER_STATUS_EXECUTED );
 			atomic_store_explicit( &PsuState, PSU_INITIAL_SIG2_LOW_SET_DAC, memory_order_release );
 			IsInitialCall = true;
 		}
+		else if (ORDER_COMMAND_CALIBRATE_ZERO == Order.Code){
+			for (int J=0; J < NUMBER_OF_INSTALLED_PSU; J++ ){
+				ZeroCalibrationReports[J].Status = ZERO_CALIBRATION_RUNNING;
+				ZeroCalibrationReports[J].ZeroOffset = getDacZeroOffset( J );
+				ZeroCalibrationReports[J].DacWrites = 0;
+				ZeroCalibrationReports[J].DurationInMilliseconds = 0;
+				ZeroSearchProbe[J] = 0;		// the first step: Sig2 for DAC value 0
+			}
+			ZeroCalibrationStartTime = time_us_64();
+			IsZeroCalibrationFinishing = false;
+			completeOrder( ORDER_STATUS_EXECUTED );
+			atomic_store_explicit( &PsuState, PSU_CALIBRATION_SET_DAC, memory_order_release );
+			IsInitialCall = true;
+		}
+		else{
+			completeOrder( ORDER_STATUS_REJECTED );
+		}
 	}
 }
 
@@ -378,9 +511,11 @@ static void psuFsmZeroing(void){
 	else{
 		FsmChannel++;
 	}
-	// continue preparatory activities for switching on the contactor:  set DACs to the maximum
+	// continue preparatory activities for switching on the contactor:  set DACs to zero current
 	if (FsmChannel < NUMBER_OF_INSTALLED_PSU){
-		InstantaneousSetpointDacValue[FsmChannel] = OFFSET_IN_DAC_UNITS;
+		// the zero offset might have been changed by the calibration since the last run
+		atomic_store_explicit( &UserSetpointDacValue[FsmChannel], getDacZeroOffset( FsmChannel ), memory_order_release );
+		InstantaneousSetpointDacValue[FsmChannel] = getDacZeroOffset( FsmChannel );
 		WriteToDacDataReady[FsmChannel] = true;
 		RampStepDelay[FsmChannel] = 0;
 	}
@@ -405,25 +540,35 @@ static void psuFsmTurnContactorOn(void){
 		assert( false == PhysicalValue );
 		(void)PhysicalValue; // So that the compiler doesn't complain
 
-		printf( "Sig2LastReadings:%s\n", convertSig2TableToText());
+		printDebugText( "Sig2LastReadings:" );
+		printDebugText( convertSig2TableToText() );
+		printDebugText( "\n" );
 
 		for (int J=0; J < NUMBER_OF_INSTALLED_PSU; J++ ){
-			if (OFFSET_IN_DAC_UNITS != WrittenToDacValue[J]){
+			if (getDacZeroOffset( J ) != WrittenToDacValue[J]){
 				// something went wrong
 				for (int J=0; J < NUMBER_OF_POWER_SUPPLIES; J++ ){
 					WriteToDacDataReady[J] = false;
 				}
 				atomic_store_explicit( &PsuState, PSU_STOPPED, memory_order_release );
 				IsInitialCall = true;
-				printf("\nInternal error in %s at line %d\n", __FILE__, __LINE__);
+				char DebugLine[DEBUG_LINE_LENGTH];
+				TextBuffer Line;
+				initializeTextBuffer( &Line, DebugLine, sizeof(DebugLine) );
+				appendText( &Line, "\nInternal error in " __FILE__ " at line " );
+				appendUnsigned( &Line, __LINE__ );
+				appendText( &Line, "\n" );
+				printDebugText( DebugLine );
 				return;
 			}
 		}
+		for (int J=0; J < NUMBER_OF_POWER_SUPPLIES; J++ ){
+			IsRampRunning[J] = false;
+		}
 		atomic_store_explicit( &IsMainContactorStateOn, true, memory_order_release );
 		setMainContactorState( true );
 
-		printf( "%s\tmain contactor switched on\n",
-				timeTextForDebugging());
+		printTimedDebugText( "main contactor switched on\n" );
 
 		atomic_store_explicit( &PsuState, PSU_RUNNING, memory_order_release );
 		IsInitialCall = true;
@@ -447,6 +592,11 @@ static void psuFsmRunning(void){
 		// there is nothing to do
 		WriteToDacDataReady[FsmChannel] = false;
 		RampStepDelay[FsmChannel] = 0;
+		if (IsRampRunning[FsmChannel]){
+			// the setpoint has just been reached
+			IsRampRunning[FsmChannel] = false;
+			atomic_fetch_or_explicit( &SettledChannels, 1u << FsmChannel, memory_order_acq_rel );
+		}
 	}
 	else{
 		// the step continuation
@@ -458,49 +608,64 @@ static void psuFsmRunning(void){
 			// next ramp step
 			InstantaneousSetpointDacValue[FsmChannel] =
 					calculateRampStep( atomic_load_explicit( &UserSetpointDacValue[FsmChannel], memory_order_acquire ),
-							WrittenToDacValue[FsmChannel] );
+							WrittenToDacValue[FsmChannel], getDacZeroOffset( FsmChannel ) );
 			WriteToDacDataReady[FsmChannel] = true;
 			RampStepDelay[FsmChannel] = RAMP_DELAY;
+			incrementMetric( METRIC_RAMP_STEPS + FsmChannel );
+			IsRampRunning[FsmChannel] = true;
 		}
 	}
 
-	// orders
-	uint16_t TemporaryOrderCode = atomic_load_explicit( &OrderCode, memory_order_acquire );
-	assert( TemporaryOrderCode < ORDER_COMMAND_ILLEGAL_CODE );
-	assert( TemporaryOrderCode >= ORDER_NONE );
-
-	int TemporaryUserSelectedChannel = -1;
-
-	if (TemporaryOrderCode > ORDER_ACCEPTED){
-		TemporaryUserSelectedChannel = atomic_load_explicit(&OrderChannel, memory_order_acquire);
-		assert( TemporaryUserSelectedChannel >= 0 );
-		assert( TemporaryUserSelectedChannel < NUMBER_OF_POWER_SUPPLIES );
-		// There is a new order
-
-		if (ORDER_COMMAND_PCI == TemporaryOrderCode){
-			InstantaneousSetpointDacValue[TemporaryUserSelectedChannel] = atomic_load_explicit( &UserSetpointDacValue[TemporaryUserSelectedChannel], memory_order_acquire );
-			RampStepDelay[TemporaryUserSelectedChannel] = RAMP_DELAY;
-			atomic_store_explicit( &OrderCode, ORDER_ACCEPTED, memory_order_release );
+	// orders; the ramp orders are taken together (they are accepted back to back), power down ends the running state
+	PsuOrder Order;
+	while (peekOrder( &Order )){
+		assert( Order.Code < ORDER_COMMAND_ILLEGAL_CODE );
+		assert( Order.Code > ORDER_NONE );
+
+		if (ORDER_COMMAND_PC_CHANNELS == Order.Code){
+			// Program Current (following ramp) in several channels; Order.Channel is a bit mask of the channels
+			assert( 0 == (Order.Channel >> NUMBER_OF_POWER_SUPPLIES) );
+			for (int J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++ ){
+				if (0 != (Order.Channel & (1u << J))){
+					InstantaneousSetpointDacValue[J] =
+							calculateRampStep( atomic_load_explicit( &UserSetpointDacValue[J], memory_order_acquire ),
+									WrittenToDacValue[J], getDacZeroOffset( J ) );
+					RampStepDelay[J] = RAMP_DELAY;
+					IsRampRunning[J] = true;
+				}
+			}
+			completeOrder( ORDER_STATUS_EXECUTED );
 		}
-
-		if (ORDER_COMMAND_PC == TemporaryOrderCode){
-			InstantaneousSetpointDacValue[TemporaryUserSelectedChannel] =
-					calculateRampStep( atomic_load_explicit( &UserSetpointDacValue[TemporaryUserSelectedChannel], memory_order_acquire ),
-							WrittenToDacValue[TemporaryUserSelectedChannel] );
-			RampStepDelay[TemporaryUserSelectedChannel] = RAMP_DELAY;
-			atomic_store_explicit( &OrderCode, ORDER_ACCEPTED, memory_order_release );
+		else if (ORDER_COMMAND_PCI == Order.Code){
+			assert( Order.Channel < NUMBER_OF_POWER_SUPPLIES );
+			InstantaneousSetpointDacValue[Order.Channel] = atomic_load_explicit( &UserSetpointDacValue[Order.Channel], memory_order_acquire );
+			RampStepDelay[Order.Channel] = RAMP_DELAY;
+			IsRampRunning[Order.Channel] = true;
+			completeOrder( ORDER_STATUS_EXECUTED );
 		}
-
-		if (ORDER_COMMAND_POWER_DOWN == TemporaryOrderCode){
+		else if (ORDER_COMMAND_PC == Order.Code){
+			assert( Order.Channel < NUMBER_OF_POWER_SUPPLIES );
+			InstantaneousSetpointDacValue[Order.Channel] =
+					calculateRampStep( atomic_load_explicit( &UserSetpointDacValue[Order.Channel], memory_order_acquire ),
+							WrittenToDacValue[Order.Channel], getDacZeroOffset( Order.Channel ) );
+			RampStepDelay[Order.Channel] = RAMP_DELAY;
+			IsRampRunning[Order.Channel] = true;
+			completeOrder( ORDER_STATUS_EXECUTED );
+		}
+		else if (ORDER_COMMAND_POWER_DOWN == Order.Code){
 			for (int J = 0; J < NUMBER_OF_INSTALLED_PSU; J++ ){
-				atomic_store_explicit( &UserSetpointDacValue[J], OFFSET_IN_DAC_UNITS, memory_order_release );
-				InstantaneousSetpointDacValue[J] = calculateRampStep( OFFSET_IN_DAC_UNITS, WrittenToDacValue[J] );
+				atomic_store_explicit( &UserSetpointDacValue[J], getDacZeroOffset( J ), memory_order_release );
+				InstantaneousSetpointDacValue[J] = calculateRampStep( getDacZeroOffset( J ), WrittenToDacValue[J], getDacZeroOffset( J ) );
 				RampStepDelay[J] = RAMP_DELAY;
 			}
-			atomic_store_explicit( &OrderCode, ORDER_ACCEPTED, memory_order_release );
+			completeOrder( ORDER_STATUS_EXECUTED );
 			atomic_store_explicit( &PsuState, PSU_SHUTTING_DOWN_ZEROING, memory_order_release );
 			IsInitialCall = true;
 			FsmChannel = 0;
+			break;	// the next orders are taken in the next states
+		}
+		else{
+			completeOrder( ORDER_STATUS_REJECTED );
 		}
 	}
 }
@@ -518,12 +683,12 @@ static void psuFsmShutingDownZeroing(void){
 		FsmChannel = 0;
 	}
 
-	if (OFFSET_IN_DAC_UNITS == WrittenToDacValue[FsmChannel]){
+	if (getDacZeroOffset( FsmChannel ) == WrittenToDacValue[FsmChannel]){
 		WriteToDacDataReady[FsmChannel] = false;
 		RampStepDelay[FsmChannel] = 0;
 
 		for (int J = 0; J < NUMBER_OF_INSTALLED_PSU; J++ ){
-			if (OFFSET_IN_DAC_UNITS != WrittenToDacValue[J]){
+			if (getDacZeroOffset( J ) != WrittenToDacValue[J]){
 				// other channel is continuing its ramp
 				return;
 			}
@@ -547,9 +712,10 @@ static void psuFsmShutingDownZeroing(void){
 		else{
 			// next ramp step
 			InstantaneousSetpointDacValue[FsmChannel] =
-					calculateRampStep( OFFSET_IN_DAC_UNITS, WrittenToDacValue[FsmChannel] );
+					calculateRampStep( getDacZeroOffset( FsmChannel ), WrittenToDacValue[FsmChannel], getDacZeroOffset( FsmChannel ) );
 			WriteToDacDataReady[FsmChannel] = true;
 			RampStepDelay[FsmChannel] = RAMP_DELAY;
+			incrementMetric( METRIC_RAMP_STEPS + FsmChannel );
 		}
 	}
 }
@@ -567,25 +733,179 @@ static void psuFsmShutingDownSwitchOff(void){
 		atomic_store_explicit( &IsMainContactorStateOn, false, memory_order_release );
 		setMainContactorState( false );
 
-		printf( "%s\tmain contactor switched off\n",
-				timeTextForDebugging());
+		printTimedDebugText( "main contactor switched off\n" );
 
 		atomic_store_explicit( &PsuState, PSU_STOPPED, memory_order_release );
 		IsInitialCall = true;
 	}
 }
 
-static uint16_t calculateRampStep( uint16_t TargetValue, uint16_t PresentValue ){
+static void psuFsmCalibrationSetDac(void){
+	assert( false == atomic_load_explicit( &IsMainContactorStateOn, memory_order_acquire ));
+	bool PhysicalValue = gpio_get(GPIO_FOR_POWER_CONTACTOR);
+	assert( false == PhysicalValue );
+	(void)PhysicalValue; // So that the compiler doesn't complain
+
+	if (IsInitialCall){
+		IsInitialCall = false;
+		FsmChannel = 0;
+	}
+	else{
+		FsmChannel++;
+	}
+
+	if (FsmChannel < NUMBER_OF_INSTALLED_PSU){
+		if (IsZeroCalibrationFinishing){
+			// leave the DAC at the (new) zero-current value
+			InstantaneousSetpointDacValue[FsmChannel] = getDacZeroOffset( FsmChannel );
+			WriteToDacDataReady[FsmChannel] = true;
+		}
+		else if (ZERO_CALIBRATION_RUNNING == ZeroCalibrationReports[FsmChannel].Status){
+			InstantaneousSetpointDacValue[FsmChannel] = ZeroSearchProbe[FsmChannel];
+			WriteToDacDataReady[FsmChannel] = true;
+		}
+		else{
+			WriteToDacDataReady[FsmChannel] = false;
+		}
+		RampStepDelay[FsmChannel] = 0;
+	}
+	else{
+		for (int J=0; J < NUMBER_OF_INSTALLED_PSU; J++ ){
+			WriteToDacDataReady[J] = false;
+		}
+		if (IsZeroCalibrationFinishing){
+			printTimedDebugText( "zero calibration completed\n" );
+			atomic_store_explicit( &PsuState, PSU_STOPPED, memory_order_release );
+		}
+		else{
+			atomic_store_explicit( &PsuState, PSU_CALIBRATION_TEST, memory_order_release );
+			TransitionalDelay = ANALOG_SIGNALS_STABILIZATION;
+		}
+		IsInitialCall = true;
+		FsmChannel = 0;
+	}
+}
+
+static void psuFsmCalibrationTest(void){
+	if (0 != TransitionalDelay){
+		TransitionalDelay--;
+	}
+	else{
+		if (IsInitialCall){
+			IsInitialCall = false;
+			FsmChannel = 0;
+		}
+		else{
+			FsmChannel++;
+		}
+		if (FsmChannel < NUMBER_OF_INSTALLED_PSU){
+			// write down the same, in order to update the Sig2 reading
+			WriteToDacDataReady[FsmChannel] = (ZERO_CALIBRATION_RUNNING == ZeroCalibrationReports[FsmChannel].Status);
+		}
+		else{
+			// all the Sig2 readings are up to date
+			bool IsCompleted = true;
+			for (int J=0; J < NUMBER_OF_INSTALLED_PSU; J++ ){
+				if (ZERO_CALIBRATION_RUNNING == ZeroCalibrationReports[J].Status){
+					if (!evaluateZeroSearchStep( J, atomic_load_explicit( &Sig2PresentReading[J], memory_order_acquire ))){
+						IsCompleted = false;
+					}
+				}
+				WriteToDacDataReady[J] = false;
+			}
+			if (IsCompleted){
+				for (int J=0; J < NUMBER_OF_INSTALLED_PSU; J++ ){
+					if (ZERO_CALIBRATION_CONVERGED == ZeroCalibrationReports[J].Status){
+						setDacZeroOffset( J, ZeroCalibrationReports[J].ZeroOffset );
+					}
+				}
+				IsZeroCalibrationFinishing = true;
+			}
+			atomic_store_explicit( &PsuState, PSU_CALIBRATION_SET_DAC, memory_order_release );
+			IsInitialCall = true;
+			FsmChannel = 0;
+		}
+	}
+}
+
+static void psuFsmTripZeroing(void){
+	// all DACs are set to zero current at once, without the ramp; the tripped channel goes first
+	if (TripZeroingCounter < NUMBER_OF_INSTALLED_PSU){
+		FsmChannel = (TripZeroingChannel + TripZeroingCounter) % NUMBER_OF_INSTALLED_PSU;
+		TripZeroingCounter++;
+		InstantaneousSetpointDacValue[FsmChannel] = getDacZeroOffset( FsmChannel );
+		WriteToDacDataReady[FsmChannel] = true;
+	}
+	else{
+		// the contactor is switched off in the usual way
+		atomic_store_explicit( &PsuState, PSU_SHUTTING_DOWN_ZEROING, memory_order_release );
+		IsInitialCall = true;
+		FsmChannel = 0;
+	}
+}
+
+static bool evaluateZeroSearchStep( uint8_t Channel, bool Sig2Reading ){
+	ZeroCalibrationReport *ReportPtr = &ZeroCalibrationReports[Channel];
+	ReportPtr->DacWrites++;
+
+	if (1 == ReportPtr->DacWrites){
+		// Sig2 for DAC value 0 has been read; now read it for the full scale
+		Sig2ForZeroDacValue[Channel] = Sig2Reading;
+		ZeroSearchProbe[Channel] = FULL_SCALE_IN_DAC_UNITS;
+		return false;
+	}
+	if (2 == ReportPtr->DacWrites){
+		if (Sig2Reading == Sig2ForZeroDacValue[Channel]){
+			// no transition of Sig2 in the whole range
+			ReportPtr->Status = ZERO_CALIBRATION_FAILED;
+			ReportPtr->DurationInMilliseconds = (uint32_t)((time_us_64() - ZeroCalibrationStartTime) / 1000);
+			return true;
+		}
+		ZeroSearchLow[Channel] = 0;
+		ZeroSearchHigh[Channel] = FULL_SCALE_IN_DAC_UNITS;
+	}
+	else{
+		if (Sig2Reading == Sig2ForZeroDacValue[Channel]){
+			ZeroSearchLow[Channel] = ZeroSearchProbe[Channel];
+		}
+		else{
+			ZeroSearchHigh[Channel] = ZeroSearchProbe[Channel];
+		}
+	}
+
+	if (ZeroSearchHigh[Channel] - ZeroSearchLow[Channel] <= 1){
+		ReportPtr->ZeroOffset = ZeroSearchHigh[Channel];
+		ReportPtr->Status = ZERO_CALIBRATION_CONVERGED;
+		ReportPtr->DurationInMilliseconds = (uint32_t)((time_us_64() - ZeroCalibrationStartTime) / 1000);
+		char DebugLine[DEBUG_LINE_LENGTH];
+		TextBuffer Line;
+		initializeTextBuffer( &Line, DebugLine, sizeof(DebugLine) );
+		appendTimeForDebugging( &Line );
+		appendText( &Line, "\tzero calibration ch=" );
+		appendUnsigned( &Line, (uint32_t)Channel+1 );
+		appendCharacter( &Line, '\t' );
+		appendUnsigned( &Line, ReportPtr->ZeroOffset );
+		appendCharacter( &Line, '\t' );
+		appendUnsigned( &Line, ReportPtr->DacWrites );
+		appendText( &Line, "\n" );
+		printDebugText( DebugLine );
+		return true;
+	}
+	ZeroSearchProbe[Channel] = (ZeroSearchLow[Channel] + ZeroSearchHigh[Channel]) / 2;
+	return false;
+}
+
+static uint16_t calculateRampStep( uint16_t TargetValue, uint16_t PresentValue, uint16_t ZeroOffset ){
 	uint16_t TemporaryRequiredDacValue = TargetValue;
 	uint16_t RampStep = FAST_RAMP_STEP_IN_DAC_UNITS;
 
 	// Deal with the area near zero current.
-	if (PresentValue > (OFFSET_IN_DAC_UNITS + NEAR_ZERO_REGION_IN_DAC_UNITS)){
-		if (TargetValue < (OFFSET_IN_DAC_UNITS + NEAR_ZERO_REGION_IN_DAC_UNITS)){
+	if (PresentValue > (ZeroOffset + NEAR_ZERO_REGION_IN_DAC_UNITS)){
+		if (TargetValue < (ZeroOffset + NEAR_ZERO_REGION_IN_DAC_UNITS)){
 			//			        <---------------<                   the arrow indicates the present value and the user-specified setpoint value
 			//					   |     <------<
 			//			-----------|---0---|----------------> I
-			TemporaryRequiredDacValue = (OFFSET_IN_DAC_UNITS + NEAR_ZERO_REGION_IN_DAC_UNITS);	// The ramp will be fast, but possibly shortened
+			TemporaryRequiredDacValue = (ZeroOffset + NEAR_ZERO_REGION_IN_DAC_UNITS);	// The ramp will be fast, but possibly shortened
 		}
 		else{
 			//			           |       |   <--------<
@@ -595,12 +915,12 @@ static uint16_t calculateRampStep( uint16_t TargetValue, uint16_t PresentValue )
 			// do nothing
 		}
 	}
-	else if (PresentValue < (OFFSET_IN_DAC_UNITS - NEAR_ZERO_REGION_IN_DAC_UNITS)){
-		if (TargetValue   > (OFFSET_IN_DAC_UNITS - NEAR_ZERO_REGION_IN_DAC_UNITS)){
+	else if (PresentValue < (ZeroOffset - NEAR_ZERO_REGION_IN_DAC_UNITS)){
+		if (TargetValue   > (ZeroOffset - NEAR_ZERO_REGION_IN_DAC_UNITS)){
 			//				  >--------------->
 			//			      >--------->  |
 			//			-----------|---0---|----------------> I
-			TemporaryRequiredDacValue = (OFFSET_IN_DAC_UNITS - NEAR_ZERO_REGION_IN_DAC_UNITS);	// The ramp will be fast, but possibly shortened
+			TemporaryRequiredDacValue = (ZeroOffset - NEAR_ZERO_REGION_IN_DAC_UNITS);	// The ramp will be fast, but possibly shortened
 		}
 		else{
 			//			 <------<  |       |
@@ -611,16 +931,16 @@ static uint16_t calculateRampStep( uint16_t TargetValue, uint16_t PresentValue )
 		}
 	}
 	else{
-		if ((PresentValue <= (OFFSET_IN_DAC_UNITS + NEAR_ZERO_REGION_IN_DAC_UNITS)) &&
-				(TargetValue > (OFFSET_IN_DAC_UNITS + NEAR_ZERO_REGION_IN_DAC_UNITS)))
+		if ((PresentValue <= (ZeroOffset + NEAR_ZERO_REGION_IN_DAC_UNITS)) &&
+				(TargetValue > (ZeroOffset + NEAR_ZERO_REGION_IN_DAC_UNITS)))
 		{
 			//			           |     >----->
 			//			           |       >--->
 			//			-----------|---0---|----------------> I
 			RampStep = SLOW_RAMP_STEP_IN_DAC_UNITS; // slow down
 		}
-		else if ((PresentValue >= (OFFSET_IN_DAC_UNITS - NEAR_ZERO_REGION_IN_DAC_UNITS)) &&
-				(TargetValue < (OFFSET_IN_DAC_UNITS - NEAR_ZERO_REGION_IN_DAC_UNITS)))
+		else if ((PresentValue >= (ZeroOffset - NEAR_ZERO_REGION_IN_DAC_UNITS)) &&
+				(TargetValue < (ZeroOffset - NEAR_ZERO_REGION_IN_DAC_UNITS)))
 		{
 			//			      <------<     |
 			//			      <----<       |
@@ -673,3 +993,84 @@ char* convertSig2TableToText(void){
 	Sig2Table[3*NUMBER_OF_POWER_SUPPLIES]   = 0; // termination character
 	return Sig2Table;
 }
+
+/// @brief This function copies the result of the last zero-current calibration of a given channel
+/// @return false if the calibration is running (the copy is not made)
+bool getZeroCalibrationReport( uint8_t Channel, ZeroCalibrationReport *ReportPtr ){
+	uint16_t TemporaryPsuState = atomic_load_explicit( &PsuState, memory_order_acquire );
+	if ((PSU_CALIBRATION_SET_DAC == TemporaryPsuState) || (PSU_CALIBRATION_TEST == TemporaryPsuState) ||
+			(Channel >= NUMBER_OF_POWER_SUPPLIES))
+	{
+		return false;
+	}
+	*ReportPtr = ZeroCalibrationReports[Channel];
+	return true;
+}
+
+/// @brief This function copies the state of all the channels, the FSM state and the error counters
+void takePsuSnapshot( PsuSnapshot *SnapshotPtr ){
+	// the copy is repeated if the timer interrupt publishes a new state in the meantime;
+	// the interrupts stay enabled
+	uint32_t Retries = seqlockRead( &SnapshotLock, SnapshotPtr, &PublishedSnapshot, sizeof(PublishedSnapshot) );
+	if (Retries > 0){
+		atomic_fetch_add_explicit( &SnapshotRetries, Retries, memory_order_relaxed );
+	}
+	// the error flags and counters are read directly: they can be cleared by resetErrors in the main loop,
+	// and "RE;ST" must not report the values from before the reset (the snapshot may be up to 2.4 ms old)
+	SnapshotPtr->UartError = (uint16_t)atomic_load_explicit( &UartError, memory_order_acquire );
+	SnapshotPtr->I2cConsecutiveErrors = (uint16_t)atomic_load_explicit( &I2cConsecutiveErrors, memory_order_acquire );
+	SnapshotPtr->I2cMaxConsecutiveErrors = (uint16_t)atomic_load_explicit( &I2cMaxConsecutiveErrors, memory_order_acquire );
+}
+
+/// @brief This function returns the number of snapshot copies repeated so far
+uint32_t getSnapshotRetries(void){
+	return atomic_load_explicit( &SnapshotRetries, memory_order_relaxed );
+}
+
+static void publishPsuSnapshot(void){
+	// the new state is gathered outside the lock, so the window in which the readers have to retry is short
+	PsuSnapshot Snapshot;
+	Snapshot.PsuState = (uint16_t)atomic_load_explicit( &PsuState, memory_order_relaxed );
+	Snapshot.IsPowerOn = atomic_load_explicit( &IsMainContactorStateOn, memory_order_relaxed );
+	Snapshot.UartError = (uint16_t)atomic_load_explicit( &UartError, memory_order_relaxed );
+	Snapshot.I2cConsecutiveErrors = (uint16_t)atomic_load_explicit( &I2cConsecutiveErrors, memory_order_relaxed );
+	Snapshot.I2cMaxConsecutiveErrors = (uint16_t)atomic_load_explicit( &I2cMaxConsecutiveErrors, memory_order_relaxed );
+	for (int J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++ ){
+		Snapshot.UserSetpointDacValue[J] = (uint16_t)atomic_load_explicit( &UserSetpointDacValue[J], memory_order_relaxed );
+		Snapshot.InstantaneousSetpointDacValue[J] = InstantaneousSetpointDacValue[J];
+		Snapshot.WrittenToDacValue[J] = WrittenToDacValue[J];
+		Snapshot.MeasuredMicroVolts[J] = getVoltage( J );
+		for (int K = 0; K < SIG2_RECORD_SIZE; K++ ){
+			Snapshot.Sig2LastReadings[J][K] = atomic_load_explicit( &Sig2LastReadings[J][K], memory_order_relaxed );
+		}
+		Snapshot.Sig2PresentReading[J] = atomic_load_explicit( &Sig2PresentReading[J], memory_order_relaxed );
+		Snapshot.IsRampRunning[J] = IsRampRunning[J];
+	}
+	seqlockWrite( &SnapshotLock, &PublishedSnapshot, &Snapshot, sizeof(Snapshot) );
+}
+
+/// @brief This function estimates the time remaining until the ramp of a given channel reaches the user's setpoint
+/// The remaining ramp steps are counted with the same function that the state machine uses (calculateRampStep),
+/// so the slow region near zero current is taken into account. The function is called in the main loop;
+/// the ramp may advance by one step during the calculation, which is acceptable for an estimate.
+/// @return time in milliseconds (0 if the setpoint has been reached)
+uint32_t getRampRemainingTime( uint8_t Channel ){
+	if (Channel >= NUMBER_OF_POWER_SUPPLIES){
+		return 0;
+	}
+	uint16_t TargetValue = atomic_load_explicit( &UserSetpointDacValue[Channel], memory_order_acquire );
+	uint16_t PresentValue = WrittenToDacValue[Channel];
+	uint16_t ZeroOffset = getDacZeroOffset( Channel );
+	uint32_t RampSteps = 0;
+
+	while ((PresentValue != TargetValue) && (RampSteps <= FULL_SCALE_IN_DAC_UNITS)){
+		PresentValue = calculateRampStep( TargetValue, PresentValue, ZeroOffset );
+		RampSteps++;
+	}
+	if (0 == RampSteps){
+		return 0;
+	}
+	// the first step waits for the present delay, each next one waits RAMP_DELAY visits of the channel
+	uint32_t ChannelVisits = RampStepDelay[Channel] + 1 + (RampSteps-1) * (RAMP_DELAY+1);
+	return (ChannelVisits * NUMBER_OF_POWER_SUPPLIES * FSM_CALL_PERIOD_IN_MICROSECONDS + 999) / 1000;
+}
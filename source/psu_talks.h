@@ -19,6 +19,11 @@
 #define SIG2_IS_VALID_INFORMATION		2
 #define SIG2_RECORD_SIZE				3
 
+#define ZERO_CALIBRATION_NOT_DONE		0
+#define ZERO_CALIBRATION_RUNNING		1
+#define ZERO_CALIBRATION_CONVERGED		2
+#define ZERO_CALIBRATION_FAILED			3	// Sig2 is the same for DAC values 0 and FULL_SCALE_IN_DAC_UNITS
+
 //---------------------------------------------------------------------------------------------------
 // Global constants
 //---------------------------------------------------------------------------------------------------
@@ -36,9 +41,36 @@ typedef enum {
 	PSU_RUNNING,					// stable state; power supply is turned on
 	PSU_SHUTTING_DOWN_ZEROING,		// transitional state; during power-down
 	PSU_SHUTTING_DOWN_CONTACTOR_OFF,// transitional state; during power-down
+	PSU_CALIBRATION_SET_DAC,		// transitional state; during zero-current calibration (power supply is turned off)
+	PSU_CALIBRATION_TEST,			// transitional state; during zero-current calibration (power supply is turned off)
+	PSU_TRIP_ZEROING,				// transitional state; fast zeroing of all DACs after a fault (see trip_monitor.h)
 	PSU_ILLEGAL_STATE				// number of correct states
 }PsuOperatingStates;
 
+/// The result of the zero-current calibration of a single channel
+typedef struct {
+	uint16_t Status;				// takes values ZERO_CALIBRATION_...
+	uint16_t ZeroOffset;			// the lowest DAC value for which Sig2 has the same state as for FULL_SCALE_IN_DAC_UNITS
+	uint16_t DacWrites;				// number of DAC values tested
+	uint32_t DurationInMilliseconds;
+}ZeroCalibrationReport;
+
+/// The state of the whole power supply at one moment (see takePsuSnapshot)
+typedef struct {
+	uint16_t PsuState;
+	bool IsPowerOn;
+	uint16_t UartError;
+	uint16_t I2cConsecutiveErrors;
+	uint16_t I2cMaxConsecutiveErrors;
+	uint16_t UserSetpointDacValue[NUMBER_OF_POWER_SUPPLIES];
+	uint16_t InstantaneousSetpointDacValue[NUMBER_OF_POWER_SUPPLIES];
+	uint16_t WrittenToDacValue[NUMBER_OF_POWER_SUPPLIES];
+	int32_t MeasuredMicroVolts[NUMBER_OF_POWER_SUPPLIES];
+	bool Sig2LastReadings[NUMBER_OF_POWER_SUPPLIES][SIG2_RECORD_SIZE];
+	bool Sig2PresentReading[NUMBER_OF_POWER_SUPPLIES];
+	bool IsRampRunning[NUMBER_OF_POWER_SUPPLIES];
+}PsuSnapshot;
+
 //---------------------------------------------------------------------------------------------------
 // Global variables
 //---------------------------------------------------------------------------------------------------
@@ -65,6 +97,13 @@ extern atomic_bool IsMainContactorStateOn;
 /// for two DAC values: 0 and FULL_SCALE_IN_DAC_UNITS; additionally, a flag is used to indicate that the data is valid
 extern atomic_bool Sig2LastReadings[NUMBER_OF_POWER_SUPPLIES][SIG2_RECORD_SIZE];
 
+/// This array is used to store the last reading of Sig2 for each channel (for the value presently written to the DAC)
+extern atomic_bool Sig2PresentReading[NUMBER_OF_POWER_SUPPLIES];
+
+/// Bit J is set by the timer interrupt when the ramp of channel J has reached the user's setpoint;
+/// the bits are cleared by the user interface after the notification has been sent
+extern atomic_uint_fast16_t SettledChannels;
+
 //---------------------------------------------------------------------------------------------------
 // Function prototypes
 //---------------------------------------------------------------------------------------------------
@@ -88,4 +127,22 @@ uint16_t psuStateMachine(void);
 /// This function prepares information on Sig2 readings in text form
 char* convertSig2TableToText(void);
 
+/// @brief This function copies the result of the last zero-current calibration of a given channel
+/// @return false if the calibration is running (the copy is not made)
+bool getZeroCalibrationReport( uint8_t Channel, ZeroCalibrationReport *ReportPtr );
+
+/// @brief This function copies the state of all the channels, the FSM state and the error counters
+/// The state is published by the timer interrupt after each step of the state machine (every 2.4 ms) under
+/// a sequence lock, so all the values come from the same moment; the interrupts are not disabled.
+/// The exception are the error flags and counters (UartError, I2c...Errors): they are read at the time of the call,
+/// so a reset by resetErrors is seen at once. Other changes made in the main loop appear after the next publication.
+void takePsuSnapshot( PsuSnapshot *SnapshotPtr );
+
+/// @brief This function returns the number of snapshot copies repeated because the state was published meanwhile
+uint32_t getSnapshotRetries(void);
+
+/// @brief This function estimates the time remaining until the ramp of a given channel reaches the user's setpoint
+/// @return time in milliseconds (0 if the setpoint has been reached)
+uint32_t getRampRemainingTime( uint8_t Channel );
+
 #endif // SOURCE_PSU_TALKS_H_
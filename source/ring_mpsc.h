@@ -0,0 +1,124 @@
+/// @file ring_mpsc.h
+/// @brief Lock-free MPSC (Multi-Producer Single-Consumer) ring of fixed-size records using C11 atomics.
+/// Every slot has a sequence number telling whose turn it is: a producer claims a position with a compare-and-swap
+/// of the head, copies its record into the slot and hands the slot to the consumer by advancing the sequence number;
+/// the consumer takes the record and hands the slot back to the producers of the next lap (D. Vyukov's bounded queue,
+/// reduced to one consumer). RING_MPSC_DEFINE_TYPED generates the ring for the given record type.
+/// Assumptions:
+/// - BUFFER_SIZE is a power of two; the ring holds up to BUFFER_SIZE records (no slot is left empty).
+/// - Any number of producers: interrupt handlers of different priorities and code on both cores.
+///   A producer never waits for another one; it only repeats the compare-and-swap if another producer took
+///   the position first. A full ring rejects the record and counts it.
+/// - There is one consumer (main context). A record claimed by a producer that has been interrupted before
+///   publishing it holds back the consumer (the ring looks empty) until the producer resumes, so the records
+///   come out in the order the positions were claimed.
+/// - The records of each producer come out in the order of their pushes; the records of different producers
+///   are interleaved in the order of the compare-and-swaps.
+/// - The Cortex-M0+ has no exclusive access instructions: the compare-and-swap and the fetch-and-add are
+///   library calls of the SDK (pico_atomic: a hardware spin lock with the interrupts disabled for a few cycles),
+///   which are atomic for both cores and all interrupt levels.
+
+#ifndef RING_MPSC_H_
+#define RING_MPSC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+//---------------------------------------------------------------------------------------------------
+// Typed rings
+//---------------------------------------------------------------------------------------------------
+
+/// @brief The macro generates a ring of records of the given type, e.g.
+/// RING_MPSC_DEFINE_TYPED(eventRing, PsuEvent) defines eventRing_slot_t (the storage is an array of these),
+/// eventRing_t and eventRingInit, eventRingPush (producers), eventRingPop, eventRingIsEmpty (consumer)
+/// and eventRingDropped.
+/// The positions are free-running 32-bit counters (they wrap around), hence the 32-bit atomic types:
+/// atomic_uint_fast32_t may be wider on the host.
+#define RING_MPSC_DEFINE_TYPED(Name, Type)                                                                  \
+typedef struct {                                                                                            \
+    atomic_uint_least32_t sequence;  /* position of the record expected in the slot; +1 when it is there */ \
+    Type data;                                                                                              \
+} Name##_slot_t;                                                                                            \
+                                                                                                            \
+typedef struct {                                                                                            \
+    Name##_slot_t *slots;            /* pointer to storage */                                               \
+    uint32_t mask;                   /* size - 1 */                                                         \
+    atomic_uint_least32_t head;      /* next position claimed by a producer */                              \
+    atomic_uint_least32_t tail;      /* next position taken by the consumer (consumer only) */              \
+    atomic_uint_least32_t dropped;   /* number of records rejected because the ring was full */             \
+} Name##_t;                                                                                                 \
+                                                                                                            \
+/* Initialize the ring; SlotsPtr must point to an array of Size slots, Size must be a power of two */       \
+static inline void Name##Init(Name##_t *RingPtr, Name##_slot_t *SlotsPtr, size_t Size){                     \
+    RingPtr->slots = SlotsPtr;                                                                              \
+    RingPtr->mask = (uint32_t)Size - 1u;                                                                    \
+    for (uint32_t Position = 0; Position < (uint32_t)Size; Position++){                                     \
+        atomic_init(&SlotsPtr[Position].sequence, Position);                                                \
+    }                                                                                                       \
+    atomic_init(&RingPtr->head, 0u);                                                                        \
+    atomic_init(&RingPtr->tail, 0u);                                                                        \
+    atomic_init(&RingPtr->dropped, 0u);                                                                     \
+}                                                                                                           \
+                                                                                                            \
+/* Producers: copy the record to the ring; safe to call from any ISR and from both cores */                 \
+/* Returns false if the ring is full (the record is dropped and counted) */                                 \
+static inline bool Name##Push(Name##_t *RingPtr, const Type *ElementPtr){                                   \
+    uint32_t Position = atomic_load_explicit(&RingPtr->head, memory_order_relaxed);                         \
+    Name##_slot_t *SlotPtr;                                                                                 \
+    for (;;){                                                                                               \
+        SlotPtr = &RingPtr->slots[Position & RingPtr->mask];                                                \
+        uint32_t Sequence = atomic_load_explicit(&SlotPtr->sequence, memory_order_acquire);                 \
+        int32_t Difference = (int32_t)(Sequence - Position);                                                \
+        if (0 == Difference){                                                                               \
+            /* the slot is free in this lap: claim the position (on failure Position is reloaded) */        \
+            if (atomic_compare_exchange_weak_explicit(&RingPtr->head, &Position, Position + 1u,             \
+                    memory_order_relaxed, memory_order_relaxed)){                                           \
+                break;                                                                                      \
+            }                                                                                               \
+        }                                                                                                   \
+        else if (Difference < 0){                                                                           \
+            /* the slot still holds the record of the previous lap: full */                                 \
+            atomic_fetch_add_explicit(&RingPtr->dropped, 1u, memory_order_relaxed);                        \
+            return false;                                                                                   \
+        }                                                                                                   \
+        else{                                                                                               \
+            /* another producer has claimed the position meanwhile */                                       \
+            Position = atomic_load_explicit(&RingPtr->head, memory_order_relaxed);                          \
+        }                                                                                                   \
+    }                                                                                                       \
+    SlotPtr->data = *ElementPtr;                                                                            \
+    /* the record must be complete before the consumer sees the slot */                                     \
+    atomic_store_explicit(&SlotPtr->sequence, Position + 1u, memory_order_release);                         \
+    return true;                                                                                            \
+}                                                                                                           \
+                                                                                                            \
+/* Consumer: take the oldest record; returns false if there is none (or it is still being written) */       \
+static inline bool Name##Pop(Name##_t *RingPtr, Type *ElementPtr){                                         \
+    uint32_t Position = atomic_load_explicit(&RingPtr->tail, memory_order_relaxed);                         \
+    Name##_slot_t *SlotPtr = &RingPtr->slots[Position & RingPtr->mask];                                     \
+    uint32_t Sequence = atomic_load_explicit(&SlotPtr->sequence, memory_order_acquire);                     \
+    if (Sequence != Position + 1u){                                                                         \
+        return false;                                                                                       \
+    }                                                                                                       \
+    *ElementPtr = SlotPtr->data;                                                                            \
+    /* the record must be read before the slot is given to the producers of the next lap */                 \
+    atomic_store_explicit(&SlotPtr->sequence, Position + RingPtr->mask + 1u, memory_order_release);         \
+    atomic_store_explicit(&RingPtr->tail, Position + 1u, memory_order_relaxed);                             \
+    return true;                                                                                            \
+}                                                                                                           \
+                                                                                                            \
+/* Consumer: true if the next record is not ready */                                                        \
+static inline bool Name##IsEmpty(Name##_t *RingPtr){                                                        \
+    uint32_t Position = atomic_load_explicit(&RingPtr->tail, memory_order_relaxed);                         \
+    return atomic_load_explicit(&RingPtr->slots[Position & RingPtr->mask].sequence, memory_order_acquire)   \
+            != Position + 1u;                                                                               \
+}                                                                                                           \
+                                                                                                            \
+/* The number of records rejected because the ring was full */                                              \
+static inline uint32_t Name##Dropped(Name##_t *RingPtr){                                                    \
+    return atomic_load_explicit(&RingPtr->dropped, memory_order_relaxed);                                   \
+}
+
+#endif // RING_MPSC_H_
@@ -1,9 +1,15 @@
 /// @file ring_spsc.h
 /// @brief Simple lock-free SPSC (Single-Producer Single-Consumer) ring buffer (byte elements) using C11 atomics.
+/// Besides the single bytes, the data can be passed in blocks: ringSpscPushBulk / ringSpscPopBulk copy a block,
+/// and the spans give direct access to a contiguous region of the buffer (e.g. for memcpy or DMA), which is
+/// published (producer) or released (consumer) by the commit afterwards. RING_SPSC_DEFINE_TYPED generates
+/// the same ring for fixed-size records.
 /// Assumptions:
-/// - BUFFER_SIZE is a power of two.
+/// - BUFFER_SIZE is a power of two; the ring holds up to BUFFER_SIZE-1 elements.
 /// - Producer and consumer are single-threaded roles (SPSC).
 /// - Producer can be an ISR; consumer is main context.
+/// - With RING_SPSC_ENABLE_STATISTICS set to 1 the rings count the rejected pushes and keep the high-water mark
+///   (both are updated by the producer only).
 
 #ifndef RING_SPSC_H_
 #define RING_SPSC_H_
@@ -12,6 +18,12 @@
 #include <stdint.h>
 #include <stdatomic.h>
 #include <stddef.h>
+#include <string.h>
+
+/// The statistics cost an extra load and store per push; they are off unless requested
+#ifndef RING_SPSC_ENABLE_STATISTICS
+#define RING_SPSC_ENABLE_STATISTICS 0
+#endif
 
 typedef struct {
     uint8_t *buffer;                 // pointer to storage (byte elements)
@@ -19,6 +31,10 @@ typedef struct {
     size_t mask;                     // size - 1
     atomic_uint_fast32_t head;       // producer index (next write position)
     atomic_uint_fast32_t tail;       // consumer index (next read position)
+#if RING_SPSC_ENABLE_STATISTICS == 1
+    atomic_uint_fast32_t overflows;  // number of pushes rejected because the buffer was full
+    atomic_uint_fast32_t high_water; // the largest number of elements held so far
+#endif
 } ring_spsc_t;
 
 //---------------------------------------------------------------------------------------------------
@@ -33,6 +49,32 @@ static inline void ringSpscInit(ring_spsc_t *RingPtr, uint8_t *BufferStoragePtr,
     RingPtr->mask = Size - 1;
     atomic_init(&RingPtr->head, 0u);
     atomic_init(&RingPtr->tail, 0u);
+#if RING_SPSC_ENABLE_STATISTICS == 1
+    atomic_init(&RingPtr->overflows, 0u);
+    atomic_init(&RingPtr->high_water, 0u);
+#endif
+}
+
+/// @brief The function updates the statistics after a push (producer only)
+/// @param Used number of elements in the buffer after the push
+static inline void ringSpscRecordPush(ring_spsc_t *RingPtr, uint32_t Used){
+#if RING_SPSC_ENABLE_STATISTICS == 1
+    if (Used > atomic_load_explicit(&RingPtr->high_water, memory_order_relaxed)){
+        atomic_store_explicit(&RingPtr->high_water, Used, memory_order_relaxed);
+    }
+#else
+    (void)RingPtr;
+    (void)Used;
+#endif
+}
+
+/// @brief The function counts a rejected push (producer only)
+static inline void ringSpscRecordOverflow(ring_spsc_t *RingPtr){
+#if RING_SPSC_ENABLE_STATISTICS == 1
+    atomic_fetch_add_explicit(&RingPtr->overflows, 1u, memory_order_relaxed);
+#else
+    (void)RingPtr;
+#endif
 }
 
 /// @brief The function pushes the byte to the ring buffer
@@ -45,11 +87,13 @@ static inline bool ringSpscPush(ring_spsc_t *RingPtr, uint8_t NewCharacter){
     uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_acquire);
     if (Next == Tail){
         // full
+        ringSpscRecordOverflow(RingPtr);
         return false;
     }
     RingPtr->buffer[Head & RingPtr->mask] = NewCharacter;
     // publish the new Head so consumer can see the entry
     atomic_store_explicit(&RingPtr->head, Next, memory_order_release);
+    ringSpscRecordPush(RingPtr, (Next - Tail) & (uint32_t)RingPtr->mask);
     return true;
 }
 
@@ -70,6 +114,120 @@ static inline bool ringSpscPop(ring_spsc_t *RingPtr, uint8_t *OutputDataPtr){
     return true;
 }
 
+/// @brief The function reads the oldest byte without taking it
+/// Consumer only.
+/// @return true and stores byte in *out on success
+/// @return false if buffer empty
+static inline bool ringSpscPeek(ring_spsc_t *RingPtr, uint8_t *OutputDataPtr){
+    uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_relaxed);
+    uint32_t Head = atomic_load_explicit(&RingPtr->head, memory_order_acquire);
+    if (Tail == Head){
+        return false;
+    }
+    *OutputDataPtr = RingPtr->buffer[Tail & RingPtr->mask];
+    return true;
+}
+
+/// @brief The function returns the number of bytes in the buffer (exact for the consumer; the producer may add more)
+static inline size_t ringSpscCount(ring_spsc_t *RingPtr){
+    uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_relaxed);
+    uint32_t Head = atomic_load_explicit(&RingPtr->head, memory_order_acquire);
+    return (Head - Tail) & (uint32_t)RingPtr->mask;
+}
+
+/// @brief The function returns the number of free bytes (exact for the producer; the consumer may free more)
+static inline size_t ringSpscFree(ring_spsc_t *RingPtr){
+    uint32_t Head = atomic_load_explicit(&RingPtr->head, memory_order_relaxed);
+    uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_acquire);
+    return (Tail - Head - 1u) & (uint32_t)RingPtr->mask;
+}
+
+/// @brief The function gives the producer the contiguous free region at the head of the buffer
+/// Producer only. The region may be shorter than the free space (it ends at the end of the storage);
+/// the bytes written there are passed to the consumer by ringSpscWriteCommit.
+/// @return number of bytes available at *SpanPtr (0 if the buffer is full)
+static inline size_t ringSpscWriteSpan(ring_spsc_t *RingPtr, uint8_t **SpanPtr){
+    uint32_t Head = atomic_load_explicit(&RingPtr->head, memory_order_relaxed);
+    uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_acquire);
+    size_t Free = (Tail - Head - 1u) & (uint32_t)RingPtr->mask;
+    size_t ToEnd = RingPtr->size - Head;
+    *SpanPtr = RingPtr->buffer + Head;
+    return (Free < ToEnd)? Free : ToEnd;
+}
+
+/// @brief The function publishes Count bytes written to the span (Count must not exceed the span)
+/// Producer only.
+static inline void ringSpscWriteCommit(ring_spsc_t *RingPtr, size_t Count){
+    uint32_t Head = atomic_load_explicit(&RingPtr->head, memory_order_relaxed);
+    uint32_t Next = (Head + (uint32_t)Count) & (uint32_t)RingPtr->mask;
+    atomic_store_explicit(&RingPtr->head, Next, memory_order_release);
+#if RING_SPSC_ENABLE_STATISTICS == 1
+    uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_relaxed);
+    ringSpscRecordPush(RingPtr, (Next - Tail) & (uint32_t)RingPtr->mask);
+#endif
+}
+
+/// @brief The function gives the consumer the contiguous region of the oldest bytes (they stay in the buffer)
+/// Consumer only. The region may be shorter than the data (it ends at the end of the storage);
+/// the bytes are released by ringSpscReadCommit.
+/// @return number of bytes available at *SpanPtr (0 if the buffer is empty)
+static inline size_t ringSpscReadSpan(ring_spsc_t *RingPtr, const uint8_t **SpanPtr){
+    uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_relaxed);
+    uint32_t Head = atomic_load_explicit(&RingPtr->head, memory_order_acquire);
+    size_t Used = (Head - Tail) & (uint32_t)RingPtr->mask;
+    size_t ToEnd = RingPtr->size - Tail;
+    *SpanPtr = RingPtr->buffer + Tail;
+    return (Used < ToEnd)? Used : ToEnd;
+}
+
+/// @brief The function releases Count bytes of the span to the producer (Count must not exceed the span)
+/// Consumer only.
+static inline void ringSpscReadCommit(ring_spsc_t *RingPtr, size_t Count){
+    uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_relaxed);
+    // the bytes must be read before the producer may overwrite them
+    atomic_store_explicit(&RingPtr->tail, (Tail + (uint32_t)Count) & (uint32_t)RingPtr->mask, memory_order_release);
+}
+
+/// @brief The function pushes a block of bytes (all of them or none)
+/// Producer: safe to call from ISR. The block is copied with at most two memcpy and published at once.
+/// @return true on success
+/// @return false if there is not enough space (the block is dropped)
+static inline bool ringSpscPushBulk(ring_spsc_t *RingPtr, const uint8_t *DataPtr, size_t Length){
+    uint32_t Head = atomic_load_explicit(&RingPtr->head, memory_order_relaxed);
+    uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_acquire);
+    size_t Free = (Tail - Head - 1u) & (uint32_t)RingPtr->mask;
+    if (Length > Free){
+        ringSpscRecordOverflow(RingPtr);
+        return false;
+    }
+    size_t ToEnd = RingPtr->size - Head;
+    size_t First = (Length < ToEnd)? Length : ToEnd;
+    memcpy(RingPtr->buffer + Head, DataPtr, First);
+    memcpy(RingPtr->buffer, DataPtr + First, Length - First);
+    uint32_t Next = (Head + (uint32_t)Length) & (uint32_t)RingPtr->mask;
+    atomic_store_explicit(&RingPtr->head, Next, memory_order_release);
+    ringSpscRecordPush(RingPtr, (Next - Tail) & (uint32_t)RingPtr->mask);
+    return true;
+}
+
+/// @brief The function takes up to Length bytes from the buffer
+/// Consumer: safe to call from main context.
+/// @return number of bytes stored at DataPtr (0 if the buffer is empty)
+static inline size_t ringSpscPopBulk(ring_spsc_t *RingPtr, uint8_t *DataPtr, size_t Length){
+    uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_relaxed);
+    uint32_t Head = atomic_load_explicit(&RingPtr->head, memory_order_acquire);
+    size_t Used = (Head - Tail) & (uint32_t)RingPtr->mask;
+    if (Length > Used){
+        Length = Used;
+    }
+    size_t ToEnd = RingPtr->size - Tail;
+    size_t First = (Length < ToEnd)? Length : ToEnd;
+    memcpy(DataPtr, RingPtr->buffer + Tail, First);
+    memcpy(DataPtr + First, RingPtr->buffer, Length - First);
+    atomic_store_explicit(&RingPtr->tail, (Tail + (uint32_t)Length) & (uint32_t)RingPtr->mask, memory_order_release);
+    return Length;
+}
+
 /// @brief The function checks if the buffer is empty
 /// @return true if the buffer is empty
 /// @return false if the buffer is not empty
@@ -89,4 +247,122 @@ static inline bool ringSpscIsFull(ring_spsc_t *RingPtr){
     return Next == Tail;
 }
 
+#if RING_SPSC_ENABLE_STATISTICS == 1
+/// @brief The function returns the number of pushes rejected because the buffer was full
+static inline uint32_t ringSpscOverflows(ring_spsc_t *RingPtr){
+    return atomic_load_explicit(&RingPtr->overflows, memory_order_relaxed);
+}
+
+/// @brief The function returns the largest number of bytes held in the buffer so far
+static inline uint32_t ringSpscHighWaterMark(ring_spsc_t *RingPtr){
+    return atomic_load_explicit(&RingPtr->high_water, memory_order_relaxed);
+}
+#endif
+
+//---------------------------------------------------------------------------------------------------
+// Typed rings
+//---------------------------------------------------------------------------------------------------
+
+/// @brief The macro generates a ring of fixed-size records of the given type, e.g.
+/// RING_SPSC_DEFINE_TYPED(orderRing, PsuOrder) defines orderRing_t and orderRingInit, orderRingPush, orderRingPop,
+/// orderRingReserve / orderRingPublish (the producer fills the slot in place), orderRingPeek / orderRingRelease
+/// (the consumer reads the record in place), orderRingIsEmpty and orderRingCount.
+/// The rules are the same as for the byte ring: SPSC, the size is a power of two, up to size-1 records are held.
+#if RING_SPSC_ENABLE_STATISTICS == 1
+#define RING_SPSC_TYPED_STATISTICS_FIELDS                                                                   \
+    atomic_uint_fast32_t overflows;                                                                         \
+    atomic_uint_fast32_t high_water;
+#define RING_SPSC_TYPED_INIT_STATISTICS(RingPtr)                                                            \
+    atomic_init(&(RingPtr)->overflows, 0u);                                                                 \
+    atomic_init(&(RingPtr)->high_water, 0u);
+#define RING_SPSC_TYPED_RECORD_OVERFLOW(RingPtr)                                                            \
+    atomic_fetch_add_explicit(&(RingPtr)->overflows, 1u, memory_order_relaxed);
+#define RING_SPSC_TYPED_RECORD_PUSH(RingPtr, Used)                                                          \
+    if ((Used) > atomic_load_explicit(&(RingPtr)->high_water, memory_order_relaxed)){                       \
+        atomic_store_explicit(&(RingPtr)->high_water, (Used), memory_order_relaxed);                        \
+    }
+#else
+#define RING_SPSC_TYPED_STATISTICS_FIELDS
+#define RING_SPSC_TYPED_INIT_STATISTICS(RingPtr)
+#define RING_SPSC_TYPED_RECORD_OVERFLOW(RingPtr)
+#define RING_SPSC_TYPED_RECORD_PUSH(RingPtr, Used)
+#endif
+
+#define RING_SPSC_DEFINE_TYPED(Name, Type)                                                                  \
+typedef struct {                                                                                            \
+    Type *buffer;                                                                                           \
+    uint32_t mask;                                                                                          \
+    atomic_uint_fast32_t head;                                                                              \
+    atomic_uint_fast32_t tail;                                                                              \
+    RING_SPSC_TYPED_STATISTICS_FIELDS                                                                       \
+} Name##_t;                                                                                                 \
+                                                                                                            \
+static inline void Name##Init(Name##_t *RingPtr, Type *BufferStoragePtr, size_t Size){                      \
+    RingPtr->buffer = BufferStoragePtr;                                                                     \
+    RingPtr->mask = (uint32_t)Size - 1u;                                                                    \
+    atomic_init(&RingPtr->head, 0u);                                                                        \
+    atomic_init(&RingPtr->tail, 0u);                                                                        \
+    RING_SPSC_TYPED_INIT_STATISTICS(RingPtr)                                                                \
+}                                                                                                           \
+                                                                                                            \
+static inline Type *Name##Reserve(Name##_t *RingPtr){                                                       \
+    uint32_t Head = atomic_load_explicit(&RingPtr->head, memory_order_relaxed);                             \
+    uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_acquire);                             \
+    if (((Head + 1u) & RingPtr->mask) == Tail){                                                             \
+        RING_SPSC_TYPED_RECORD_OVERFLOW(RingPtr)                                                            \
+        return NULL;                                                                                        \
+    }                                                                                                       \
+    return &RingPtr->buffer[Head];                                                                          \
+}                                                                                                           \
+                                                                                                            \
+static inline void Name##Publish(Name##_t *RingPtr){                                                        \
+    uint32_t Head = atomic_load_explicit(&RingPtr->head, memory_order_relaxed);                             \
+    uint32_t Next = (Head + 1u) & RingPtr->mask;                                                            \
+    atomic_store_explicit(&RingPtr->head, Next, memory_order_release);                                      \
+    RING_SPSC_TYPED_RECORD_PUSH(RingPtr,                                                                    \
+            (Next - (uint32_t)atomic_load_explicit(&RingPtr->tail, memory_order_relaxed)) & RingPtr->mask)  \
+}                                                                                                           \
+                                                                                                            \
+static inline bool Name##Push(Name##_t *RingPtr, const Type *ElementPtr){                                   \
+    Type *SlotPtr = Name##Reserve(RingPtr);                                                                 \
+    if (NULL == SlotPtr){                                                                                   \
+        return false;                                                                                       \
+    }                                                                                                       \
+    *SlotPtr = *ElementPtr;                                                                                 \
+    Name##Publish(RingPtr);                                                                                 \
+    return true;                                                                                            \
+}                                                                                                           \
+                                                                                                            \
+static inline const Type *Name##Peek(Name##_t *RingPtr){                                                    \
+    uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_relaxed);                             \
+    uint32_t Head = atomic_load_explicit(&RingPtr->head, memory_order_acquire);                             \
+    return (Tail == Head)? NULL : &RingPtr->buffer[Tail];                                                   \
+}                                                                                                           \
+                                                                                                            \
+static inline void Name##Release(Name##_t *RingPtr){                                                        \
+    uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_relaxed);                             \
+    atomic_store_explicit(&RingPtr->tail, (Tail + 1u) & RingPtr->mask, memory_order_release);               \
+}                                                                                                           \
+                                                                                                            \
+static inline bool Name##Pop(Name##_t *RingPtr, Type *ElementPtr){                                         \
+    const Type *SlotPtr = Name##Peek(RingPtr);                                                              \
+    if (NULL == SlotPtr){                                                                                   \
+        return false;                                                                                       \
+    }                                                                                                       \
+    *ElementPtr = *SlotPtr;                                                                                 \
+    Name##Release(RingPtr);                                                                                 \
+    return true;                                                                                            \
+}                                                                                                           \
+                                                                                                            \
+static inline bool Name##IsEmpty(Name##_t *RingPtr){                                                        \
+    return atomic_load_explicit(&RingPtr->tail, memory_order_relaxed) ==                                    \
+            atomic_load_explicit(&RingPtr->head, memory_order_acquire);                                     \
+}                                                                                                           \
+                                                                                                            \
+static inline size_t Name##Count(Name##_t *RingPtr){                                                        \
+    uint32_t Tail = atomic_load_explicit(&RingPtr->tail, memory_order_relaxed);                             \
+    uint32_t Head = atomic_load_explicit(&RingPtr->head, memory_order_acquire);                             \
+    return (Head - Tail) & RingPtr->mask;                                                                   \
+}
+
 #endif // RING_SPSC_H_
@@ -0,0 +1,288 @@
+/// @file rstl_binary.c
+
+#include <assert.h>
+#include "pico/stdlib.h"
+#include "rstl_binary.h"
+#include "uart_talks.h"
+#include "psu_talks.h"
+#include "trip_monitor.h"
+#include "text_format.h"
+#include "debugging.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+#define CRC16_POLYNOMIAL				0x1021u
+#define CRC16_INITIAL_VALUE				0xFFFFu
+
+/// Offsets of the fields in the frame
+#define FRAME_LENGTH_OFFSET				1
+#define FRAME_SEQUENCE_OFFSET			2
+#define FRAME_OPCODE_OFFSET				3
+#define FRAME_PAYLOAD_OFFSET			4
+#define RESPONSE_DATA_OFFSET			5			// after the status
+
+/// The response content: SEQ, OP, status and the data
+#define RESPONSE_HEADER_LENGTH			3
+#define GET_ALL_COMMON_LENGTH			5
+#define GET_ALL_CHANNEL_LENGTH			10
+#define RESPONSE_MAX_DATA_LENGTH		(GET_ALL_COMMON_LENGTH + NUMBER_OF_POWER_SUPPLIES*GET_ALL_CHANNEL_LENGTH)
+#define RESPONSE_BUFFER_LENGTH			(BINARY_FRAME_OVERHEAD + RESPONSE_HEADER_LENGTH + RESPONSE_MAX_DATA_LENGTH)
+
+/// The value of BinaryOperation.RequiredState for operations accepted in every state of the FSM
+#define ANY_PSU_STATE					0xFFFF
+
+#define OPERATION_TABLE_SIZE			(sizeof(OperationTable)/sizeof(OperationTable[0]))
+
+static_assert( RESPONSE_BUFFER_LENGTH - BINARY_FRAME_OVERHEAD <= UINT8_MAX, "static_assert the response length fits in LEN" );
+
+//---------------------------------------------------------------------------------------------------
+// Local constants
+//---------------------------------------------------------------------------------------------------
+
+/// The handler is called when the operation is known and the state is correct; it appends the data
+/// of the response (starting at DataPtr) and returns its length in DataLengthPtr
+typedef CommandErrors (*BinaryHandler)( const uint8_t *PayloadPtr, uint8_t PayloadLength,
+		uint8_t *DataPtr, uint8_t *DataLengthPtr );
+
+/// The entry of the operation table
+typedef struct {
+	uint8_t Opcode;
+	uint16_t RequiredState;			// value of PsuState or ANY_PSU_STATE
+	BinaryHandler Handler;
+} BinaryOperation;
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+static CommandErrors operationGetAll( const uint8_t *PayloadPtr, uint8_t PayloadLength, uint8_t *DataPtr, uint8_t *DataLengthPtr );
+static CommandErrors operationSetCurrents( const uint8_t *PayloadPtr, uint8_t PayloadLength, uint8_t *DataPtr, uint8_t *DataLengthPtr );
+static CommandErrors operationPower( const uint8_t *PayloadPtr, uint8_t PayloadLength, uint8_t *DataPtr, uint8_t *DataLengthPtr );
+static CommandErrors operationResetErrors( const uint8_t *PayloadPtr, uint8_t PayloadLength, uint8_t *DataPtr, uint8_t *DataLengthPtr );
+static CommandErrors operationLeave( const uint8_t *PayloadPtr, uint8_t PayloadLength, uint8_t *DataPtr, uint8_t *DataLengthPtr );
+
+static void storeInt32( uint8_t *DataPtr, int32_t Value );
+static int32_t loadInt32( const uint8_t *DataPtr );
+
+//---------------------------------------------------------------------------------------------------
+// Local constants
+//---------------------------------------------------------------------------------------------------
+
+/// @brief The table of binary operations
+static const BinaryOperation OperationTable[] = {
+	// Opcode						RequiredState		Handler
+	{ BINARY_OPCODE_GET_ALL,		ANY_PSU_STATE,		operationGetAll },
+	{ BINARY_OPCODE_SET_CURRENTS,	PSU_RUNNING,		operationSetCurrents },
+	{ BINARY_OPCODE_POWER,			ANY_PSU_STATE,		operationPower },
+	{ BINARY_OPCODE_RESET_ERRORS,	ANY_PSU_STATE,		operationResetErrors },
+	{ BINARY_OPCODE_LEAVE,			ANY_PSU_STATE,		operationLeave },
+};
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function switches the session to the binary mode (the timeout starts now)
+void enterBinaryMode( RstlSession *SessionPtr ){
+	setSessionBinaryMode( SessionPtr, true );
+	SessionPtr->LastBinaryFrameTime = time_us_64();
+}
+
+/// @brief This function returns the session to the text mode if no valid frame has come for the timeout
+void superviseBinaryMode( RstlSession *SessionPtr ){
+	if (!isSessionInBinaryMode( SessionPtr ) ||
+			(time_us_64() - SessionPtr->LastBinaryFrameTime < BINARY_MODE_TIMEOUT_IN_MICROSECONDS))
+	{
+		return;
+	}
+	setSessionBinaryMode( SessionPtr, false );
+	transmitSessionText( SessionPtr, "\r\n>" );
+	printDebugText( "bin timeout\n" );
+}
+
+/// @brief This function executes the binary frame and sends the response
+CommandErrors executeBinaryFrame( RstlSession *SessionPtr, const uint8_t *FramePtr, uint16_t FrameLength ){
+	uint8_t ContentLength = FramePtr[FRAME_LENGTH_OFFSET];
+	if ((FrameLength < BINARY_FRAME_OVERHEAD+BINARY_FRAME_MIN_CONTENT) || (ContentLength+BINARY_FRAME_OVERHEAD != FrameLength)){
+		// the frames are checked by the assembler, so this should never happen
+		reportSessionFrameError( SessionPtr );
+		return COMMAND_INCORRECT_FORMAT;
+	}
+	uint16_t ReceivedCrc = ((uint16_t)FramePtr[FRAME_SEQUENCE_OFFSET+ContentLength] << 8) |
+			FramePtr[FRAME_SEQUENCE_OFFSET+ContentLength+1];
+
+	if (calculateCrc16( FramePtr+FRAME_LENGTH_OFFSET, ContentLength+1 ) != ReceivedCrc){
+		// no response; the master repeats the request
+		reportSessionFrameError( SessionPtr );
+		printDebugText( "bin crc\n" );
+		return COMMAND_INCORRECT_FORMAT;
+	}
+	SessionPtr->LastBinaryFrameTime = time_us_64();
+
+	uint8_t Opcode = FramePtr[FRAME_OPCODE_OFFSET];
+	uint8_t Response[RESPONSE_BUFFER_LENGTH];
+	uint8_t DataLength = 0;
+	CommandErrors ErrorCode = COMMAND_UNKNOWN;
+	BinaryHandler Handler = NULL;
+
+	for (uint8_t J = 0; J < OPERATION_TABLE_SIZE; J++){
+		if (OperationTable[J].Opcode == Opcode){
+			if ((ANY_PSU_STATE != OperationTable[J].RequiredState) &&
+					(OperationTable[J].RequiredState != atomic_load_explicit(&PsuState, memory_order_acquire)))
+			{
+				ErrorCode = COMMAND_INVOKED_IN_INCONSISTENT_STATE;
+			}
+			else{
+				Handler = OperationTable[J].Handler;
+			}
+			break;
+		}
+	}
+	if (NULL != Handler){
+		ErrorCode = Handler( FramePtr+FRAME_PAYLOAD_OFFSET, ContentLength-BINARY_FRAME_MIN_CONTENT,
+				Response+RESPONSE_DATA_OFFSET, &DataLength );
+		if (COMMAND_PROPER != ErrorCode){
+			DataLength = 0;
+		}
+	}
+
+	// SYNC, LEN, SEQ, OP, status, data, CRC
+	uint8_t ResponseContentLength = RESPONSE_HEADER_LENGTH + DataLength;
+	Response[0] = BINARY_FRAME_SYNC;
+	Response[FRAME_LENGTH_OFFSET] = ResponseContentLength;
+	Response[FRAME_SEQUENCE_OFFSET] = FramePtr[FRAME_SEQUENCE_OFFSET];
+	Response[FRAME_OPCODE_OFFSET] = Opcode | BINARY_OPCODE_RESPONSE_FLAG;
+	Response[FRAME_PAYLOAD_OFFSET] = (uint8_t)ErrorCode;
+	uint16_t Crc = calculateCrc16( Response+FRAME_LENGTH_OFFSET, ResponseContentLength+1 );
+	Response[FRAME_SEQUENCE_OFFSET+ResponseContentLength] = (uint8_t)(Crc >> 8);
+	Response[FRAME_SEQUENCE_OFFSET+ResponseContentLength+1] = (uint8_t)Crc;
+	transmitSessionBytes( SessionPtr, Response, ResponseContentLength+BINARY_FRAME_OVERHEAD );
+
+	if ((BINARY_OPCODE_LEAVE == Opcode) && (COMMAND_PROPER == ErrorCode)){
+		setSessionBinaryMode( SessionPtr, false );	// after the response has been queued
+	}
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	initializeTextBuffer( &Line, DebugLine, sizeof(DebugLine) );
+	appendText( &Line, "bin 0x" );
+	appendHexadecimal( &Line, Opcode, 2 );
+	appendText( &Line, "\tE=" );
+	appendUnsigned( &Line, ErrorCode );
+	appendCharacter( &Line, '\n' );
+	printDebugText( DebugLine );
+	return ErrorCode;
+}
+
+/// @brief This function calculates CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF) of a block of data
+uint16_t calculateCrc16( const uint8_t *DataPtr, uint16_t Length ){
+	uint16_t Crc = CRC16_INITIAL_VALUE;
+	for (uint16_t J = 0; J < Length; J++){
+		Crc ^= (uint16_t)DataPtr[J] << 8;
+		for (uint8_t K = 0; K < 8; K++){
+			Crc = (uint16_t)((Crc << 1) ^ (CRC16_POLYNOMIAL & (0u - (Crc >> 15))));
+		}
+	}
+	return Crc;
+}
+
+static CommandErrors operationGetAll( const uint8_t *PayloadPtr, uint8_t PayloadLength, uint8_t *DataPtr, uint8_t *DataLengthPtr ){
+	(void)PayloadPtr;
+	if (0 != PayloadLength){
+		return COMMAND_INCORRECT_SYNTAX;
+	}
+	PsuSnapshot Snapshot;
+	TripReport Report;
+	takePsuSnapshot( &Snapshot );
+	getTripReport( &Report );
+
+	DataPtr[0] = (uint8_t)Snapshot.PsuState;
+	DataPtr[1] = Snapshot.IsPowerOn? 1 : 0;
+	DataPtr[2] = (uint8_t)Snapshot.UartError;
+	DataPtr[3] = (Snapshot.I2cMaxConsecutiveErrors > UINT8_MAX)? UINT8_MAX : (uint8_t)Snapshot.I2cMaxConsecutiveErrors;
+	DataPtr[4] = (uint8_t)Report.FaultCode;
+	uint8_t *ChannelDataPtr = DataPtr + GET_ALL_COMMON_LENGTH;
+	for (uint8_t J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++){
+		uint32_t RemainingTime = getRampRemainingTime( J );
+		if (RemainingTime > UINT16_MAX){
+			RemainingTime = UINT16_MAX;
+		}
+		storeInt32( ChannelDataPtr, convertDacValueToMicroAmperes( J, Snapshot.UserSetpointDacValue[J] ) );
+		storeInt32( ChannelDataPtr+4, Snapshot.MeasuredMicroVolts[J] );
+		ChannelDataPtr[8] = (uint8_t)RemainingTime;
+		ChannelDataPtr[9] = (uint8_t)(RemainingTime >> 8);
+		ChannelDataPtr += GET_ALL_CHANNEL_LENGTH;
+	}
+	*DataLengthPtr = RESPONSE_MAX_DATA_LENGTH;
+	return COMMAND_PROPER;
+}
+
+static CommandErrors operationSetCurrents( const uint8_t *PayloadPtr, uint8_t PayloadLength, uint8_t *DataPtr, uint8_t *DataLengthPtr ){
+	(void)DataPtr;
+	(void)DataLengthPtr;
+	if (0 == PayloadLength){
+		return COMMAND_INCORRECT_SYNTAX;
+	}
+	uint8_t ChannelMask = PayloadPtr[0];
+	int32_t MicroAmperes[NUMBER_OF_POWER_SUPPLIES];
+	uint8_t NumberOfValues = 0;
+	for (uint8_t J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++){
+		if (0 != (ChannelMask & (1u << J))){
+			NumberOfValues++;
+		}
+	}
+	if (PayloadLength != 1 + 4*NumberOfValues){
+		return COMMAND_INCORRECT_SYNTAX;
+	}
+	for (uint8_t J = 0; J < NumberOfValues; J++){
+		MicroAmperes[J] = loadInt32( PayloadPtr+1+4*J );
+	}
+	return programCurrents( ChannelMask, MicroAmperes );
+}
+
+static CommandErrors operationPower( const uint8_t *PayloadPtr, uint8_t PayloadLength, uint8_t *DataPtr, uint8_t *DataLengthPtr ){
+	(void)DataPtr;
+	(void)DataLengthPtr;
+	if (1 != PayloadLength){
+		return COMMAND_INCORRECT_SYNTAX;
+	}
+	return switchPower( PayloadPtr[0] );
+}
+
+static CommandErrors operationResetErrors( const uint8_t *PayloadPtr, uint8_t PayloadLength, uint8_t *DataPtr, uint8_t *DataLengthPtr ){
+	(void)PayloadPtr;
+	(void)DataPtr;
+	(void)DataLengthPtr;
+	if (0 != PayloadLength){
+		return COMMAND_INCORRECT_SYNTAX;
+	}
+	resetErrors();
+	return COMMAND_PROPER;
+}
+
+static CommandErrors operationLeave( const uint8_t *PayloadPtr, uint8_t PayloadLength, uint8_t *DataPtr, uint8_t *DataLengthPtr ){
+	(void)PayloadPtr;
+	(void)DataPtr;
+	(void)DataLengthPtr;
+	if (0 != PayloadLength){
+		return COMMAND_INCORRECT_SYNTAX;
+	}
+	return COMMAND_PROPER;	// the mode is switched by executeBinaryFrame after the response
+}
+
+static void storeInt32( uint8_t *DataPtr, int32_t Value ){
+	uint32_t Bits = (uint32_t)Value;
+	for (uint8_t J = 0; J < 4; J++){
+		DataPtr[J] = (uint8_t)(Bits >> (8*J));
+	}
+}
+
+static int32_t loadInt32( const uint8_t *DataPtr ){
+	uint32_t Bits = 0;
+	for (uint8_t J = 0; J < 4; J++){
+		Bits |= (uint32_t)DataPtr[J] << (8*J);
+	}
+	return (int32_t)Bits;
+}
@@ -0,0 +1,67 @@
+/// @file rstl_binary.h
+/// @brief This module interprets the frames of the binary mode of the RSTL protocol
+///
+/// The binary mode is entered by the BIN text command and left by the BINARY_OPCODE_LEAVE frame. If no valid frame
+/// (one with a correct CRC) is received for BINARY_MODE_TIMEOUT_IN_MICROSECONDS, the session returns to the text mode
+/// by itself and sends the prompt "\r\n>", so a terminal is never locked out by a master that has gone away.
+/// A master that wants to stay in the binary mode sends a frame (e.g. BINARY_OPCODE_GET_ALL) at least this often.
+/// Frame: BINARY_FRAME_SYNC, LEN, SEQ, OP, PAYLOAD (LEN-2 bytes), CRC-16 (big endian).
+/// LEN is the number of bytes from SEQ to the end of PAYLOAD; the CRC-16/CCITT (polynomial 0x1021,
+/// initial value 0xFFFF) covers the bytes from LEN to the end of PAYLOAD.
+/// The response has the same SEQ, OP with the highest bit set, the status (a value from enum CommandErrors)
+/// and the data. Multi-byte values are little endian. A frame with a wrong CRC gets no response
+/// (the error is recorded by the link: UART_ERROR_BINARY_FRAME on the serial port), so the master repeats the request
+/// after a timeout. The binary mode is a state of the session; the other session stays in its own mode.
+///
+/// Operations:
+/// BINARY_OPCODE_GET_ALL		no payload; data: PsuState, contactor (0/1), UartError, I2cMaxConsecutiveErrors,
+///								trip fault code, then for each channel: setpoint [uA] int32, measured voltage [uV] int32,
+///								remaining time of the ramp [ms] uint16 (saturated)
+/// BINARY_OPCODE_SET_CURRENTS	payload: channel mask (bit 0 = channel 1), then one int32 [uA] for each bit set
+/// BINARY_OPCODE_POWER			payload: 1 (power up) or 0 (power down)
+/// BINARY_OPCODE_RESET_ERRORS	no payload
+/// BINARY_OPCODE_LEAVE			no payload; the text mode is restored after the response
+
+#ifndef SOURCE_RSTL_BINARY_H_
+#define SOURCE_RSTL_BINARY_H_
+
+#include <stdint.h>
+#include "rstl_protocol.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+#define BINARY_OPCODE_GET_ALL			0x01
+#define BINARY_OPCODE_SET_CURRENTS		0x02
+#define BINARY_OPCODE_POWER				0x03
+#define BINARY_OPCODE_RESET_ERRORS		0x04
+#define BINARY_OPCODE_LEAVE				0x7F
+
+#define BINARY_OPCODE_RESPONSE_FLAG		0x80
+
+/// The binary mode is left after this time without a valid frame
+#define BINARY_MODE_TIMEOUT_IN_MICROSECONDS		10000000
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function switches the session to the binary mode (the timeout starts now)
+void enterBinaryMode( RstlSession *SessionPtr );
+
+/// @brief This function returns the session to the text mode if no valid frame has come for the timeout
+/// It is to be called in the main loop, before the next frame of the session is taken.
+void superviseBinaryMode( RstlSession *SessionPtr );
+
+/// @brief This function executes the binary frame and sends the response
+/// @param SessionPtr the session that has received the frame (the response is sent in the same session)
+/// @param FramePtr the frame, from the sync byte to the CRC (it is not modified)
+/// @param FrameLength the number of bytes of the frame
+/// @return value from enum CommandErrors (COMMAND_INCORRECT_FORMAT if the frame has been dropped)
+CommandErrors executeBinaryFrame( RstlSession *SessionPtr, const uint8_t *FramePtr, uint16_t FrameLength );
+
+/// @brief This function calculates CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF) of a block of data
+uint16_t calculateCrc16( const uint8_t *DataPtr, uint16_t Length );
+
+#endif // SOURCE_RSTL_BINARY_H_
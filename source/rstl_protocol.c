@@ -1,59 +1,260 @@
 /// @file rstl_protocol.c
 
-#include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
-#include <math.h>
+#include <assert.h>
 #include "pico/stdlib.h"
 #include "rstl_protocol.h"
+#include "command_trie.h"
+#include "conversions.h"
+#include "text_format.h"
+#include "argument_parser.h"
 #include "uart_talks.h"
+#include "usb_talks.h"
+#include "rstl_session.h"
 #include "writing_to_dac.h"
 #include "psu_talks.h"
 #include "adc_inputs.h"
+#include "calibration.h"
+#include "trip_monitor.h"
 #include "compilation_time.h"
 #include "debugging.h"
+#include "rstl_binary.h"
+#include "order_queue.h"
+#include "metrics.h"
 
 //---------------------------------------------------------------------------------------------------
 // Macro directives
 //---------------------------------------------------------------------------------------------------
 
 #define COMMAND_MINIMAL_LENGTH				3
-#define COMMAND_FLOATING_POINT_MAX_LENGTH	9	// " -9.12345"
-#define COMMAND_FLOATING_POINT_DIGITS_LIMIT	6
-#define COMMAND_FLOATING_POINT_VALUE_LIMIT	10.0
+
+/// The value of CommandDescriptor.RequiredState for commands accepted in every state of the FSM
+#define ANY_PSU_STATE						0xFFFF
+
+#define COMMAND_TABLE_SIZE					(sizeof(CommandTable)/sizeof(CommandTable[0]))
+
+#define NUMBER_OF_SESSIONS					(sizeof(Sessions)/sizeof(Sessions[0]))
+
+/// The lines of the ?ALL response (fixed layout, with "\r\n")
+#define ALL_STATUS_HEADER_LENGTH			29		// "S=07 P=1 U=00 I=000/003 T=0\r\n"
+#define ALL_STATUS_CHANNEL_LENGTH			31		// "1 800 7F0 7F0 +01234567 HLH R\r\n"
+
+static_assert( ALL_STATUS_HEADER_LENGTH + NUMBER_OF_INSTALLED_PSU*ALL_STATUS_CHANNEL_LENGTH < LONGEST_BATCH_RESPONSE_LENGTH,
+		"static_assert the ?ALL response fits in the response buffer" );
+
+/// The latencies in the ?TRIP response are saturated to 6 digits
+#define TRIP_LATENCY_SATURATION					999999
+
+/// The period of the telemetry frames (TELE command); 0 stops the telemetry
+#define TELEMETRY_MIN_PERIOD_IN_MILLISECONDS	50
+#define TELEMETRY_MAX_PERIOD_IN_MILLISECONDS	60000
+
+/// The longest telemetry frame: "\r\nTELE <ms> S=07 U=00 I=000/000 T=0" (up to 42 characters), then for each
+/// installed channel " <n> <setpoint A> <measured V>" (up to 26 characters), then "\r\n>"
+#define TELEMETRY_LENGTH						(42 + NUMBER_OF_INSTALLED_PSU*26 + 4)
+
+static_assert( TELEMETRY_LENGTH < LONGEST_BATCH_RESPONSE_LENGTH, "static_assert TELEMETRY_LENGTH < LONGEST_BATCH_RESPONSE_LENGTH" );
+
+// a saturated argument (see argument_parser.h) must be out of the range of the setpoints
+static_assert( SETPOINT_LIMIT_IN_MICROAMPERES < DECIMAL_ARGUMENT_INTEGER_SATURATION * MICRO_UNITS_IN_ONE,
+		"static_assert SETPOINT_LIMIT_IN_MICROAMPERES < DECIMAL_ARGUMENT_INTEGER_SATURATION * MICRO_UNITS_IN_ONE" );
 
 //---------------------------------------------------------------------------------------------------
-// Global variables
+// Local constants
 //---------------------------------------------------------------------------------------------------
 
-/// @brief This buffer is used to pass data from UART
-/// This buffer is filled by the uart_talks module and is interpreted by the rstl_protocol module
-char NewCommand[COMMAND_BUFFER_LENGTH];
+/// The syntax of the argument that follows the command name
+typedef enum {
+	ARGUMENT_NONE,
+	ARGUMENT_DECIMAL,				// a decimal fraction converted to micro-units, e.g. " -1.25"
+	ARGUMENT_ONE_DIGIT,
+	ARGUMENT_UNSIGNED,				// an unsigned integer; the number of digits is limited by DigitsLimit
+} ArgumentGrammar;
 
-/// @brief Currently selected (active) power supply unit
-/// All commands related to power supply settings apply to this device
-atomic_uint_fast16_t UserSelectedChannel;
+/// The value of the argument (the field used depends on the grammar) and the channel of the command
+typedef struct {
+	int32_t MicroUnits;
+	uint32_t Unsigned;
+	uint8_t Digit;
+	uint16_t Channel;				// index of the channel given by the prefix "<n>:" or the channel selected by Z
+} CommandArgument;
 
-/// @brief This is a code of an action that cannot be executed immediately but must be processed by a state machine
-/// The variable can be modified in the main loop and in the timer interrupt handler
-atomic_uint_fast16_t OrderCode;
+/// The handler is called when the syntax and the state are correct; it appends its response (if the command
+/// is accepted) to the response of the frame and prints the debug message; the error response is added by executeCommand
+typedef CommandErrors (*CommandHandler)( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
 
-/// @brief This is a power supply unit to which OrderCode refers
-/// The variable can be modified in the main loop and in the timer interrupt handler
-atomic_uint_fast16_t OrderChannel;
+/// The entry of the command table
+typedef struct {
+	const char *Name;
+	ArgumentGrammar Grammar;
+	uint8_t DigitsLimit;			// used by ARGUMENT_UNSIGNED
+	uint16_t RequiredState;			// value of PsuState or ANY_PSU_STATE
+	bool IsChannelScoped;			// the command accepts the channel prefix, e.g. "2:PC 1.5"
+	CommandHandler Handler;
+} CommandDescriptor;
 
 //---------------------------------------------------------------------------------------------------
-// Function prototypes
+// Global variables
+//---------------------------------------------------------------------------------------------------
+
+/// @brief The power supply unit selected by the last Z command (of any session)
+/// Each session applies the commands to its own selected channel; this copy is used by the PSU simulation
+atomic_uint_fast16_t UserSelectedChannel;
+
 //---------------------------------------------------------------------------------------------------
+// Local variables
+//---------------------------------------------------------------------------------------------------
+
+/// The sessions: the serial port (the production link) and the USB port (maintenance tools)
+static RstlSession UartSession;
+
+static RstlSession UsbSession;
 
-static int32_t parseFloatArgument( float *Result, char *TextPtr, char EndMark );
+static RstlSession *const Sessions[] = { &UartSession, &UsbSession };
 
-static int32_t parseOneDigitArgument( uint8_t *Result, char *TextPtr, char EndMark );
+/// The session served at the moment; the command handlers respond in this session and use its state
+static RstlSession *ActiveSessionPtr = &UartSession;
+
+/// The setpoints given by the PC commands of the frame being executed (valid for the channels in PendingCurrentsMask);
+/// they are stored in UserSetpointDacValue when the order is placed
+static uint16_t PendingSetpointDacValue[NUMBER_OF_POWER_SUPPLIES];
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
 
 #if 0 // service commands
-static int32_t parseHexadecimal3DigitsArgument( uint16_t *Result, char *TextPtr, char EndMark );
+static int32_t parseHexadecimal3DigitsArgument( uint16_t *Result, const char *TextPtr, const char *EndPtr );
 #endif
 
+/// @brief This function serves the session: sends its pending messages and executes the frame it has received (if any)
+static void serveSession( RstlSession *SessionPtr );
+
+/// @brief This function sends the asynchronous messages (I2C error, SETTLED) pending in the session
+/// A message that cannot be queued stays pending until the next call.
+static void sendAsynchronousMessages( RstlSession *SessionPtr );
+
+/// @brief This function executes one command of the frame
+/// @param FrameEnd the end of the frame (the character after its last one)
+/// @param NextCommandPtr the beginning of the next command of the batch is stored here (NULL if there is none)
+/// @return value from enum CommandErrors
+static CommandErrors executeSingleCommand( const char *CommandText, const char *FrameEnd, const char **NextCommandPtr );
+
+static int32_t parseCommandArgument( const CommandDescriptor *CommandPtr, CommandArgument *ArgumentPtr, const char *TextPtr, const char *EndPtr );
+
+/// @brief This function appends the response of a command to the response of the frame (in the active session)
+/// The prompt '>' at the end of the text is skipped (it is sent once, after the last command).
+/// If the buffer is full, the text collected so far is sent.
+static void appendResponse( const char *Text );
+
+/// @brief This function places the order of the ramps of the channels given by the bit mask (the slot must be reserved)
+static void placeProgramCurrentOrder( uint16_t ChannelMask );
+
+/// @brief This function places the order of the ramps set by the PC commands of the batch so far (if any)
+static void placePendingCurrentsOrder(void);
+
+/// @brief This function sends a telemetry frame in the session if it is due and the link is idle
+/// The frame is delayed while a command is being received or a response is being sent; it is aborted
+/// by the serial port if the master starts a command during the transmission.
+static void sendTelemetry( RstlSession *SessionPtr );
+
+/// @brief This function starts the debug line of a command: "cmd <Name>\tE=<ErrorCode>"
+static void startCommandDebugLine( TextBuffer *LinePtr, char *DebugLine, const char *Name, CommandErrors ErrorCode );
+
+/// @brief This function appends the channel number (counted from 1) to the debug line: "\tch=<n>"
+static void appendChannelForDebugging( TextBuffer *LinePtr, uint16_t Channel );
+
+/// @brief This function terminates the debug line and prints it
+static void finishDebugLine( TextBuffer *LinePtr );
+
+static CommandErrors setCalibrationValue( bool (*Setter)( uint8_t, int32_t ), const char *DebugName,
+		const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+
+static CommandErrors commandProgramCurrent( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetProgrammedCurrent( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandSelectChannel( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetSelectedChannel( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandPower( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetPower( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetRampTime( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandMeasureCurrent( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandSetBaudRate( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetBaudRate( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetVersion( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetStatus( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandResetErrors( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandSetDacZeroOffset( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandSetDacGain( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandSetAdcOffset( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandSetAdcGain( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandCalibrateZero( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetZeroCalibration( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetCalibration( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandSaveCalibration( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandSetTripTolerance( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandSetTripTime( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetTrip( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandEnterBinaryMode( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetOrders( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetAllStatus( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandSetTelemetry( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetTelemetry( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandSetEcho( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetEcho( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandSetDebug( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetDebug( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+static CommandErrors commandGetStatistics( const CommandArgument *ArgumentPtr, char *ResponseBuffer );
+
+/// @brief This function appends the Sig2 reading: 'H', 'L' or '?' (no valid reading)
+static void appendSig2Reading( TextBuffer *TextPtr, bool Reading, bool IsValid );
+
+//---------------------------------------------------------------------------------------------------
+// Local constants
+//---------------------------------------------------------------------------------------------------
+
+/// @brief The table of RSTL commands
+/// A new command is added by adding its entry here; the names are put into the trie by initializeRstlProtocol.
+static const CommandDescriptor CommandTable[] = {
+	// Name			Grammar				Digits	RequiredState		Channel	Handler
+	{ "PC",			ARGUMENT_DECIMAL,	0,		PSU_RUNNING,		true,	commandProgramCurrent },
+	{ "?PC",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		true,	commandGetProgrammedCurrent },
+	{ "Z",			ARGUMENT_ONE_DIGIT,	0,		ANY_PSU_STATE,		false,	commandSelectChannel },
+	{ "?Z",			ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandGetSelectedChannel },
+	{ "POWER",		ARGUMENT_ONE_DIGIT,	0,		ANY_PSU_STATE,		false,	commandPower },
+	{ "?POWER",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandGetPower },
+	{ "?ETA",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		true,	commandGetRampTime },
+	{ "MC",			ARGUMENT_NONE,		0,		ANY_PSU_STATE,		true,	commandMeasureCurrent },
+	{ "BAUD",		ARGUMENT_UNSIGNED,	6,		ANY_PSU_STATE,		false,	commandSetBaudRate },
+	{ "?BAUD",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandGetBaudRate },
+	{ "VERSION",	ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandGetVersion },
+	{ "ST",			ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandGetStatus },
+	{ "RE",			ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandResetErrors },
+	{ "CDZ",		ARGUMENT_UNSIGNED,	4,		PSU_STOPPED,		true,	commandSetDacZeroOffset },
+	{ "CDG",		ARGUMENT_DECIMAL,	0,		PSU_STOPPED,		true,	commandSetDacGain },
+	{ "CAZ",		ARGUMENT_DECIMAL,	0,		PSU_STOPPED,		true,	commandSetAdcOffset },
+	{ "CAG",		ARGUMENT_DECIMAL,	0,		PSU_STOPPED,		true,	commandSetAdcGain },
+	{ "CALZ",		ARGUMENT_NONE,		0,		PSU_STOPPED,		false,	commandCalibrateZero },
+	{ "?CALZ",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		true,	commandGetZeroCalibration },
+	{ "?CAL",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		true,	commandGetCalibration },
+	{ "CSAVE",		ARGUMENT_NONE,		0,		PSU_STOPPED,		false,	commandSaveCalibration },
+	{ "TRIPTOL",	ARGUMENT_DECIMAL,	0,		ANY_PSU_STATE,		false,	commandSetTripTolerance },
+	{ "TRIPTIME",	ARGUMENT_UNSIGNED,	5,		ANY_PSU_STATE,		false,	commandSetTripTime },
+	{ "?TRIP",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandGetTrip },
+	{ "BIN",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandEnterBinaryMode },
+	{ "?ORDER",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandGetOrders },
+	{ "?ALL",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandGetAllStatus },
+	{ "TELE",		ARGUMENT_UNSIGNED,	5,		ANY_PSU_STATE,		false,	commandSetTelemetry },
+	{ "?TELE",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandGetTelemetry },
+	{ "ECHO",		ARGUMENT_ONE_DIGIT,	0,		ANY_PSU_STATE,		false,	commandSetEcho },
+	{ "?ECHO",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandGetEcho },
+	{ "DBG",		ARGUMENT_ONE_DIGIT,	0,		ANY_PSU_STATE,		false,	commandSetDebug },
+	{ "?DBG",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandGetDebug },
+	{ "STATS",		ARGUMENT_NONE,		0,		ANY_PSU_STATE,		false,	commandGetStatistics },
+};
+
+static_assert( sizeof(CommandTable)/sizeof(CommandTable[0]) < COMMAND_TRIE_NO_COMMAND, "static_assert COMMAND_TABLE_SIZE < COMMAND_TRIE_NO_COMMAND" );
+static_assert( sizeof(CommandTable)/sizeof(CommandTable[0]) <= METRICS_COMMAND_TYPES, "static_assert COMMAND_TABLE_SIZE <= METRICS_COMMAND_TYPES" );
+
 //---------------------------------------------------------------------------------------------------
 // Function definitions
 //---------------------------------------------------------------------------------------------------
@@ -61,394 +262,1205 @@ static int32_t parseHexadecimal3DigitsArgument( uint16_t *Result, char *TextPtr,
 /// @brief This function initializes variables of this module
 void initializeRstlProtocol(void){
 	atomic_store_explicit( &UserSelectedChannel, 0, memory_order_release );
+	initializeSession( &UartSession, "uart", &UartTransport, NULL );
+	initializeSession( &UsbSession, "usb", &StreamTransport, &UsbLink );
+	ActiveSessionPtr = &UartSession;
 	for (uint8_t J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++){
-		atomic_store_explicit( &UserSetpointDacValue[J], OFFSET_IN_DAC_UNITS, memory_order_release );
-		WrittenToDacValue[J] = OFFSET_IN_DAC_UNITS;
+		atomic_store_explicit( &UserSetpointDacValue[J], getDacZeroOffset( J ), memory_order_release );
+		WrittenToDacValue[J] = getDacZeroOffset( J );
+	}
+	initializeOrderQueue();
+
+	clearCommandTrie();
+	for (uint8_t J = 0; J < COMMAND_TABLE_SIZE; J++){
+		bool IsAdded = addCommandToTrie( CommandTable[J].Name, J );
+		assert( IsAdded );
+		(void)IsAdded;
 	}
-	atomic_store_explicit( &OrderCode, ORDER_NONE, memory_order_release );
-	atomic_store_explicit( &OrderChannel, 0, memory_order_release );
 }
 
 /// @brief This function is called in the main loop
+/// The sessions are served one after another; a frame is executed completely (and its orders are placed)
+/// before the frame of the other session.
 void driveUserInterface(void){
 #if SEND_I2C_ERROR_MESSAGE_ASYNCHRONOUSLY == 1
 	if (atomic_load_explicit( &I2cErrorsDisplay, memory_order_acquire )){
 		atomic_store_explicit( &I2cErrorsDisplay, false, memory_order_release );
-		transmitViaSerialPort("\r\nI2C ERROR !\r\n>");
+		for (uint8_t J = 0; J < NUMBER_OF_SESSIONS; J++){
+			Sessions[J]->IsI2cErrorPending = true;
+		}
 	}
 #endif
-	if (atomic_load_explicit( &OrderCode, memory_order_acquire ) == ORDER_ACCEPTED){
-		atomic_store_explicit( &OrderCode, ORDER_NONE, memory_order_release );
+#if SEND_SETTLED_MESSAGE_ASYNCHRONOUSLY == 1
+	uint16_t TemporarySettledChannels = atomic_exchange_explicit( &SettledChannels, 0, memory_order_acq_rel );
+	for (uint8_t J = 0; J < NUMBER_OF_SESSIONS; J++){
+		Sessions[J]->PendingSettledChannels |= TemporarySettledChannels;
 	}
-	bool NewCommandIsReady = serialPortReceiver();
-	if (NewCommandIsReady){
-		executeCommand();
+#endif
+	for (uint8_t J = 0; J < NUMBER_OF_SESSIONS; J++){
+		serveSession( Sessions[J] );
 	}
 }
 
-/// @brief This function executes the command stored in NewCommand buffer
-/// @return value from enum CommandErrors
-CommandErrors executeCommand(void){
-	char ResponseBuffer[LONGEST_RESPONSE_LENGTH];
-	CommandErrors ErrorCode = COMMAND_PROPER;
-	int32_t ParsingResult = 0;
-	int CommadLength = strlen( NewCommand );
-
-	if (CommadLength < 3){
-		ErrorCode = COMMAND_INCORRECT_FORMAT;
+static void serveSession( RstlSession *SessionPtr ){
+	ActiveSessionPtr = SessionPtr;
+	superviseBinaryMode( SessionPtr );
+	sendAsynchronousMessages( SessionPtr );
+	sendTelemetry( SessionPtr );
+	const char *FrameText;
+	uint16_t FrameLength;
+	bool NewCommandIsReady = receiveSessionFrame( SessionPtr, &FrameText, &FrameLength );
+	if (NewCommandIsReady){
+		CommandErrors ErrorCode = isSessionInBinaryMode( SessionPtr )?
+				executeBinaryFrame( SessionPtr, (const uint8_t*)FrameText, FrameLength ) :
+				executeCommand( SessionPtr, FrameText, FrameLength );
+		if (COMMAND_PROPER == ErrorCode){
+			confirmSessionBaudRate( SessionPtr );	// a proper command has been received at the new baud rate (if changed)
+		}
 	}
+}
 
-	if (strstr(NewCommand, "PC") == NewCommand){ // Program Current command
-		float CommandFloatingPointArgument = 22222.2;
-		int16_t ValueInDacUnits = 22222; // value in the case of failure (out of range)
-		ParsingResult = parseFloatArgument( &CommandFloatingPointArgument, NewCommand+2, '\r' );
-		if ((ParsingResult < 0) || (CommadLength != 2+ParsingResult+2 ) ||
-				(NewCommand[CommadLength-2] != '\r') || (NewCommand[CommadLength-1] != '\n'))
-		{
-			ErrorCode = COMMAND_INCORRECT_SYNTAX;
+static void sendAsynchronousMessages( RstlSession *SessionPtr ){
+	if (SessionPtr->IsI2cErrorPending){
+		if (0 == transmitSessionText( SessionPtr, "\r\nI2C ERROR !\r\n>" )){
+			SessionPtr->IsI2cErrorPending = false;
 		}
-		else{
-			if ((CommandFloatingPointArgument < -COMMAND_FLOATING_POINT_VALUE_LIMIT) ||
-					(CommandFloatingPointArgument > COMMAND_FLOATING_POINT_VALUE_LIMIT))
-			{
-				ErrorCode = COMMAND_INCORRECT_ARGUMENT;
-			}
-			else{
-				if (atomic_load_explicit( &OrderCode, memory_order_acquire ) == ORDER_NONE){
-					uint16_t TemporaryState = atomic_load_explicit(&PsuState, memory_order_acquire);
-					// proper syntax; command: power up
-					if (PSU_RUNNING == TemporaryState){
-						// essential action
-						ValueInDacUnits = (int16_t)round(CommandFloatingPointArgument * AMPERES_TO_DAC_COEFFICIENT);
-						ValueInDacUnits += OFFSET_IN_DAC_UNITS;
-						if (ValueInDacUnits < 0){
-							ValueInDacUnits = 0;
-						}
-						if (FULL_SCALE_IN_DAC_UNITS < ValueInDacUnits){
-							ValueInDacUnits = FULL_SCALE_IN_DAC_UNITS;
-						}
-						uint16_t TemporarySelectedChannel = atomic_load_explicit(&UserSelectedChannel, memory_order_acquire);
-						if (TemporarySelectedChannel < NUMBER_OF_POWER_SUPPLIES){
-							atomic_store_explicit( &UserSetpointDacValue[TemporarySelectedChannel], ValueInDacUnits, memory_order_release );
-						}
-						atomic_store_explicit( &OrderCode, ORDER_COMMAND_PC, memory_order_release );
-						atomic_store_explicit( &OrderChannel, TemporarySelectedChannel, memory_order_release );
-						transmitViaSerialPort(">");
-					}
-					else{
-						ErrorCode = COMMAND_INVOKED_IN_INCONSISTENT_STATE;
-					}
-				}
-				else{
-					ErrorCode = COMMAND_OUT_OF_SERVICE;
-				}
+	}
+	if (0 != SessionPtr->PendingSettledChannels){
+		// one message for all the channels, e.g. "SETTLED 1 3"
+		char MessageBuffer[16+2*NUMBER_OF_POWER_SUPPLIES];
+		TextBuffer Message;
+		initializeTextBuffer( &Message, MessageBuffer, sizeof(MessageBuffer) );
+		appendText( &Message, "\r\nSETTLED" );
+		for (uint8_t J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++){
+			if (0 != (SessionPtr->PendingSettledChannels & (1u << J))){
+				appendCharacter( &Message, ' ' );
+				appendUnsigned( &Message, (uint32_t)J+1 );
 			}
 		}
-		printf( "%s\tPC\t%u\tE=%d\t%d\t0x%04X\t%d\n",
-				timeTextForDebugging(),
-				(unsigned)atomic_load_explicit(&UserSelectedChannel, memory_order_acquire)+1,
-				ErrorCode,
-				ValueInDacUnits-OFFSET_IN_DAC_UNITS, ValueInDacUnits,
-				ParsingResult );
-	}
-	else if (strstr(NewCommand, "?PC") == NewCommand){ // "Get set-point value of current" command
-		uint16_t TemporarySelectedChannel = atomic_load_explicit(&UserSelectedChannel, memory_order_acquire);
-		if ((CommadLength != 3+2) || (NewCommand[CommadLength-2] != '\r') || (NewCommand[CommadLength-1] != '\n')){
-			ErrorCode = COMMAND_INCORRECT_SYNTAX;
-		}
-		else{
-			// essential action
-			float TemporaryUserSetpoint = (float)atomic_load_explicit( &UserSetpointDacValue[TemporarySelectedChannel], memory_order_acquire );
-			TemporaryUserSetpoint -= (float)OFFSET_IN_DAC_UNITS;
-			TemporaryUserSetpoint *= DAC_TO_AMPERES_COEFFICIENT;
-			snprintf( ResponseBuffer, COMMAND_BUFFER_LENGTH-1, "%.2f\r\n>", TemporaryUserSetpoint );
-			transmitViaSerialPort( ResponseBuffer );
-		}
-		printf( "cmd ?PC\tE=%d\tch=%u\t0x%04X\n", ErrorCode,
-				(unsigned)TemporarySelectedChannel+1,
-				atomic_load_explicit( &UserSetpointDacValue[TemporarySelectedChannel], memory_order_acquire ) );
-	}
-	else if (strstr(NewCommand, "Z") == NewCommand){ // "Select channel" command
-		uint8_t TemporaryChannel;
-		ParsingResult = parseOneDigitArgument( &TemporaryChannel, NewCommand+1, '\r' );
-		if ((ParsingResult < 0) || (CommadLength != 1+ParsingResult+2 ) ||
-				(NewCommand[CommadLength-2] != '\r') || (NewCommand[CommadLength-1] != '\n'))
-		{
-			ErrorCode = COMMAND_INCORRECT_SYNTAX;
+		appendText( &Message, "\r\n>" );
+		if (0 == transmitSessionText( SessionPtr, MessageBuffer )){
+			SessionPtr->PendingSettledChannels = 0;	// otherwise the transmitter is busy; try again later
 		}
-		else{
-			if ((0 == TemporaryChannel) || (TemporaryChannel > NUMBER_OF_POWER_SUPPLIES)){
-				ErrorCode = COMMAND_INCORRECT_ARGUMENT;
-			}
-			else{
-				// essential action
-				atomic_store_explicit( &UserSelectedChannel, TemporaryChannel-1, memory_order_release );
-				transmitViaSerialPort(">");
+	}
+}
+
+static void sendTelemetry( RstlSession *SessionPtr ){
+	if ((0 == SessionPtr->TelemetryPeriodInMilliseconds) || isSessionInBinaryMode( SessionPtr )){
+		return;
+	}
+	uint64_t Now = time_us_64();
+	if ((Now < SessionPtr->NextTelemetryTime) || !isSessionIdle( SessionPtr )){
+		return;
+	}
+	// the frames are not sent in bursts after a pause
+	SessionPtr->NextTelemetryTime += 1000ull * SessionPtr->TelemetryPeriodInMilliseconds;
+	if (SessionPtr->NextTelemetryTime <= Now){
+		SessionPtr->NextTelemetryTime = Now + 1000ull * SessionPtr->TelemetryPeriodInMilliseconds;
+	}
+
+	PsuSnapshot Snapshot;
+	TripReport Report;
+	takePsuSnapshot( &Snapshot );
+	getTripReport( &Report );
+
+	char FrameBuffer[TELEMETRY_LENGTH];
+	TextBuffer Frame;
+	initializeTextBuffer( &Frame, FrameBuffer, sizeof(FrameBuffer) );
+	appendText( &Frame, "\r\nTELE " );
+	appendUnsigned( &Frame, (uint32_t)(Now / 1000) );
+	appendText( &Frame, " S=" );
+	appendPaddedUnsigned( &Frame, Snapshot.PsuState, 2, '0' );
+	appendText( &Frame, " U=" );
+	appendHexadecimal( &Frame, Snapshot.UartError & 0xFF, 2 );
+	appendText( &Frame, " I=" );
+	appendPaddedUnsigned( &Frame, (Snapshot.I2cConsecutiveErrors > 999)? 999 : Snapshot.I2cConsecutiveErrors, 3, '0' );
+	appendCharacter( &Frame, '/' );
+	appendPaddedUnsigned( &Frame, (Snapshot.I2cMaxConsecutiveErrors > 999)? 999 : Snapshot.I2cMaxConsecutiveErrors, 3, '0' );
+	appendText( &Frame, " T=" );
+	appendUnsigned( &Frame, Report.FaultCode % 10 );
+	for (uint8_t J = 0; J < NUMBER_OF_INSTALLED_PSU; J++){
+		appendCharacter( &Frame, ' ' );
+		appendUnsigned( &Frame, (uint32_t)J+1 );
+		appendCharacter( &Frame, ' ' );
+		appendMicroUnits( &Frame, convertDacValueToMicroAmperes( J, Snapshot.UserSetpointDacValue[J] ), MICRO_UNITS_DECIMAL_DIGITS );
+		appendCharacter( &Frame, ' ' );
+		appendMicroUnits( &Frame, Snapshot.MeasuredMicroVolts[J], MICRO_UNITS_DECIMAL_DIGITS );
+	}
+	appendText( &Frame, "\r\n>" );
+	transmitSessionUnsolicited( SessionPtr, FrameBuffer );
+}
+
+/// @brief This function executes the commands of a text frame
+/// The frame is interpreted in place (in the line store of the link); it holds one command or several commands separated by ';' (e.g. "1:PC 1.5;2:PC -0.5\r\n"), which are
+/// executed in order until the first error. The responses are combined and followed by a single prompt '>';
+/// an error is reported as "Error <code>" (or "Error <code> @<number of the command>" in a batch).
+/// The PC orders of a batch are placed together at the end of the frame, so that all the ramps start at once.
+/// The batch is not a transaction: the commands before the failed one keep their effects, except the PC commands
+/// whose order has not been placed yet (it is placed at the end of the frame, or earlier by a POWER or CALZ command):
+/// their setpoints are dropped (UserSetpointDacValue is not changed), so the ramps they have asked for do not start.
+/// @return value from enum CommandErrors
+CommandErrors executeCommand( RstlSession *SessionPtr, const char *FrameText, uint16_t FrameLength ){
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	uint8_t CommandNumber = 0;
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+
+	ActiveSessionPtr = SessionPtr;
+	startSessionResponse( SessionPtr );
+	if (FrameLength < COMMAND_MINIMAL_LENGTH){
+		ErrorCode = COMMAND_INCORRECT_FORMAT;
+		startCommandDebugLine( &Line, DebugLine, "format", ErrorCode );
+		finishDebugLine( &Line );
+	}
+	else{
+		const char *CommandPtr = FrameText;
+		while (NULL != CommandPtr){
+			CommandNumber++;
+			ErrorCode = executeSingleCommand( CommandPtr, FrameText+FrameLength, &CommandPtr );
+			if ((COMMAND_PROPER != ErrorCode) || isSessionInBinaryMode( SessionPtr )){
+				break;	// the rest of the batch is not executed
 			}
 		}
-		printf( "cmd Z\tE=%d\tch=%u\n", ErrorCode,
-				(unsigned)atomic_load_explicit(&UserSelectedChannel, memory_order_acquire)+1 );
 	}
-	else if (strstr(NewCommand, "?Z") == NewCommand){ // "Get selected channel number" command
-		if ((CommadLength != 2+2) || (NewCommand[CommadLength-2] != '\r') || (NewCommand[CommadLength-1] != '\n')){
-			ErrorCode = COMMAND_INCORRECT_SYNTAX;
+	if (COMMAND_PROPER == ErrorCode){
+		placePendingCurrentsOrder();
+	}
+	else{
+		SessionPtr->PendingCurrentsMask = 0;	// the setpoints have not been stored, so the PC commands have no effect
+	}
+
+	if (COMMAND_PROPER != ErrorCode){
+		char ErrorBuffer[LONGEST_RESPONSE_LENGTH];
+		TextBuffer Response;
+		initializeTextBuffer( &Response, ErrorBuffer, sizeof(ErrorBuffer) );
+		appendText( &Response, "Error " );
+		appendUnsigned( &Response, ErrorCode );
+		if (CommandNumber > 1){
+			appendText( &Response, " @" );
+			appendUnsigned( &Response, CommandNumber );
 		}
-		else{
-			// essential action
-			snprintf( ResponseBuffer, COMMAND_BUFFER_LENGTH-1, "Z=%u\r\n>",
-					(unsigned)(atomic_load_explicit(&UserSelectedChannel, memory_order_acquire)+1) );
-			transmitViaSerialPort( ResponseBuffer );
+		appendText( &Response, "\r\n" );
+		appendResponse( ErrorBuffer );
+	}
+	finishSessionResponse( SessionPtr );
+	return ErrorCode;
+}
+
+static CommandErrors executeSingleCommand( const char *CommandText, const char *FrameEnd, const char **NextCommandPtr ){
+	char ResponseBuffer[LONGEST_RESPONSE_LENGTH];
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	uint8_t NameLength = 0;
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+
+	// the optional channel prefix, e.g. "2:PC 1.5" (the channel selected by Z is not changed)
+	uint8_t ChannelPrefix = 0;
+	bool HasChannelPrefix = (FrameEnd - CommandText >= 2) &&
+			(CommandText[0] >= '0') && (CommandText[0] <= '9') && (':' == CommandText[1]);
+	if (HasChannelPrefix){
+		ChannelPrefix = (uint8_t)(CommandText[0] - '0');
+		CommandText += 2;
+	}
+	uint8_t CommandIndex = findCommandInTrie( CommandText, (uint16_t)(FrameEnd - CommandText), &NameLength );
+
+	*NextCommandPtr = NULL;
+	if (COMMAND_TRIE_NO_COMMAND == CommandIndex){
+		ErrorCode = COMMAND_UNKNOWN;
+		initializeTextBuffer( &Line, DebugLine, sizeof(DebugLine) );
+		appendText( &Line, "cmd ???\t" );
+		for (const char *CharacterPtr = CommandText; CharacterPtr < FrameEnd; CharacterPtr++){
+			appendCharacter( &Line, (*CharacterPtr >= ' ')? *CharacterPtr : '~' );
 		}
-		printf( "cmd ?Z\tE=%d\tch=%u\n", ErrorCode,
-				(unsigned)atomic_load_explicit(&UserSelectedChannel, memory_order_acquire)+1 );
-	}
-	else if (strstr(NewCommand, "POWER") == NewCommand){ // "Switch power on/off" command
-		uint8_t TemporaryPowerArgument;
-		ParsingResult = parseOneDigitArgument( &TemporaryPowerArgument, NewCommand+5, '\r' );
-		if ((ParsingResult < 0) || (CommadLength != 5+ParsingResult+2 ) ||
-				(NewCommand[CommadLength-2] != '\r') || (NewCommand[CommadLength-1] != '\n'))
-		{
-			ErrorCode = COMMAND_INCORRECT_SYNTAX;
+		finishDebugLine( &Line );
+		return ErrorCode;
+	}
+
+	// the command ends with ';' (the next command follows) or with "\r\n" (the end of the frame);
+	// the argument parsers stop at EndPtr, so nothing beyond the frame is read
+	const char *ArgumentPtr = CommandText+NameLength;
+	const char *EndPtr = ArgumentPtr;
+	while ((EndPtr < FrameEnd) && (';' != *EndPtr) && ('\r' != *EndPtr)){
+		EndPtr++;
+	}
+	char EndMark = (EndPtr < FrameEnd)? *EndPtr : 0;
+	const CommandDescriptor *CommandPtr = &CommandTable[CommandIndex];
+	CommandArgument Argument = { 0 };
+	int32_t ParsingResult = parseCommandArgument( CommandPtr, &Argument, ArgumentPtr, EndPtr );
+	bool IsProperlyEnded = (';' == EndMark) ||
+			(('\r' == EndMark) && (EndPtr+2 == FrameEnd) && ('\n' == EndPtr[1]));
+
+	if ((ParsingResult < 0) || (ArgumentPtr+ParsingResult != EndPtr) || !IsProperlyEnded ||
+			(HasChannelPrefix && !CommandPtr->IsChannelScoped))
+	{
+		ErrorCode = COMMAND_INCORRECT_SYNTAX;
+	}
+	else if (HasChannelPrefix && ((0 == ChannelPrefix) || (ChannelPrefix > NUMBER_OF_POWER_SUPPLIES))){
+		ErrorCode = COMMAND_INCORRECT_ARGUMENT;
+	}
+	else if ((ANY_PSU_STATE != CommandPtr->RequiredState) &&
+			(CommandPtr->RequiredState != atomic_load_explicit(&PsuState, memory_order_acquire)))
+	{
+		ErrorCode = COMMAND_INVOKED_IN_INCONSISTENT_STATE;
+	}
+	else{
+		Argument.Channel = HasChannelPrefix? (uint16_t)(ChannelPrefix-1) : ActiveSessionPtr->SelectedChannel;
+		uint32_t StartTime = time_us_32();
+		ErrorCode = CommandPtr->Handler( &Argument, ResponseBuffer );
+		recordCommand( CommandIndex, time_us_32() - StartTime );
+		if (';' == EndMark){
+			*NextCommandPtr = EndPtr+1;
 		}
-		else{
-			if (TemporaryPowerArgument > 1){
-				ErrorCode = COMMAND_INCORRECT_ARGUMENT;
-			}
-			else{
-				// essential action
-				int TemporaryState = atomic_load_explicit(&PsuState, memory_order_acquire);
-				if (1 == TemporaryPowerArgument){
-					// proper syntax; command: power up
-					if (PSU_STOPPED == TemporaryState){
-						atomic_store_explicit( &OrderCode, ORDER_COMMAND_POWER_UP, memory_order_release );
-						transmitViaSerialPort(">");
-					}
-					else{
-						ErrorCode = COMMAND_INVOKED_IN_INCONSISTENT_STATE;
-					}
-				}
-				else{
-					// proper syntax; command: power down
-					if (PSU_RUNNING == TemporaryState){
-						atomic_store_explicit( &OrderCode, ORDER_COMMAND_POWER_DOWN, memory_order_release );
-						transmitViaSerialPort(">");
-					}
-					else{
-						ErrorCode = COMMAND_INVOKED_IN_INCONSISTENT_STATE;
-					}
-				}
+	}
+	if ((COMMAND_INCORRECT_SYNTAX == ErrorCode) || (COMMAND_INVOKED_IN_INCONSISTENT_STATE == ErrorCode)){
+		startCommandDebugLine( &Line, DebugLine, CommandPtr->Name, ErrorCode );
+		appendCharacter( &Line, '\t' );
+		appendSigned( &Line, ParsingResult );
+		finishDebugLine( &Line );
+	}
+	return ErrorCode;
+}
+
+static int32_t parseCommandArgument( const CommandDescriptor *CommandPtr, CommandArgument *ArgumentPtr, const char *TextPtr, const char *EndPtr ){
+	switch( CommandPtr->Grammar ){
+	case ARGUMENT_NONE:
+		return 0;
+
+	case ARGUMENT_DECIMAL:
+		return parseDecimalArgument( &ArgumentPtr->MicroUnits, TextPtr, EndPtr );
+
+	case ARGUMENT_ONE_DIGIT:
+		return parseOneDigitArgument( &ArgumentPtr->Digit, TextPtr, EndPtr );
+
+	case ARGUMENT_UNSIGNED:
+		return parseUnsignedArgument( &ArgumentPtr->Unsigned, TextPtr, EndPtr, CommandPtr->DigitsLimit );
+
+	default:
+		return -1;
+	}
+}
+
+static void startCommandDebugLine( TextBuffer *LinePtr, char *DebugLine, const char *Name, CommandErrors ErrorCode ){
+	initializeTextBuffer( LinePtr, DebugLine, DEBUG_LINE_LENGTH );
+	appendText( LinePtr, "cmd " );
+	appendText( LinePtr, Name );
+	appendText( LinePtr, "\tE=" );
+	appendUnsigned( LinePtr, ErrorCode );
+}
+
+static void appendChannelForDebugging( TextBuffer *LinePtr, uint16_t Channel ){
+	appendText( LinePtr, "\tch=" );
+	appendUnsigned( LinePtr, (uint32_t)Channel+1 );
+}
+
+static void finishDebugLine( TextBuffer *LinePtr ){
+	appendCharacter( LinePtr, '\n' );
+	printDebugText( LinePtr->Buffer );
+}
+
+/// @brief This function sets the set-point values of current and orders the ramps
+CommandErrors programCurrents( uint16_t ChannelMask, const int32_t *MicroAmperes ){
+	if ((0 == ChannelMask) || (0 != (ChannelMask >> NUMBER_OF_POWER_SUPPLIES))){
+		return COMMAND_INCORRECT_ARGUMENT;
+	}
+	uint8_t NumberOfValues = 0;
+	for (uint8_t J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++){
+		if (0 != (ChannelMask & (1u << J))){
+			if ((MicroAmperes[NumberOfValues] < -SETPOINT_LIMIT_IN_MICROAMPERES) ||
+					(MicroAmperes[NumberOfValues] > SETPOINT_LIMIT_IN_MICROAMPERES))
+			{
+				return COMMAND_INCORRECT_ARGUMENT;
 			}
+			NumberOfValues++;
 		}
-		printf( "cmd pow %d\tE=%d\n", TemporaryPowerArgument, ErrorCode );
 	}
-	else if (strstr(NewCommand, "?POWER") == NewCommand){ // "Get state of power switch" command
-		if ((CommadLength != 6+2) || (NewCommand[CommadLength-2] != '\r') || (NewCommand[CommadLength-1] != '\n')){
-			ErrorCode = COMMAND_INCORRECT_SYNTAX;
+	if (!reserveOrderSlot()){
+		return COMMAND_QUEUE_FULL;	// the order queue is full
+	}
+
+	NumberOfValues = 0;
+	for (uint8_t J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++){
+		if (0 != (ChannelMask & (1u << J))){
+			atomic_store_explicit( &UserSetpointDacValue[J],
+					(int16_t)convertMicroAmperesToDacValue( J, MicroAmperes[NumberOfValues] ), memory_order_release );
+			NumberOfValues++;
 		}
-		else{
-			// essential action
-			if (atomic_load_explicit( &IsMainContactorStateOn, memory_order_acquire )){
-				transmitViaSerialPort( "1\r\n>" );
-			}
-			else{
-				transmitViaSerialPort( "0\r\n>" );
+	}
+	placeProgramCurrentOrder( ChannelMask );
+	return COMMAND_PROPER;
+}
+
+static void placePendingCurrentsOrder(void){
+	if (0 != ActiveSessionPtr->PendingCurrentsMask){
+		for (uint8_t J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++){
+			if (0 != (ActiveSessionPtr->PendingCurrentsMask & (1u << J))){
+				atomic_store_explicit( &UserSetpointDacValue[J], PendingSetpointDacValue[J], memory_order_release );
 			}
 		}
-		if (atomic_load_explicit( &IsMainContactorStateOn, memory_order_acquire )){
-			printf( "cmd ?pw\tE=%d\tch=%u\tpower on\n", ErrorCode,
-					(unsigned)atomic_load_explicit(&UserSelectedChannel, memory_order_acquire)+1 );
-		}
-		else{
-			printf( "cmd ?pw\tE=%d\tch=%u\tpower off\n", ErrorCode,
-					(unsigned)atomic_load_explicit(&UserSelectedChannel, memory_order_acquire)+1 );
-		}
+		// the slot has been reserved by the first PC command of the batch (no other order has been placed meanwhile)
+		placeProgramCurrentOrder( ActiveSessionPtr->PendingCurrentsMask );
+		ActiveSessionPtr->PendingCurrentsMask = 0;
 	}
-	else if (strstr(NewCommand, "MC") == NewCommand){ // "Measure current" command
-		if ((CommadLength != 2+2) || (NewCommand[CommadLength-2] != '\r') || (NewCommand[CommadLength-1] != '\n')){
-			ErrorCode = COMMAND_INCORRECT_SYNTAX;
-		}
-		else{
-			// essential action
-			snprintf( ResponseBuffer, COMMAND_BUFFER_LENGTH-1, "V=%f\r\n>",
-					getVoltage( atomic_load_explicit(&UserSelectedChannel, memory_order_acquire)>0? 1 : 0 ) );
-			transmitViaSerialPort( ResponseBuffer );
+}
+
+static void placeProgramCurrentOrder( uint16_t ChannelMask ){
+	uint8_t NumberOfChannels = 0;
+	uint16_t Channel = 0;
+	for (uint8_t J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++){
+		if (0 != (ChannelMask & (1u << J))){
+			NumberOfChannels++;
+			Channel = J;
 		}
-		printf( "cmd MC\tE=%d\tch=%u\n", ErrorCode,
-				(unsigned)atomic_load_explicit(&UserSelectedChannel, memory_order_acquire)+1 );
 	}
-	else if (strstr(NewCommand, "VERSION") == NewCommand){ // "Get info about the current version" command
-		if ((CommadLength != 7+2) || (NewCommand[CommadLength-2] != '\r') || (NewCommand[CommadLength-1] != '\n')){
-			ErrorCode = COMMAND_INCORRECT_SYNTAX;
-		}
-		else{
-			// essential action
-			snprintf( ResponseBuffer, COMMAND_BUFFER_LENGTH-1, "ver. %s\r\n>", CompilationTime );
-			transmitViaSerialPort( ResponseBuffer );
-		}
-		printf( "cmd ver\tE=%d\tch=%u\tver. %s\n", ErrorCode,
-				(unsigned)atomic_load_explicit(&UserSelectedChannel, memory_order_acquire)+1,
-				CompilationTime );
+	bool IsPlaced = (1 == NumberOfChannels)?
+			pushOrder( ORDER_COMMAND_PC, Channel, NULL ) : pushOrder( ORDER_COMMAND_PC_CHANNELS, ChannelMask, NULL );
+	assert( IsPlaced );	// the slot has been reserved
+	(void)IsPlaced;
+}
+
+static void appendResponse( const char *Text ){
+	appendSessionResponse( ActiveSessionPtr, Text );
+}
+
+/// @brief This function orders power up (1) or power down (0)
+CommandErrors switchPower( uint8_t PowerOn ){
+	if (PowerOn > 1){
+		return COMMAND_INCORRECT_ARGUMENT;
 	}
-	else if (strstr(NewCommand, "ST") == NewCommand){ // "Get Status" command
-		if ((CommadLength != 2+2) || (NewCommand[CommadLength-2] != '\r') || (NewCommand[CommadLength-1] != '\n')){
-			ErrorCode = COMMAND_INCORRECT_SYNTAX;
-		}
-		else{
-			// essential action
-			snprintf( ResponseBuffer, COMMAND_BUFFER_LENGTH-1, "sig2%s i2c %u %u uart %X fsm %u\r\n>",
-					convertSig2TableToText(),
-					(unsigned)atomic_load_explicit(&I2cConsecutiveErrors, memory_order_acquire),
-					(unsigned)atomic_load_explicit(&I2cMaxConsecutiveErrors, memory_order_acquire),
-					(unsigned)atomic_load_explicit(&UartError, memory_order_acquire),
-					(unsigned)atomic_load_explicit(&PsuState, memory_order_acquire));
-			transmitViaSerialPort( ResponseBuffer );
+	int TemporaryState = atomic_load_explicit(&PsuState, memory_order_acquire);
+	if (1 == PowerOn){
+		// power up
+		if ((PSU_STOPPED != TemporaryState) || isTripLatched()){
+			return COMMAND_INVOKED_IN_INCONSISTENT_STATE;
 		}
-		printf( "cmd st E=%d\n", ErrorCode );
 	}
-	else if (strstr(NewCommand, "RE") == NewCommand){ // "Reset Errors" command
-		if ((CommadLength != 2+2) || (NewCommand[CommadLength-2] != '\r') || (NewCommand[CommadLength-1] != '\n')){
-			ErrorCode = COMMAND_INCORRECT_SYNTAX;
-		}
-		else{
-			// essential action
-			atomic_store_explicit( &I2cConsecutiveErrors, 0, memory_order_release );
-			atomic_store_explicit( &I2cMaxConsecutiveErrors, 0, memory_order_release );
-			atomic_store_explicit( &UartError, 0, memory_order_release );
-			transmitViaSerialPort( "Resetting errors\r\n>" );
+	else{
+		// power down
+		if (PSU_RUNNING != TemporaryState){
+			return COMMAND_INVOKED_IN_INCONSISTENT_STATE;
 		}
-		printf( "cmd re E=%d\n", ErrorCode );
+	}
+	placePendingCurrentsOrder();	// the ramps ordered earlier in the batch go first
+	if (!reserveOrderSlot()){
+		return COMMAND_QUEUE_FULL;	// the order queue is full
+	}
+	pushOrder( (1 == PowerOn)? ORDER_COMMAND_POWER_UP : ORDER_COMMAND_POWER_DOWN, 0, NULL );
+	return COMMAND_PROPER;
+}
+
+/// @brief This function clears the error flags and counters (of I2C, UART, trip monitor, the metrics)
+void resetErrors(void){
+	atomic_store_explicit( &I2cConsecutiveErrors, 0, memory_order_release );
+	atomic_store_explicit( &I2cMaxConsecutiveErrors, 0, memory_order_release );
+	atomic_store_explicit( &UartError, 0, memory_order_release );
+	resetTripMonitor();
+	resetMetrics();
+}
+
+static CommandErrors commandProgramCurrent( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Program Current" command
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	int16_t ValueInDacUnits = 22222; // value in the case of failure (out of range)
+	uint16_t TemporarySelectedChannel = ArgumentPtr->Channel;
+	(void)ResponseBuffer;
+
+	if ((ArgumentPtr->MicroUnits < -SETPOINT_LIMIT_IN_MICROAMPERES) ||
+			(ArgumentPtr->MicroUnits > SETPOINT_LIMIT_IN_MICROAMPERES))
+	{
+		ErrorCode = COMMAND_INCORRECT_ARGUMENT;
+	}
+	else if (!reserveOrderSlot()){
+		ErrorCode = COMMAND_QUEUE_FULL;	// the order queue is full
 	}
 	else{
-		ErrorCode = COMMAND_UNKNOWN;
-		printf( "cmd ???\t" );
-		for (int J=0; NewCommand[J] != 0; J++){
-			printf( "%c", (NewCommand[J] >= ' ')? NewCommand[J] : '~' );
-		}
-		printf( "\n" );
+		// essential action; the order is placed by executeCommand, together with the other PC commands of the batch
+		ValueInDacUnits = (int16_t)convertMicroAmperesToDacValue( TemporarySelectedChannel, ArgumentPtr->MicroUnits );
+		PendingSetpointDacValue[TemporarySelectedChannel] = (uint16_t)ValueInDacUnits;
+		ActiveSessionPtr->PendingCurrentsMask |= 1u << TemporarySelectedChannel;
+		appendResponse( ">" );
 	}
-	if (COMMAND_PROPER != ErrorCode){
-		snprintf( ResponseBuffer, COMMAND_BUFFER_LENGTH-1, "Error %d\r\n>", ErrorCode );
-		transmitViaSerialPort( ResponseBuffer );
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	initializeTextBuffer( &Line, DebugLine, sizeof(DebugLine) );
+	appendTimeForDebugging( &Line );
+	appendText( &Line, "\tPC\t" );
+	appendUnsigned( &Line, (uint32_t)TemporarySelectedChannel+1 );
+	appendText( &Line, "\tE=" );
+	appendUnsigned( &Line, ErrorCode );
+	appendCharacter( &Line, '\t' );
+	appendSigned( &Line, ValueInDacUnits-getDacZeroOffset( TemporarySelectedChannel ) );
+	appendText( &Line, "\t0x" );
+	appendHexadecimal( &Line, (uint16_t)ValueInDacUnits, 4 );
+	finishDebugLine( &Line );
+	return ErrorCode;
+}
+
+static CommandErrors commandGetProgrammedCurrent( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get set-point value of current" command
+	uint16_t TemporarySelectedChannel = ArgumentPtr->Channel;
+	uint16_t TemporarySetpoint = (uint16_t)atomic_load_explicit( &UserSetpointDacValue[TemporarySelectedChannel], memory_order_acquire );
+	if (0 != (ActiveSessionPtr->PendingCurrentsMask & (1u << TemporarySelectedChannel))){
+		TemporarySetpoint = PendingSetpointDacValue[TemporarySelectedChannel];	// set earlier in this batch
 	}
+
+	TextBuffer Response;
+	initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+	appendMicroUnits( &Response, convertDacValueToMicroAmperes( TemporarySelectedChannel, TemporarySetpoint ), 2 );
+	appendText( &Response, "\r\n>" );
+	appendResponse( ResponseBuffer );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "?PC", COMMAND_PROPER );
+	appendChannelForDebugging( &Line, TemporarySelectedChannel );
+	appendText( &Line, "\t0x" );
+	appendHexadecimal( &Line, TemporarySetpoint, 4 );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandSelectChannel( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Select channel" command
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	(void)ResponseBuffer;
+
+	if ((0 == ArgumentPtr->Digit) || (ArgumentPtr->Digit > NUMBER_OF_POWER_SUPPLIES)){
+		ErrorCode = COMMAND_INCORRECT_ARGUMENT;
+	}
+	else{
+		// essential action
+		ActiveSessionPtr->SelectedChannel = ArgumentPtr->Digit-1;
+		atomic_store_explicit( &UserSelectedChannel, ArgumentPtr->Digit-1, memory_order_release );
+		appendResponse( ">" );
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "Z", ErrorCode );
+	appendChannelForDebugging( &Line, ActiveSessionPtr->SelectedChannel );
+	finishDebugLine( &Line );
 	return ErrorCode;
 }
 
-static int32_t parseFloatArgument( float *Result, char *TextPtr, char EndMark ){
-	float FloatArgument;
-	uint8_t CharacterIndex = 0;
-	uint8_t Spaces = 0;
-	uint8_t Pluses = 0;
-	uint8_t Minuses = 0;
-	uint8_t Points = 0;
-	uint8_t DecimalDigits = 0;
-
-	while( CharacterIndex < COMMAND_FLOATING_POINT_MAX_LENGTH ){
-		if (EndMark == TextPtr[CharacterIndex]){
-			if (0 == DecimalDigits){
-				// no digit
-				return -12;
-			}
-			FloatArgument = atof( &TextPtr[Spaces] );
-			*Result = FloatArgument;
-			return CharacterIndex;
-		}
-		else if (' ' == TextPtr[CharacterIndex]){
-			Spaces++;
-			if (Spaces > 1){
-				// too many spaces
-				return -11;
-			}
-			if ((Pluses != 0) || (Minuses != 0) || (DecimalDigits != 0)){
-				// improper position of space
-				return -10;
-			}
-		}
-		else if ('+' == TextPtr[CharacterIndex]){
-			Pluses++;
-			if (Pluses > 1){
-				// too many pluses
-				return -9;
-			}
-			if ((Minuses != 0) || (DecimalDigits != 0)){
-				// improper position of plus
-				return -8;
-			}
-		}
-		else if ('-' == TextPtr[CharacterIndex]){
-			Minuses++;
-			if (Minuses > 1){
-				// too many minuses
-				return -7;
-			}
-			if ((Pluses != 0) || (DecimalDigits != 0)){
-				// improper position of minus
-				return -6;
-			}
-		}
-		else if ('.' == TextPtr[CharacterIndex]){
-			Points++;
-			if (Points > 1){
-				// too many points
-				return -5;
-			}
-			if (0 == DecimalDigits){
-				// improper position of point
-				return -4;
-			}
-		}
-		else if (('0' <= TextPtr[CharacterIndex]) && ('9' >= TextPtr[CharacterIndex])){
-			DecimalDigits++;
-			if (DecimalDigits > COMMAND_FLOATING_POINT_DIGITS_LIMIT){
-				// too many digits
-				return -3;
-			}
+static CommandErrors commandGetSelectedChannel( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get selected channel number" command
+	uint16_t TemporarySelectedChannel = ActiveSessionPtr->SelectedChannel;
+	(void)ArgumentPtr;
+
+	TextBuffer Response;
+	initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+	appendText( &Response, "Z=" );
+	appendUnsigned( &Response, (uint32_t)TemporarySelectedChannel+1 );
+	appendText( &Response, "\r\n>" );
+	appendResponse( ResponseBuffer );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "?Z", COMMAND_PROPER );
+	appendChannelForDebugging( &Line, TemporarySelectedChannel );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandPower( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Switch power on/off" command
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	(void)ResponseBuffer;
+
+	// essential action
+	ErrorCode = switchPower( ArgumentPtr->Digit );
+	if (COMMAND_PROPER == ErrorCode){
+		appendResponse( ">" );
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "pow", ErrorCode );
+	appendCharacter( &Line, '\t' );
+	appendUnsigned( &Line, ArgumentPtr->Digit );
+	finishDebugLine( &Line );
+	return ErrorCode;
+}
+
+static CommandErrors commandGetPower( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get state of power switch" command
+	bool IsPowerOn = atomic_load_explicit( &IsMainContactorStateOn, memory_order_acquire );
+	(void)ArgumentPtr;
+	(void)ResponseBuffer;
+
+	appendResponse( IsPowerOn? "1\r\n>" : "0\r\n>" );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "?pw", COMMAND_PROPER );
+	appendChannelForDebugging( &Line, ActiveSessionPtr->SelectedChannel );
+	appendText( &Line, IsPowerOn? "\tpower on" : "\tpower off" );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandGetRampTime( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get remaining time of the ramp" command
+	uint16_t TemporarySelectedChannel = ArgumentPtr->Channel;
+
+	uint32_t RemainingTime = getRampRemainingTime( TemporarySelectedChannel );
+	TextBuffer Response;
+	initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+	appendText( &Response, "T=" );
+	appendUnsigned( &Response, RemainingTime );
+	appendText( &Response, "\r\n>" );
+	appendResponse( ResponseBuffer );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "?eta", COMMAND_PROPER );
+	appendChannelForDebugging( &Line, TemporarySelectedChannel );
+	appendCharacter( &Line, '\t' );
+	appendUnsigned( &Line, RemainingTime );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandMeasureCurrent( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Measure current" command
+	uint16_t TemporarySelectedChannel = ArgumentPtr->Channel;
+
+	TextBuffer Response;
+	initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+	appendText( &Response, "V=" );
+	appendMicroUnits( &Response, getVoltage( TemporarySelectedChannel ), MICRO_UNITS_DECIMAL_DIGITS );
+	appendText( &Response, "\r\n>" );
+	appendResponse( ResponseBuffer );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "MC", COMMAND_PROPER );
+	appendChannelForDebugging( &Line, TemporarySelectedChannel );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandSetBaudRate( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Set baud rate" command
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	(void)ResponseBuffer;
+
+	if (0 == getSessionBaudRate( ActiveSessionPtr )){
+		ErrorCode = COMMAND_OUT_OF_SERVICE;	// the link has no baud rate (USB)
+	}
+	else if (!setSessionBaudRate( ActiveSessionPtr, ArgumentPtr->Unsigned )){
+		ErrorCode = COMMAND_INCORRECT_ARGUMENT;
+	}
+	else{
+		// the response is sent at the old rate; the master confirms the new rate by any proper command
+		appendResponse( ">" );
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "baud", ErrorCode );
+	appendCharacter( &Line, '\t' );
+	appendUnsigned( &Line, ArgumentPtr->Unsigned );
+	finishDebugLine( &Line );
+	return ErrorCode;
+}
+
+static CommandErrors commandGetBaudRate( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get baud rate" command
+	(void)ArgumentPtr;
+
+	TextBuffer Response;
+	initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+	appendUnsigned( &Response, getSessionBaudRate( ActiveSessionPtr ) );	// 0 if the link has no baud rate
+	appendText( &Response, "\r\n>" );
+	appendResponse( ResponseBuffer );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "?baud", COMMAND_PROPER );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandGetVersion( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get info about the current version" command
+	(void)ArgumentPtr;
+
+	TextBuffer Response;
+	initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+	appendText( &Response, "ver. " );
+	appendText( &Response, CompilationTime );
+	appendText( &Response, "\r\n>" );
+	appendResponse( ResponseBuffer );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "ver", COMMAND_PROPER );
+	appendChannelForDebugging( &Line, ActiveSessionPtr->SelectedChannel );
+	appendText( &Line, "\tver. " );
+	appendText( &Line, CompilationTime );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandGetStatus( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get Status" command
+	(void)ArgumentPtr;
+	PsuSnapshot Snapshot;
+	takePsuSnapshot( &Snapshot );
+
+	TextBuffer Response;
+	initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+	appendText( &Response, "sig2" );
+	for (uint8_t J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++){
+		if (J >= NUMBER_OF_INSTALLED_PSU){
+			appendText( &Response, " --" );
 		}
 		else{
-			// improper character
-			return -2;
+			bool IsSig2Valid = Snapshot.Sig2LastReadings[J][SIG2_IS_VALID_INFORMATION];
+			appendCharacter( &Response, ' ' );
+			appendSig2Reading( &Response, Snapshot.Sig2LastReadings[J][SIG2_FOR_0_DAC_SETTING], IsSig2Valid );
+			appendSig2Reading( &Response, Snapshot.Sig2LastReadings[J][SIG2_FOR_FULL_SCALE_DAC_SETTING], IsSig2Valid );
 		}
-		CharacterIndex++;
 	}
-	// improper length
-	return -1;
+	appendText( &Response, " i2c " );
+	appendUnsigned( &Response, Snapshot.I2cConsecutiveErrors );
+	appendCharacter( &Response, ' ' );
+	appendUnsigned( &Response, Snapshot.I2cMaxConsecutiveErrors );
+	appendText( &Response, " uart " );
+	appendHexadecimal( &Response, Snapshot.UartError, 0 );
+	appendText( &Response, " fsm " );
+	appendUnsigned( &Response, Snapshot.PsuState );
+	appendText( &Response, "\r\n>" );
+	appendResponse( ResponseBuffer );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "st", COMMAND_PROPER );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
 }
 
-static int32_t parseOneDigitArgument( uint8_t *Result, char *TextPtr, char EndMark ){
-	uint8_t UInt8_Argument = 0;
-	uint8_t CharacterIndex = 0;
-	uint8_t Spaces = 0;
-	uint8_t DecimalDigits = 0;
+static CommandErrors commandResetErrors( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Reset Errors" command
+	(void)ArgumentPtr;
+	(void)ResponseBuffer;
 
-	while( CharacterIndex < 3 ){
-		if (EndMark == TextPtr[CharacterIndex]){
-			if (0 == DecimalDigits){
-				// no digit
-				return -5;
-			}
-			*Result = UInt8_Argument;
-			return CharacterIndex;
+	resetErrors();
+	appendResponse( "Resetting errors\r\n>" );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "re", COMMAND_PROPER );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandSetDacZeroOffset( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Set calibration: DAC value for zero current" command
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	uint16_t TemporarySelectedChannel = ArgumentPtr->Channel;
+	(void)ResponseBuffer;
+
+	if ((ArgumentPtr->Unsigned > FULL_SCALE_IN_DAC_UNITS) ||
+			!setDacZeroOffset( TemporarySelectedChannel, (uint16_t)ArgumentPtr->Unsigned ))
+	{
+		ErrorCode = COMMAND_INCORRECT_ARGUMENT;
+	}
+	else{
+		// essential action is done by setDacZeroOffset
+		appendResponse( ">" );
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "cdz", ErrorCode );
+	appendChannelForDebugging( &Line, TemporarySelectedChannel );
+	appendCharacter( &Line, '\t' );
+	appendUnsigned( &Line, getChannelCalibration( TemporarySelectedChannel )->DacZeroOffset );
+	finishDebugLine( &Line );
+	return ErrorCode;
+}
+
+static CommandErrors commandSetDacGain( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Set calibration: DAC gain" command
+	return setCalibrationValue( setDacGain, "cdg", ArgumentPtr, ResponseBuffer );
+}
+
+static CommandErrors commandSetAdcOffset( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Set calibration: ADC offset" command
+	return setCalibrationValue( setAdcOffset, "caz", ArgumentPtr, ResponseBuffer );
+}
+
+static CommandErrors commandSetAdcGain( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Set calibration: ADC gain" command
+	return setCalibrationValue( setAdcGain, "cag", ArgumentPtr, ResponseBuffer );
+}
+
+static CommandErrors setCalibrationValue( bool (*Setter)( uint8_t, int32_t ), const char *DebugName,
+		const CommandArgument *ArgumentPtr, char *ResponseBuffer )
+{
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	uint16_t TemporarySelectedChannel = ArgumentPtr->Channel;
+	(void)ResponseBuffer;
+
+	if (Setter( TemporarySelectedChannel, ArgumentPtr->MicroUnits )){
+		appendResponse( ">" );
+	}
+	else{
+		ErrorCode = COMMAND_INCORRECT_ARGUMENT;
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, DebugName, ErrorCode );
+	appendChannelForDebugging( &Line, TemporarySelectedChannel );
+	appendCharacter( &Line, '\t' );
+	appendSigned( &Line, ArgumentPtr->MicroUnits );
+	finishDebugLine( &Line );
+	return ErrorCode;
+}
+
+static CommandErrors commandCalibrateZero( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Calibrate zero current using Sig2" command
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	(void)ArgumentPtr;
+	(void)ResponseBuffer;
+
+	placePendingCurrentsOrder();	// the ramps ordered earlier in the batch go first
+	if (!reserveOrderSlot()){
+		ErrorCode = COMMAND_QUEUE_FULL;	// the order queue is full
+	}
+	else{
+		// essential action
+		pushOrder( ORDER_COMMAND_CALIBRATE_ZERO, 0, NULL );
+		appendResponse( ">" );
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "calz", ErrorCode );
+	finishDebugLine( &Line );
+	return ErrorCode;
+}
+
+static CommandErrors commandGetZeroCalibration( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get result of zero current calibration" command
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	uint16_t TemporarySelectedChannel = ArgumentPtr->Channel;
+	ZeroCalibrationReport Report;
+
+	if (!getZeroCalibrationReport( TemporarySelectedChannel, &Report )){
+		ErrorCode = COMMAND_OUT_OF_SERVICE;	// the calibration is running
+	}
+	else{
+		// essential action
+		static const char *StatusTexts[] = { "NONE", "RUNNING", "OK", "FAIL" };
+		TextBuffer Response;
+		initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+		appendText( &Response, StatusTexts[Report.Status & 3] );
+		appendText( &Response, " Z=" );
+		appendUnsigned( &Response, Report.ZeroOffset );
+		appendText( &Response, " N=" );
+		appendUnsigned( &Response, Report.DacWrites );
+		appendText( &Response, " T=" );
+		appendUnsigned( &Response, Report.DurationInMilliseconds );
+		appendText( &Response, "\r\n>" );
+		appendResponse( ResponseBuffer );
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "?calz", ErrorCode );
+	appendChannelForDebugging( &Line, TemporarySelectedChannel );
+	finishDebugLine( &Line );
+	return ErrorCode;
+}
+
+static CommandErrors commandGetCalibration( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get calibration data" command
+	uint16_t TemporarySelectedChannel = ArgumentPtr->Channel;
+
+	const ChannelCalibration *CalibrationPtr = getChannelCalibration( TemporarySelectedChannel );
+	TextBuffer Response;
+	initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+	appendText( &Response, "DZ=" );
+	appendUnsigned( &Response, CalibrationPtr->DacZeroOffset );
+	appendText( &Response, " DG=" );
+	appendMicroUnits( &Response, CalibrationPtr->DacGain, MICRO_UNITS_DECIMAL_DIGITS );
+	appendText( &Response, " AZ=" );
+	appendMicroUnits( &Response, CalibrationPtr->AdcOffset, MICRO_UNITS_DECIMAL_DIGITS );
+	appendText( &Response, " AG=" );
+	appendMicroUnits( &Response, CalibrationPtr->AdcGain, MICRO_UNITS_DECIMAL_DIGITS );
+	appendText( &Response, "\r\n>" );
+	appendResponse( ResponseBuffer );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "?cal", COMMAND_PROPER );
+	appendChannelForDebugging( &Line, TemporarySelectedChannel );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandSaveCalibration( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Save calibration data in flash" command
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	(void)ArgumentPtr;
+	(void)ResponseBuffer;
+
+	if (saveCalibration()){
+		appendResponse( ">" );
+	}
+	else{
+		ErrorCode = COMMAND_OUT_OF_SERVICE;	// the flash has not been written
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "csave", ErrorCode );
+	finishDebugLine( &Line );
+	return ErrorCode;
+}
+
+static CommandErrors commandSetTripTolerance( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Set tolerance of the trip monitor" command
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	(void)ResponseBuffer;
+
+	if (!setTripTolerance( ArgumentPtr->MicroUnits )){
+		ErrorCode = COMMAND_INCORRECT_ARGUMENT;
+	}
+	else{
+		// essential action is done by setTripTolerance
+		appendResponse( ">" );
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "triptol", ErrorCode );
+	appendCharacter( &Line, '\t' );
+	appendSigned( &Line, ArgumentPtr->MicroUnits );
+	finishDebugLine( &Line );
+	return ErrorCode;
+}
+
+static CommandErrors commandSetTripTime( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Set time of the trip monitor" command
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	(void)ResponseBuffer;
+
+	if (!setTripTime( ArgumentPtr->Unsigned )){
+		ErrorCode = COMMAND_INCORRECT_ARGUMENT;
+	}
+	else{
+		// essential action is done by setTripTime
+		appendResponse( ">" );
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "triptime", ErrorCode );
+	appendCharacter( &Line, '\t' );
+	appendUnsigned( &Line, ArgumentPtr->Unsigned );
+	finishDebugLine( &Line );
+	return ErrorCode;
+}
+
+static CommandErrors commandGetTrip( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get state of the trip monitor" command
+	(void)ArgumentPtr;
+
+	TripReport Report;
+	getTripReport( &Report );
+	TextBuffer Response;
+	initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+	appendText( &Response, "F=" );
+	appendUnsigned( &Response, Report.FaultCode );
+	appendText( &Response, " CH=" );
+	appendUnsigned( &Response, (uint32_t)Report.Channel+1 );
+	// E: from the start of the violation to zeroing the DAC [ms], Z: from latching the fault to zeroing the DAC [us]
+	// (saturated, so that the response fits in the buffer)
+	appendText( &Response, " E=" );
+	appendUnsigned( &Response, (Report.ViolationToZeroingInMilliseconds > TRIP_LATENCY_SATURATION)?
+			TRIP_LATENCY_SATURATION : Report.ViolationToZeroingInMilliseconds );
+	appendText( &Response, " Z=" );
+	appendUnsigned( &Response, (Report.LatchToZeroingInMicroseconds > TRIP_LATENCY_SATURATION)?
+			TRIP_LATENCY_SATURATION : Report.LatchToZeroingInMicroseconds );
+	appendText( &Response, " I=" );
+	appendMicroUnits( &Response, Report.MeasuredMicroAmperes, 3 );
+	appendText( &Response, " TOL=" );
+	appendMicroUnits( &Response, getTripTolerance(), 3 );
+	appendText( &Response, " T=" );
+	appendUnsigned( &Response, getTripTime() );
+	appendText( &Response, "\r\n>" );
+	appendResponse( ResponseBuffer );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "?trip", COMMAND_PROPER );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandEnterBinaryMode( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Enter binary mode" command; the next frames are interpreted by the rstl_binary module
+	(void)ArgumentPtr;
+	(void)ResponseBuffer;
+
+	appendResponse( ">" );
+	enterBinaryMode( ActiveSessionPtr );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "BIN", COMMAND_PROPER );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandGetOrders( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get state of the order queue" command, e.g. "O=12 C=11 S=0 OVF=0": the number of orders issued and completed,
+	// the status of the last order (a value from enum OrderStatus), the number of orders refused (the queue was full)
+	(void)ArgumentPtr;
+	uint32_t IssuedOrders = getIssuedOrders();
+
+	TextBuffer Response;
+	initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+	appendText( &Response, "O=" );
+	appendUnsigned( &Response, IssuedOrders );
+	appendText( &Response, " C=" );
+	appendUnsigned( &Response, getCompletedOrders() );
+	appendText( &Response, " S=" );
+	appendUnsigned( &Response, getOrderStatus( IssuedOrders-1 ) );
+	appendText( &Response, " OVF=" );
+	appendUnsigned( &Response, getOrderQueueOverflows() );
+	appendText( &Response, "\r\n>" );
+	appendResponse( ResponseBuffer );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "?order", COMMAND_PROPER );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandGetAllStatus( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get state of all channels" command; the values come from one snapshot, the layout is fixed:
+	// "S=<FSM state> P=<contactor> U=<UART errors, hex> I=<I2C errors>/<max I2C errors> T=<trip fault>\r\n", then for each
+	// installed channel: "<n> <user setpoint> <instantaneous setpoint> <written to DAC> (hex) <measured uV>
+	// <Sig2 for DAC 0><Sig2 for full scale><present Sig2> <R = ramp running, - = settled>\r\n"
+	(void)ArgumentPtr;
+	PsuSnapshot Snapshot;
+	TripReport Report;
+	takePsuSnapshot( &Snapshot );
+	getTripReport( &Report );
+
+	TextBuffer Response;
+	initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+	appendText( &Response, "S=" );
+	appendPaddedUnsigned( &Response, Snapshot.PsuState, 2, '0' );
+	appendText( &Response, Snapshot.IsPowerOn? " P=1 U=" : " P=0 U=" );
+	appendHexadecimal( &Response, Snapshot.UartError & 0xFF, 2 );
+	appendText( &Response, " I=" );
+	appendPaddedUnsigned( &Response, (Snapshot.I2cConsecutiveErrors > 999)? 999 : Snapshot.I2cConsecutiveErrors, 3, '0' );
+	appendCharacter( &Response, '/' );
+	appendPaddedUnsigned( &Response, (Snapshot.I2cMaxConsecutiveErrors > 999)? 999 : Snapshot.I2cMaxConsecutiveErrors, 3, '0' );
+	appendText( &Response, " T=" );
+	appendUnsigned( &Response, Report.FaultCode % 10 );
+	appendText( &Response, "\r\n" );
+	appendResponse( ResponseBuffer );
+
+	for (uint8_t J = 0; J < NUMBER_OF_INSTALLED_PSU; J++){
+		int32_t Measurement = Snapshot.MeasuredMicroVolts[J];
+		uint32_t Magnitude = (Measurement < 0)? (uint32_t)0 - (uint32_t)Measurement : (uint32_t)Measurement;
+		bool IsSig2Valid = Snapshot.Sig2LastReadings[J][SIG2_IS_VALID_INFORMATION];
+
+		initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+		appendUnsigned( &Response, (uint32_t)J+1 );
+		appendCharacter( &Response, ' ' );
+		appendHexadecimal( &Response, Snapshot.UserSetpointDacValue[J], 3 );
+		appendCharacter( &Response, ' ' );
+		appendHexadecimal( &Response, Snapshot.InstantaneousSetpointDacValue[J], 3 );
+		appendCharacter( &Response, ' ' );
+		appendHexadecimal( &Response, Snapshot.WrittenToDacValue[J], 3 );
+		appendText( &Response, (Measurement < 0)? " -" : " +" );
+		appendPaddedUnsigned( &Response, (Magnitude > 99999999)? 99999999 : Magnitude, 8, '0' );
+		appendCharacter( &Response, ' ' );
+		appendSig2Reading( &Response, Snapshot.Sig2LastReadings[J][SIG2_FOR_0_DAC_SETTING], IsSig2Valid );
+		appendSig2Reading( &Response, Snapshot.Sig2LastReadings[J][SIG2_FOR_FULL_SCALE_DAC_SETTING], IsSig2Valid );
+		appendSig2Reading( &Response, Snapshot.Sig2PresentReading[J], true );
+		appendText( &Response, Snapshot.IsRampRunning[J]? " R\r\n" : " -\r\n" );
+		appendResponse( ResponseBuffer );
+	}
+	appendResponse( ">" );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "?all", COMMAND_PROPER );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandSetTelemetry( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Set telemetry period" command; 0 stops the telemetry
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	(void)ResponseBuffer;
+
+	uint32_t Period = ArgumentPtr->Unsigned;
+	if ((0 != Period) &&
+			((Period < TELEMETRY_MIN_PERIOD_IN_MILLISECONDS) || (Period > TELEMETRY_MAX_PERIOD_IN_MILLISECONDS)))
+	{
+		ErrorCode = COMMAND_INCORRECT_ARGUMENT;
+	}
+	else{
+		ActiveSessionPtr->TelemetryPeriodInMilliseconds = Period;
+		ActiveSessionPtr->NextTelemetryTime = time_us_64() + 1000ull * Period;	// the first frame follows the response
+		appendResponse( ">" );
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "tele", ErrorCode );
+	appendCharacter( &Line, '\t' );
+	appendUnsigned( &Line, Period );
+	finishDebugLine( &Line );
+	return ErrorCode;
+}
+
+static CommandErrors commandGetTelemetry( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get telemetry period" command
+	(void)ArgumentPtr;
+
+	TextBuffer Response;
+	initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+	appendText( &Response, "TELE=" );
+	appendUnsigned( &Response, ActiveSessionPtr->TelemetryPeriodInMilliseconds );
+	appendText( &Response, "\r\n>" );
+	appendResponse( ResponseBuffer );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "?tele", COMMAND_PROPER );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandSetEcho( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Echo on/off" command; the echo of the command itself has already been sent
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	(void)ResponseBuffer;
+
+	if (ArgumentPtr->Digit > 1){
+		ErrorCode = COMMAND_INCORRECT_ARGUMENT;
+	}
+	else{
+		setSessionEcho( ActiveSessionPtr, 1 == ArgumentPtr->Digit );
+		appendResponse( ">" );
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "echo", ErrorCode );
+	appendCharacter( &Line, '\t' );
+	appendUnsigned( &Line, ArgumentPtr->Digit );
+	finishDebugLine( &Line );
+	return ErrorCode;
+}
+
+static CommandErrors commandGetEcho( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get echo state" command
+	(void)ArgumentPtr;
+	(void)ResponseBuffer;
+
+	appendResponse( isSessionEchoEnabled( ActiveSessionPtr )? "1\r\n>" : "0\r\n>" );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "?echo", COMMAND_PROPER );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandSetDebug( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Debug output on/off" command; the debug lines are sent to the USB port (mixed with the responses of the USB session)
+	CommandErrors ErrorCode = COMMAND_PROPER;
+	(void)ResponseBuffer;
+
+	if (ArgumentPtr->Digit > 1){
+		ErrorCode = COMMAND_INCORRECT_ARGUMENT;
+	}
+	else{
+		setDebugOutput( 1 == ArgumentPtr->Digit );
+		appendResponse( ">" );
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "dbg", ErrorCode );
+	appendCharacter( &Line, '\t' );
+	appendText( &Line, ActiveSessionPtr->Name );
+	finishDebugLine( &Line );
+	return ErrorCode;
+}
+
+static CommandErrors commandGetDebug( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get debug output state" command
+	(void)ArgumentPtr;
+	(void)ResponseBuffer;
+
+	appendResponse( isDebugOutputEnabled()? "1\r\n>" : "0\r\n>" );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "?dbg", COMMAND_PROPER );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static CommandErrors commandGetStatistics( const CommandArgument *ArgumentPtr, char *ResponseBuffer ){
+	// "Get statistics" command: the metrics since the last RE (see metrics.h), e.g.
+	// "i2c=1200 i2cr=0 i2cs=400 rx=35 tx=36 ovf=0 drop=0 baud=115200 ramp=120,80,0,0\r\n", then a line for each
+	// command executed: "<name> <count> <latency histogram>\r\n", e.g. "PC 12 10,2,0,0,0,0\r\n"
+	(void)ArgumentPtr;
+	TextBuffer Response;
+
+	// the items are appended one by one; a long response is sent in parts
+	for (uint8_t J = 0; J < NumberOfMetrics; J++){
+		const MetricDescriptor *MetricPtr = &MetricTable[J];
+		if ((METRIC_COMMANDS == MetricPtr->Index) || (METRIC_COMMAND_LATENCY == MetricPtr->Index)){
+			continue;	// listed per command below
 		}
-		else if (' ' == TextPtr[CharacterIndex]){
-			Spaces++;
-			if (Spaces > 1){
-				// too many spaces
-				return -4;
-			}
+		initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+		if (0 != J){
+			appendCharacter( &Response, ' ' );
 		}
-		else if (('0' <= TextPtr[CharacterIndex]) && ('9' >= TextPtr[CharacterIndex])){
-			DecimalDigits++;
-			if (DecimalDigits > 1){
-				// too many digits
-				return -3;
+		appendText( &Response, MetricPtr->Name );
+		appendCharacter( &Response, '=' );
+		for (uint16_t K = 0; K < MetricPtr->Length; K++){
+			if (0 != K){
+				appendCharacter( &Response, ',' );
 			}
-			UInt8_Argument = (uint8_t)(TextPtr[CharacterIndex] - '0');
+			appendUnsigned( &Response, getMetric( MetricPtr->Index + K ));
 		}
-		else{
-			// improper character
-			return -2;
+		appendResponse( ResponseBuffer );
+	}
+	appendResponse( "\r\n" );
+
+	for (uint8_t J = 0; J < COMMAND_TABLE_SIZE; J++){
+		uint32_t Executions = getMetric( METRIC_COMMANDS + J );
+		if (0 == Executions){
+			continue;
 		}
-		CharacterIndex++;
+		initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+		appendText( &Response, CommandTable[J].Name );
+		appendCharacter( &Response, ' ' );
+		appendUnsigned( &Response, Executions );
+		appendResponse( ResponseBuffer );
+
+		initializeTextBuffer( &Response, ResponseBuffer, LONGEST_RESPONSE_LENGTH );
+		for (uint8_t K = 0; K < METRICS_LATENCY_BUCKETS; K++){
+			appendCharacter( &Response, (0 == K)? ' ' : ',' );
+			appendUnsigned( &Response, getMetric( METRIC_COMMAND_LATENCY + J*METRICS_LATENCY_BUCKETS + K ));
+		}
+		appendText( &Response, "\r\n" );
+		appendResponse( ResponseBuffer );
 	}
-	// improper length
-	return -1;
+	appendResponse( ">" );
+
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	startCommandDebugLine( &Line, DebugLine, "stats", COMMAND_PROPER );
+	finishDebugLine( &Line );
+	return COMMAND_PROPER;
+}
+
+static void appendSig2Reading( TextBuffer *TextPtr, bool Reading, bool IsValid ){
+	appendCharacter( TextPtr, IsValid? (Reading? 'H' : 'L') : '?' );
 }
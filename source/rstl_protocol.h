@@ -2,7 +2,8 @@
 /// @brief This module provides a higher layer of communication with the master unit
 ///
 /// The module acts as a slave. It receives commands from the master unit and
-/// sends the responses.
+/// sends the responses. The commands are received in two sessions at once: via the serial port (UART0, the
+/// production link) and via the USB port (maintenance tools); each session has its own interpreter state (rstl_session.h).
 
 #ifndef SOURCE_RSTL_PROTOCOL_H_
 #define SOURCE_RSTL_PROTOCOL_H_
@@ -10,59 +11,47 @@
 #include <stdatomic.h>
 #include "config.h"
 #include "uart_talks.h"
+#include "rstl_session.h"
+#include "conversions.h"
 
 //---------------------------------------------------------------------------------------------------
 // Macro directives
 //---------------------------------------------------------------------------------------------------
 
-#define COMMAND_BUFFER_LENGTH			(LONGEST_COMMAND_LENGTH+30)
-
+/// The codes of the orders passed to the state machine by the order queue (order_queue.h)
 #define ORDER_NONE						0
-#define ORDER_ACCEPTED					1
 #define ORDER_COMMAND_PCI				2	// Program Current Immediately
 #define ORDER_COMMAND_PC				3	// Program Current (following ramp)
 #define ORDER_COMMAND_POWER_UP			4
 #define ORDER_COMMAND_POWER_DOWN		5
-#define ORDER_COMMAND_ILLEGAL_CODE		6
-
-#define AMPERES_TO_DAC_COEFFICIENT		(4096.0 / 20.0)
-#define DAC_TO_AMPERES_COEFFICIENT		(20.0 / 4096.0)
-#define FULL_SCALE_IN_DAC_UNITS			4095	// 4095 = 0xFFF
+#define ORDER_COMMAND_CALIBRATE_ZERO	6	// Find DAC values for zero current (using Sig2)
+#define ORDER_COMMAND_PC_CHANNELS		7	// Program Current (following ramp) in the channels given by the bit mask
+#define ORDER_COMMAND_ILLEGAL_CODE		8
 
 //---------------------------------------------------------------------------------------------------
 // Constants
 //---------------------------------------------------------------------------------------------------
 
+/// The values are sent to the master ("Error <code>", the status of a binary response), so new values go at the end
 typedef enum CommandErrorsEnum{
 	COMMAND_PROPER,
 	COMMAND_UNKNOWN,
 	COMMAND_INCORRECT_FORMAT,
-	COMMAND_OUT_OF_SERVICE,
+	COMMAND_OUT_OF_SERVICE,					// not available now or on this link (calibration running, flash write failed, BAUD on USB)
 	COMMAND_INCORRECT_SYNTAX,
 	COMMAND_INCORRECT_ARGUMENT,
 	COMMAND_INVOKED_IN_INCONSISTENT_STATE,
+	COMMAND_QUEUE_FULL,						// the order queue is full; the master may repeat the command later
 } CommandErrors;
 
 //---------------------------------------------------------------------------------------------------
 // Global variables
 //---------------------------------------------------------------------------------------------------
 
-/// @brief This buffer is used to pass data from UART
-/// This buffer is filled by the uart_talks module and is interpreted by the rstl_protocol module
-extern char NewCommand[COMMAND_BUFFER_LENGTH];
-
-/// @brief Currently selected (active) power supply unit
-/// All commands related to power supply settings apply to this device
+/// @brief The power supply unit selected by the last Z command (of any session)
+/// Each session applies the commands to its own selected channel; this copy is used by the PSU simulation
 extern atomic_uint_fast16_t UserSelectedChannel;
 
-/// @brief This is a code of an action that cannot be executed immediately but must be processed by a state machine
-/// The variable can be modified in the main loop and in the timer interrupt handler
-extern atomic_uint_fast16_t OrderCode;
-
-/// @brief This is a power supply unit to which OrderCode refers
-/// The variable can be modified in the main loop and in the timer interrupt handler
-extern atomic_uint_fast16_t OrderChannel;
-
 //---------------------------------------------------------------------------------------------------
 // Function prototypes
 //---------------------------------------------------------------------------------------------------
@@ -72,8 +61,28 @@ void initializeRstlProtocol(void);
 
 void driveUserInterface(void);
 
-/// @brief This function executes the command stored in NewCommand buffer
+/// @brief This function executes the commands of a text frame received in the session and sends the response
+/// @param SessionPtr the session that has received the frame
+/// @param FrameText the frame (it need not be terminated by 0; it is not modified)
+/// @param FrameLength the number of characters of the frame, including the terminator "\r\n"
 /// @return value from enum CommandErrors
-CommandErrors executeCommand(void);
+CommandErrors executeCommand( RstlSession *SessionPtr, const char *FrameText, uint16_t FrameLength );
+
+// The actions below are shared by the text commands and the binary mode (rstl_binary module);
+// they check the arguments and place the order, but they send no response
+
+/// @brief This function sets the set-point values of current and orders the ramps
+/// @param ChannelMask bit mask of the channels (bit 0 is channel 1)
+/// @param MicroAmperes values for the channels in the mask (in the order of the channels), in micro-amperes
+/// @return COMMAND_PROPER, COMMAND_INCORRECT_ARGUMENT or COMMAND_QUEUE_FULL;
+/// the state is checked by the caller
+CommandErrors programCurrents( uint16_t ChannelMask, const int32_t *MicroAmperes );
+
+/// @brief This function orders power up (1) or power down (0)
+/// @return COMMAND_PROPER, COMMAND_INCORRECT_ARGUMENT, COMMAND_INVOKED_IN_INCONSISTENT_STATE or COMMAND_QUEUE_FULL
+CommandErrors switchPower( uint8_t PowerOn );
+
+/// @brief This function clears the error flags and counters (of I2C, UART, trip monitor)
+void resetErrors(void);
 
 #endif // SOURCE_RSTL_PROTOCOL_H_
@@ -0,0 +1,325 @@
+/// @file rstl_session.c
+
+#include <string.h>
+#include "rstl_session.h"
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+static bool receiveStreamFrame( void *LinkPtr, const char **FramePtr, uint16_t *LengthPtr );
+static int8_t transmitViaStream( void *LinkPtr, const uint8_t *DataPtr, uint16_t Length );
+static int8_t transmitUnsolicitedViaStream( void *LinkPtr, const char *Text );
+static bool isStreamIdle( void *LinkPtr );
+static void setStreamBinaryMode( void *LinkPtr, bool IsBinary );
+static bool isStreamInBinaryMode( void *LinkPtr );
+static void setStreamEcho( void *LinkPtr, bool IsEnabled );
+static bool isStreamEchoEnabled( void *LinkPtr );
+static void reportStreamFrameError( void *LinkPtr );
+
+/// @brief This function assembles the binary frame according to the length byte
+static void assembleBinaryStreamFrame( StreamLink *LinkPtr, uint8_t NewByte );
+
+/// @brief This function assembles the text frame byte by byte; the frame is complete when "\r\n" is received
+static void assembleTextStreamFrame( StreamLink *LinkPtr, char NewByte );
+
+/// @brief This function passes the text frame to the session (a frame that is too long is dropped)
+static void completeTextStreamFrame( StreamLink *LinkPtr );
+
+//---------------------------------------------------------------------------------------------------
+// Global constants
+//---------------------------------------------------------------------------------------------------
+
+/// The operations of StreamLink
+const SessionTransport StreamTransport = {
+	.receiveFrame = receiveStreamFrame,
+	.transmit = transmitViaStream,
+	.transmitUnsolicited = transmitUnsolicitedViaStream,
+	.isIdle = isStreamIdle,
+	.setBinaryMode = setStreamBinaryMode,
+	.isBinaryMode = isStreamInBinaryMode,
+	.setEcho = setStreamEcho,
+	.isEchoEnabled = isStreamEchoEnabled,
+	.reportFrameError = reportStreamFrameError,
+	.setBaudRate = NULL,
+	.getBaudRate = NULL,
+	.confirmBaudRate = NULL,
+};
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function initializes the session (the interpreter state is cleared)
+void initializeSession( RstlSession *SessionPtr, const char *Name, const SessionTransport *TransportPtr, void *LinkPtr ){
+	SessionPtr->Name = Name;
+	SessionPtr->TransportPtr = TransportPtr;
+	SessionPtr->LinkPtr = LinkPtr;
+	initializeTextBuffer( &SessionPtr->Response, SessionPtr->ResponseBuffer, sizeof(SessionPtr->ResponseBuffer) );
+	SessionPtr->SelectedChannel = 0;
+	SessionPtr->PendingCurrentsMask = 0;
+	SessionPtr->TelemetryPeriodInMilliseconds = 0;
+	SessionPtr->NextTelemetryTime = 0;
+	SessionPtr->LastBinaryFrameTime = 0;
+	SessionPtr->IsI2cErrorPending = false;
+	SessionPtr->PendingSettledChannels = 0;
+}
+
+/// @brief This function gives the frame received in the session (it stays valid until the next call)
+bool receiveSessionFrame( RstlSession *SessionPtr, const char **FramePtr, uint16_t *LengthPtr ){
+	return SessionPtr->TransportPtr->receiveFrame( SessionPtr->LinkPtr, FramePtr, LengthPtr );
+}
+
+/// @brief This function starts the (empty) response of a frame
+void startSessionResponse( RstlSession *SessionPtr ){
+	initializeTextBuffer( &SessionPtr->Response, SessionPtr->ResponseBuffer, sizeof(SessionPtr->ResponseBuffer) );
+}
+
+/// @brief This function appends the response of a command to the response of the frame
+void appendSessionResponse( RstlSession *SessionPtr, const char *Text ){
+	TextBuffer *ResponsePtr = &SessionPtr->Response;
+	size_t Length = strlen( Text );
+	if ((Length > 0) && ('>' == Text[Length-1])){
+		Length--;
+	}
+	if (ResponsePtr->Length + Length + 1 >= ResponsePtr->Size){
+		// the space for the prompt is kept
+		transmitSessionText( SessionPtr, ResponsePtr->Buffer );
+		startSessionResponse( SessionPtr );
+	}
+	for (size_t J = 0; J < Length; J++){
+		appendCharacter( ResponsePtr, Text[J] );
+	}
+}
+
+/// @brief This function appends the prompt '>' and sends the response of the frame
+void finishSessionResponse( RstlSession *SessionPtr ){
+	appendCharacter( &SessionPtr->Response, '>' );
+	transmitSessionText( SessionPtr, SessionPtr->ResponseBuffer );
+}
+
+/// @brief This function sends a copy of the text (0 on success, -1 on failure)
+int8_t transmitSessionText( RstlSession *SessionPtr, const char *Text ){
+	size_t Length = strlen( Text );
+	if ((0 == Length) || (Length > UINT16_MAX)){
+		return -1;
+	}
+	return SessionPtr->TransportPtr->transmit( SessionPtr->LinkPtr, (const uint8_t*)Text, (uint16_t)Length );
+}
+
+/// @brief This function sends a copy of the data, e.g. a binary frame (0 on success, -1 on failure)
+int8_t transmitSessionBytes( RstlSession *SessionPtr, const uint8_t *DataPtr, uint16_t Length ){
+	return SessionPtr->TransportPtr->transmit( SessionPtr->LinkPtr, DataPtr, Length );
+}
+
+/// @brief This function sends a copy of an unsolicited message (0 on success, -1 on failure)
+int8_t transmitSessionUnsolicited( RstlSession *SessionPtr, const char *Text ){
+	return SessionPtr->TransportPtr->transmitUnsolicited( SessionPtr->LinkPtr, Text );
+}
+
+/// @brief This function returns true if the link of the session is idle (an unsolicited message may be sent)
+bool isSessionIdle( RstlSession *SessionPtr ){
+	return SessionPtr->TransportPtr->isIdle( SessionPtr->LinkPtr );
+}
+
+void setSessionBinaryMode( RstlSession *SessionPtr, bool IsBinary ){
+	SessionPtr->TransportPtr->setBinaryMode( SessionPtr->LinkPtr, IsBinary );
+}
+
+bool isSessionInBinaryMode( RstlSession *SessionPtr ){
+	return SessionPtr->TransportPtr->isBinaryMode( SessionPtr->LinkPtr );
+}
+
+void setSessionEcho( RstlSession *SessionPtr, bool IsEnabled ){
+	SessionPtr->TransportPtr->setEcho( SessionPtr->LinkPtr, IsEnabled );
+}
+
+bool isSessionEchoEnabled( RstlSession *SessionPtr ){
+	return SessionPtr->TransportPtr->isEchoEnabled( SessionPtr->LinkPtr );
+}
+
+/// @brief This function records a binary frame rejected by the interpreter
+void reportSessionFrameError( RstlSession *SessionPtr ){
+	SessionPtr->TransportPtr->reportFrameError( SessionPtr->LinkPtr );
+}
+
+/// @brief This function requests the change of the baud rate
+bool setSessionBaudRate( RstlSession *SessionPtr, uint32_t NewBaudRate ){
+	if (NULL == SessionPtr->TransportPtr->setBaudRate){
+		return false;
+	}
+	return SessionPtr->TransportPtr->setBaudRate( SessionPtr->LinkPtr, NewBaudRate );
+}
+
+/// @brief This function returns the baud rate of the link (0 if the link has no baud rate)
+uint32_t getSessionBaudRate( RstlSession *SessionPtr ){
+	if (NULL == SessionPtr->TransportPtr->getBaudRate){
+		return 0;
+	}
+	return SessionPtr->TransportPtr->getBaudRate( SessionPtr->LinkPtr );
+}
+
+/// @brief This function is called after a proper command has been received; it confirms the new baud rate (if any)
+void confirmSessionBaudRate( RstlSession *SessionPtr ){
+	if (NULL != SessionPtr->TransportPtr->confirmBaudRate){
+		SessionPtr->TransportPtr->confirmBaudRate( SessionPtr->LinkPtr );
+	}
+}
+
+/// @brief This function initializes the stream link
+void initializeStreamLink( StreamLink *LinkPtr, int (*readByte)( void* ),
+		int8_t (*writeBytes)( void*, const uint8_t*, uint16_t ), uint64_t (*readTime)( void ),
+		void *ContextPtr, uint32_t SilenceInMicroseconds )
+{
+	LinkPtr->readByte = readByte;
+	LinkPtr->writeBytes = writeBytes;
+	LinkPtr->readTime = readTime;
+	LinkPtr->ContextPtr = ContextPtr;
+	LinkPtr->SilenceInMicroseconds = SilenceInMicroseconds;
+	lineStoreInit( &LinkPtr->Store, LinkPtr->Buffers[0], LinkPtr->Buffers[1], LINE_BUFFER_SIZE );
+	LinkPtr->IsFrameTaken = false;
+	LinkPtr->IsBinaryMode = false;
+	LinkPtr->IsEchoEnabled = true;
+	LinkPtr->IsFrameTooLong = false;
+	LinkPtr->PreviousByte = 0;
+	LinkPtr->LastReceptionTime = 0;
+	LinkPtr->DroppedFrames = 0;
+}
+
+static bool receiveStreamFrame( void *LinkPtr, const char **FramePtr, uint16_t *LengthPtr ){
+	StreamLink *StreamPtr = LinkPtr;
+	if (StreamPtr->IsFrameTaken){
+		// the previous frame has been interpreted; its buffer is returned to the assembler
+		lineStoreRelease( &StreamPtr->Store );
+		StreamPtr->IsFrameTaken = false;
+	}
+
+	// the bytes are read until a frame is complete, so the frame never has to wait for the buffer
+	char Echo[LINE_BUFFER_SIZE];
+	uint16_t EchoLength = 0;
+	bool IsEchoed = StreamPtr->IsEchoEnabled && !StreamPtr->IsBinaryMode;
+	uint64_t Now = StreamPtr->readTime();
+	int NewByte = -1;
+	while (lineStoreIsEmpty( &StreamPtr->Store ) && (EchoLength < sizeof(Echo)) &&
+			((NewByte = StreamPtr->readByte( StreamPtr->ContextPtr )) >= 0))
+	{
+		if (StreamPtr->IsBinaryMode){
+			assembleBinaryStreamFrame( StreamPtr, (uint8_t)NewByte );
+		}
+		else{
+			assembleTextStreamFrame( StreamPtr, (char)NewByte );
+		}
+		Echo[EchoLength++] = (char)NewByte;
+		StreamPtr->LastReceptionTime = Now;
+	}
+	if (IsEchoed && (0 != EchoLength)){
+		StreamPtr->writeBytes( StreamPtr->ContextPtr, (const uint8_t*)Echo, EchoLength );
+	}
+
+	if ((NewByte < 0) && lineStoreIsEmpty( &StreamPtr->Store ) &&
+			((0 != lineStoreLength( &StreamPtr->Store )) || StreamPtr->IsFrameTooLong) &&
+			(StreamPtr->LastReceptionTime + StreamPtr->SilenceInMicroseconds < Now))
+	{
+		if (StreamPtr->IsBinaryMode){
+			// an incomplete binary frame is dropped
+			StreamPtr->DroppedFrames++;
+			lineStoreDiscard( &StreamPtr->Store );
+		}
+		else{
+			// a frame without the terminator (or garbage) is passed on
+			completeTextStreamFrame( StreamPtr );
+		}
+	}
+	StreamPtr->IsFrameTaken = lineStoreTake( &StreamPtr->Store, FramePtr, LengthPtr );
+	return StreamPtr->IsFrameTaken;
+}
+
+static void assembleBinaryStreamFrame( StreamLink *LinkPtr, uint8_t NewByte ){
+	uint16_t Length = lineStoreLength( &LinkPtr->Store );
+	if ((0 == Length) && (BINARY_FRAME_SYNC != NewByte)){
+		// garbage between frames is skipped
+		return;
+	}
+	lineStoreAppend( &LinkPtr->Store, (char)NewByte );	// the length byte is checked, so the frame fits in the buffer
+	Length++;
+	if ((2 == Length) && ((NewByte < BINARY_FRAME_MIN_CONTENT) || (NewByte+BINARY_FRAME_OVERHEAD > LINE_BUFFER_SIZE))){
+		// improper length; the search for the sync byte starts again
+		LinkPtr->DroppedFrames++;
+		lineStoreDiscard( &LinkPtr->Store );
+	}
+	else if ((Length > 2) && (Length == (uint8_t)lineStoreByte( &LinkPtr->Store, 1 )+BINARY_FRAME_OVERHEAD)){
+		lineStoreComplete( &LinkPtr->Store );	// the previous frame has been released
+	}
+}
+
+static void assembleTextStreamFrame( StreamLink *LinkPtr, char NewByte ){
+	if ((lineStoreLength( &LinkPtr->Store ) >= LONGEST_COMMAND_LENGTH) || !lineStoreAppend( &LinkPtr->Store, NewByte )){
+		LinkPtr->IsFrameTooLong = true;	// the rest of the frame is dropped
+	}
+	if (('\n' == NewByte) && ('\r' == LinkPtr->PreviousByte)){
+		completeTextStreamFrame( LinkPtr );
+		return;
+	}
+	LinkPtr->PreviousByte = NewByte;
+}
+
+static void completeTextStreamFrame( StreamLink *LinkPtr ){
+	if (LinkPtr->IsFrameTooLong){
+		LinkPtr->DroppedFrames++;
+		lineStoreDiscard( &LinkPtr->Store );
+	}
+	else{
+		lineStoreComplete( &LinkPtr->Store );	// the previous frame has been released
+	}
+	LinkPtr->PreviousByte = 0;
+	LinkPtr->IsFrameTooLong = false;
+}
+
+static int8_t transmitViaStream( void *LinkPtr, const uint8_t *DataPtr, uint16_t Length ){
+	StreamLink *StreamPtr = LinkPtr;
+	if ((NULL == DataPtr) || (0 == Length)){
+		return -1;
+	}
+	return StreamPtr->writeBytes( StreamPtr->ContextPtr, DataPtr, Length );
+}
+
+static int8_t transmitUnsolicitedViaStream( void *LinkPtr, const char *Text ){
+	if (NULL == Text){
+		return -1;
+	}
+	size_t Length = strlen( Text );
+	if (Length > UINT16_MAX){
+		return -1;
+	}
+	return transmitViaStream( LinkPtr, (const uint8_t*)Text, (uint16_t)Length );
+}
+
+static bool isStreamIdle( void *LinkPtr ){
+	// the data is written at once, so the link is idle unless a frame is being received or waits for the interpreter
+	StreamLink *StreamPtr = LinkPtr;
+	return lineStoreIsEmpty( &StreamPtr->Store ) && (0 == lineStoreLength( &StreamPtr->Store )) && !StreamPtr->IsFrameTooLong;
+}
+
+static void setStreamBinaryMode( void *LinkPtr, bool IsBinary ){
+	StreamLink *StreamPtr = LinkPtr;
+	StreamPtr->IsBinaryMode = IsBinary;
+	lineStoreDiscard( &StreamPtr->Store );
+	StreamPtr->PreviousByte = 0;
+	StreamPtr->IsFrameTooLong = false;
+}
+
+static bool isStreamInBinaryMode( void *LinkPtr ){
+	return ((StreamLink*)LinkPtr)->IsBinaryMode;
+}
+
+static void setStreamEcho( void *LinkPtr, bool IsEnabled ){
+	((StreamLink*)LinkPtr)->IsEchoEnabled = IsEnabled;
+}
+
+static bool isStreamEchoEnabled( void *LinkPtr ){
+	return ((StreamLink*)LinkPtr)->IsEchoEnabled;
+}
+
+static void reportStreamFrameError( void *LinkPtr ){
+	((StreamLink*)LinkPtr)->DroppedFrames++;
+}
@@ -0,0 +1,187 @@
+/// @file rstl_session.h
+/// @brief This module provides the sessions of the RSTL protocol, independent of the transport
+///
+/// A session joins a link (UART0, USB CDC, a pseudo-terminal in the host tests) with the state of the command
+/// interpreter: the response of the frame being executed, the channel selected by Z, the telemetry settings etc.
+/// The interpreter (rstl_protocol.c) runs one session per link, so the links do not disturb each other.
+/// The link is reached through the operations of SessionTransport; the module provides one implementation,
+/// StreamTransport, for links that deliver a stream of bytes polled in the main loop (USB CDC, pseudo-terminal).
+/// The module uses no hardware, so it can be tested on the host (see tests/test-rstl-session.c).
+
+#ifndef SOURCE_RSTL_SESSION_H_
+#define SOURCE_RSTL_SESSION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "text_format.h"
+#include "line_store.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+/// A frame holds one command or a batch of commands separated by ';', e.g. four pairs "Z 1;PC -1.234567;"
+#define LONGEST_COMMAND_LENGTH				96
+
+#define LONGEST_RESPONSE_LENGTH				60
+
+/// The combined response of a batch (a longer one is sent in parts)
+#define LONGEST_BATCH_RESPONSE_LENGTH		(4*LONGEST_RESPONSE_LENGTH)
+
+/// Binary mode frames: BINARY_FRAME_SYNC, length N, N bytes of content, CRC-16 (2 bytes);
+/// the frames are assembled by the link, the content and the CRC are interpreted by the rstl_binary module
+#define BINARY_FRAME_SYNC					0xA5
+#define BINARY_FRAME_OVERHEAD				4			// the sync byte, the length and the CRC
+#define BINARY_FRAME_MIN_CONTENT			2			// the sequence number and the operation code
+
+/// Size of each buffer of a line store (the argument parsers stop at the end of the frame, so no slack is needed)
+#define LINE_BUFFER_SIZE					LONGEST_COMMAND_LENGTH
+
+//---------------------------------------------------------------------------------------------------
+// Constants
+//---------------------------------------------------------------------------------------------------
+
+/// @brief The operations of a link; LinkPtr is the pointer given to initializeSession
+/// The operations are called in the main loop only.
+typedef struct {
+	/// gives the received frame; it stays valid (and unchanged) until the next call
+	bool (*receiveFrame)( void *LinkPtr, const char **FramePtr, uint16_t *LengthPtr );
+	/// sends a copy of the data; returns 0 on success, -1 on failure
+	int8_t (*transmit)( void *LinkPtr, const uint8_t *DataPtr, uint16_t Length );
+	/// sends a copy of an unsolicited message (e.g. telemetry); returns 0 on success, -1 on failure
+	int8_t (*transmitUnsolicited)( void *LinkPtr, const char *Text );
+	/// returns true if no frame is being received and nothing is being transmitted
+	bool (*isIdle)( void *LinkPtr );
+	void (*setBinaryMode)( void *LinkPtr, bool IsBinary );
+	bool (*isBinaryMode)( void *LinkPtr );
+	void (*setEcho)( void *LinkPtr, bool IsEnabled );
+	bool (*isEchoEnabled)( void *LinkPtr );
+	/// records a binary frame rejected by the interpreter (e.g. wrong CRC)
+	void (*reportFrameError)( void *LinkPtr );
+	/// the baud rate operations; NULL if the link has no baud rate (e.g. USB)
+	bool (*setBaudRate)( void *LinkPtr, uint32_t NewBaudRate );
+	uint32_t (*getBaudRate)( void *LinkPtr );
+	void (*confirmBaudRate)( void *LinkPtr );
+} SessionTransport;
+
+/// @brief The session: the link and the state of the command interpreter for this link
+typedef struct {
+	const char *Name;						// used in debug lines
+	const SessionTransport *TransportPtr;
+	void *LinkPtr;
+
+	/// The response of the frame (the responses of all the commands of the batch)
+	char ResponseBuffer[LONGEST_BATCH_RESPONSE_LENGTH];
+	TextBuffer Response;
+
+	/// The channel selected by the Z command (the default channel of the commands of this session)
+	uint16_t SelectedChannel;
+
+	/// The channels programmed by the PC commands of the frame; the order is placed after the last command
+	/// (or dropped if a command of the frame fails)
+	uint16_t PendingCurrentsMask;
+
+	/// The period of the telemetry frames in milliseconds (0: no telemetry) and the time of the next frame
+	uint32_t TelemetryPeriodInMilliseconds;
+	uint64_t NextTelemetryTime;
+
+	/// The time of the last valid binary frame (or of entering the binary mode); see BINARY_MODE_TIMEOUT_IN_MICROSECONDS
+	uint64_t LastBinaryFrameTime;
+
+	/// The asynchronous messages waiting for transmission in this session
+	bool IsI2cErrorPending;
+	uint16_t PendingSettledChannels;
+} RstlSession;
+
+/// @brief A link that delivers a stream of bytes (USB CDC, pseudo-terminal); used with StreamTransport
+/// The bytes are read and the frames are assembled in the main loop, when the session asks for a frame.
+/// A text frame ends with "\r\n" or after a period of silence; binary frames are assembled according to their length.
+typedef struct {
+	/// returns the next received byte or -1 if there is none (must not wait)
+	int (*readByte)( void *ContextPtr );
+	/// writes the data; returns 0 on success, -1 on failure (e.g. the port is not connected)
+	int8_t (*writeBytes)( void *ContextPtr, const uint8_t *DataPtr, uint16_t Length );
+	/// returns the time in microseconds
+	uint64_t (*readTime)( void );
+	void *ContextPtr;
+	uint32_t SilenceInMicroseconds;			// a text frame without the terminator is passed on after this silence
+
+	char Buffers[2][LINE_BUFFER_SIZE];
+	line_store_t Store;
+	bool IsFrameTaken;
+	bool IsBinaryMode;
+	bool IsEchoEnabled;
+	bool IsFrameTooLong;
+	char PreviousByte;
+	uint64_t LastReceptionTime;
+	uint32_t DroppedFrames;					// frames too long, incomplete or rejected
+} StreamLink;
+
+//---------------------------------------------------------------------------------------------------
+// Global constants
+//---------------------------------------------------------------------------------------------------
+
+/// The operations of StreamLink
+extern const SessionTransport StreamTransport;
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function initializes the session (the interpreter state is cleared)
+void initializeSession( RstlSession *SessionPtr, const char *Name, const SessionTransport *TransportPtr, void *LinkPtr );
+
+/// @brief This function gives the frame received in the session (it stays valid until the next call)
+bool receiveSessionFrame( RstlSession *SessionPtr, const char **FramePtr, uint16_t *LengthPtr );
+
+/// @brief This function starts the (empty) response of a frame
+void startSessionResponse( RstlSession *SessionPtr );
+
+/// @brief This function appends the response of a command to the response of the frame
+/// The prompt '>' at the end of the text is skipped (it is sent once, by finishSessionResponse).
+/// If the buffer is full, the text collected so far is sent.
+void appendSessionResponse( RstlSession *SessionPtr, const char *Text );
+
+/// @brief This function appends the prompt '>' and sends the response of the frame
+void finishSessionResponse( RstlSession *SessionPtr );
+
+/// @brief This function sends a copy of the text (0 on success, -1 on failure)
+int8_t transmitSessionText( RstlSession *SessionPtr, const char *Text );
+
+/// @brief This function sends a copy of the data, e.g. a binary frame (0 on success, -1 on failure)
+int8_t transmitSessionBytes( RstlSession *SessionPtr, const uint8_t *DataPtr, uint16_t Length );
+
+/// @brief This function sends a copy of an unsolicited message (0 on success, -1 on failure)
+int8_t transmitSessionUnsolicited( RstlSession *SessionPtr, const char *Text );
+
+/// @brief This function returns true if the link of the session is idle (an unsolicited message may be sent)
+bool isSessionIdle( RstlSession *SessionPtr );
+
+void setSessionBinaryMode( RstlSession *SessionPtr, bool IsBinary );
+
+bool isSessionInBinaryMode( RstlSession *SessionPtr );
+
+void setSessionEcho( RstlSession *SessionPtr, bool IsEnabled );
+
+bool isSessionEchoEnabled( RstlSession *SessionPtr );
+
+/// @brief This function records a binary frame rejected by the interpreter
+void reportSessionFrameError( RstlSession *SessionPtr );
+
+/// @brief This function requests the change of the baud rate
+/// @return false if the link has no baud rate or the rate is not accepted
+bool setSessionBaudRate( RstlSession *SessionPtr, uint32_t NewBaudRate );
+
+/// @brief This function returns the baud rate of the link (0 if the link has no baud rate)
+uint32_t getSessionBaudRate( RstlSession *SessionPtr );
+
+/// @brief This function is called after a proper command has been received; it confirms the new baud rate (if any)
+void confirmSessionBaudRate( RstlSession *SessionPtr );
+
+/// @brief This function initializes the stream link
+/// @param SilenceInMicroseconds a text frame without the terminator is passed on after this period of silence
+void initializeStreamLink( StreamLink *LinkPtr, int (*readByte)( void* ),
+		int8_t (*writeBytes)( void*, const uint8_t*, uint16_t ), uint64_t (*readTime)( void ),
+		void *ContextPtr, uint32_t SilenceInMicroseconds );
+
+#endif // SOURCE_RSTL_SESSION_H_
@@ -0,0 +1,89 @@
+/// @file seqlock.h
+/// @brief Simple sequence lock protecting a block of data that is written by one writer and copied by readers.
+/// The writer never waits; a reader repeats the copy if the writer has been active meanwhile.
+/// Assumptions:
+/// - There is exactly one writer (e.g. the timer interrupt); it is never interrupted by a reader.
+/// - Readers (main context) may be interrupted by the writer at any point.
+/// - The protected data is plain memory accessed only through seqlockWrite / seqlockRead.
+
+#ifndef SEQLOCK_H_
+#define SEQLOCK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef struct {
+    atomic_uint_fast32_t sequence;   // odd while the writer is copying the data
+} seqlock_t;
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief Initialize the sequence lock (no write in progress).
+static inline void seqlockInit(seqlock_t *LockPtr){
+    atomic_init(&LockPtr->sequence, 0u);
+}
+
+/// @brief The function marks the beginning of an update of the protected data
+/// Writer only.
+static inline void seqlockWriteBegin(seqlock_t *LockPtr){
+    uint32_t Sequence = atomic_load_explicit(&LockPtr->sequence, memory_order_relaxed);
+    atomic_store_explicit(&LockPtr->sequence, Sequence + 1u, memory_order_relaxed);
+    // the odd sequence number must be visible before any of the data is changed
+    atomic_thread_fence(memory_order_release);
+}
+
+/// @brief The function marks the end of an update of the protected data
+/// Writer only.
+static inline void seqlockWriteEnd(seqlock_t *LockPtr){
+    uint32_t Sequence = atomic_load_explicit(&LockPtr->sequence, memory_order_relaxed);
+    atomic_store_explicit(&LockPtr->sequence, Sequence + 1u, memory_order_release);
+}
+
+/// @brief The function copies the new data into the protected block
+/// Writer only.
+static inline void seqlockWrite(seqlock_t *LockPtr, void *ProtectedPtr, const void *SourcePtr, size_t Size){
+    seqlockWriteBegin(LockPtr);
+    memcpy(ProtectedPtr, SourcePtr, Size);
+    seqlockWriteEnd(LockPtr);
+}
+
+/// @brief The function starts a read of the protected data
+/// @return the sequence number to be passed to seqlockReadRetry
+static inline uint32_t seqlockReadBegin(seqlock_t *LockPtr){
+    uint32_t Sequence;
+    do {
+        Sequence = atomic_load_explicit(&LockPtr->sequence, memory_order_acquire);
+    } while (Sequence & 1u);
+    return Sequence;
+}
+
+/// @brief The function checks if the data read since seqlockReadBegin may be torn
+/// @return true if the writer has been active; the read must be repeated
+/// @return false if the copy is consistent
+static inline bool seqlockReadRetry(seqlock_t *LockPtr, uint32_t Sequence){
+    // the reads of the data must complete before the sequence number is checked again
+    atomic_thread_fence(memory_order_acquire);
+    return Sequence != atomic_load_explicit(&LockPtr->sequence, memory_order_relaxed);
+}
+
+/// @brief The function makes a consistent copy of the protected block
+/// Reader: safe to call from main context; repeats the copy as long as the writer interferes.
+/// @return number of repeated copies (0 if the first one was consistent)
+static inline uint32_t seqlockRead(seqlock_t *LockPtr, void *DestinationPtr, const void *ProtectedPtr, size_t Size){
+    uint32_t Retries = 0;
+    uint32_t Sequence = seqlockReadBegin(LockPtr);
+    memcpy(DestinationPtr, ProtectedPtr, Size);
+    while (seqlockReadRetry(LockPtr, Sequence)){
+        Retries++;
+        Sequence = seqlockReadBegin(LockPtr);
+        memcpy(DestinationPtr, ProtectedPtr, Size);
+    }
+    return Retries;
+}
+
+#endif // SEQLOCK_H_
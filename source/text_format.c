@@ -0,0 +1,151 @@
+/// @file text_format.c
+
+#include "text_format.h"
+#include "conversions.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+/// The number of decimal digits of the largest uint32_t value
+#define UINT32_DECIMAL_DIGITS		10
+
+//---------------------------------------------------------------------------------------------------
+// Local constants
+//---------------------------------------------------------------------------------------------------
+
+static const char HexadecimalDigits[16] = {
+		'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+};
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function converts the number to decimal digits (the least significant digit first)
+/// @return number of digits
+static uint8_t convertToDecimalDigits( char *Digits, uint32_t Value );
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function starts a new (empty) text in the buffer
+void initializeTextBuffer( TextBuffer *TextPtr, char *Buffer, uint16_t Size ){
+	TextPtr->Buffer = Buffer;
+	TextPtr->Size = Size;
+	TextPtr->Length = 0;
+	if (Size > 0){
+		Buffer[0] = 0;
+	}
+}
+
+/// @brief This function appends a character
+void appendCharacter( TextBuffer *TextPtr, char Character ){
+	if (TextPtr->Length+1 < TextPtr->Size){
+		TextPtr->Buffer[TextPtr->Length] = Character;
+		TextPtr->Length++;
+		TextPtr->Buffer[TextPtr->Length] = 0;
+	}
+}
+
+/// @brief This function appends a string
+void appendText( TextBuffer *TextPtr, const char *Text ){
+	uint16_t Length = TextPtr->Length;
+	while ((0 != *Text) && (Length+1 < TextPtr->Size)){
+		TextPtr->Buffer[Length] = *Text;
+		Length++;
+		Text++;
+	}
+	if (Length < TextPtr->Size){
+		TextPtr->Buffer[Length] = 0;
+	}
+	TextPtr->Length = Length;
+}
+
+/// @brief This function appends an unsigned decimal number, e.g. "4800"
+void appendUnsigned( TextBuffer *TextPtr, uint32_t Value ){
+	appendPaddedUnsigned( TextPtr, Value, 0, ' ' );
+}
+
+/// @brief This function appends a signed decimal number, e.g. "-12"
+void appendSigned( TextBuffer *TextPtr, int32_t Value ){
+	if (Value < 0){
+		appendCharacter( TextPtr, '-' );
+		appendUnsigned( TextPtr, (uint32_t)0 - (uint32_t)Value );
+	}
+	else{
+		appendUnsigned( TextPtr, (uint32_t)Value );
+	}
+}
+
+/// @brief This function appends an unsigned decimal number right-aligned in a field of a given width
+void appendPaddedUnsigned( TextBuffer *TextPtr, uint32_t Value, uint8_t Width, char Padding ){
+	char Digits[UINT32_DECIMAL_DIGITS];
+	uint8_t NumberOfDigits = convertToDecimalDigits( Digits, Value );
+	while (Width > NumberOfDigits){
+		appendCharacter( TextPtr, Padding );
+		Width--;
+	}
+	while (NumberOfDigits > 0){
+		NumberOfDigits--;
+		appendCharacter( TextPtr, Digits[NumberOfDigits] );
+	}
+}
+
+/// @brief This function appends a hexadecimal number (upper case)
+void appendHexadecimal( TextBuffer *TextPtr, uint32_t Value, uint8_t Digits ){
+	uint8_t NumberOfDigits = 1;
+	while ((NumberOfDigits < 8) && (0 != (Value >> (4*NumberOfDigits)))){
+		NumberOfDigits++;
+	}
+	if (Digits > 8){
+		Digits = 8;
+	}
+	if (Digits > NumberOfDigits){
+		NumberOfDigits = Digits;
+	}
+	while (NumberOfDigits > 0){
+		NumberOfDigits--;
+		appendCharacter( TextPtr, HexadecimalDigits[(Value >> (4*NumberOfDigits)) & 0xF] );
+	}
+}
+
+/// @brief This function appends a fixed-point value (in micro-units) as a decimal number, e.g. "-1.25"
+void appendMicroUnits( TextBuffer *TextPtr, int32_t MicroUnits, uint8_t Decimals ){
+	if (Decimals > MICRO_UNITS_DECIMAL_DIGITS){
+		Decimals = MICRO_UNITS_DECIMAL_DIGITS;
+	}
+	int32_t Rounded = roundMicroUnits( MicroUnits, Decimals );
+	uint32_t Magnitude = (Rounded < 0)? (uint32_t)0 - (uint32_t)Rounded : (uint32_t)Rounded;
+	uint32_t Divider = 1;
+	for (uint8_t J = 0; J < Decimals; J++){
+		Divider *= 10;
+	}
+	if (Rounded < 0){
+		appendCharacter( TextPtr, '-' );
+	}
+	appendUnsigned( TextPtr, Magnitude / Divider );
+	if (Decimals > 0){
+		appendCharacter( TextPtr, '.' );
+		appendPaddedUnsigned( TextPtr, Magnitude % Divider, Decimals, '0' );
+	}
+}
+
+/// @brief This function appends the time in seconds with milliseconds, right-aligned, e.g. "    12.345"
+void appendTimestamp( TextBuffer *TextPtr, uint32_t Microseconds ){
+	uint32_t Milliseconds = Microseconds / 1000;
+	appendPaddedUnsigned( TextPtr, Milliseconds / 1000, 6, ' ' );
+	appendCharacter( TextPtr, '.' );
+	appendPaddedUnsigned( TextPtr, Milliseconds % 1000, 3, '0' );
+}
+
+static uint8_t convertToDecimalDigits( char *Digits, uint32_t Value ){
+	uint8_t NumberOfDigits = 0;
+	do{
+		Digits[NumberOfDigits] = (char)('0' + Value % 10);
+		NumberOfDigits++;
+		Value /= 10;
+	} while (0 != Value);
+	return NumberOfDigits;
+}
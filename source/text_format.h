@@ -0,0 +1,59 @@
+/// @file text_format.h
+/// @brief This module builds texts (protocol responses and debug lines) without printf
+///
+/// The functions append to a buffer provided by the caller; no variadic arguments, no floating-point arithmetic
+/// and no heap are used, so the texts can be built in the main loop as well as in interrupt handlers
+/// (each caller uses its own buffer). The text is always terminated by 0; if the buffer is too small,
+/// the text is truncated (like snprintf).
+
+#ifndef SOURCE_TEXT_FORMAT_H_
+#define SOURCE_TEXT_FORMAT_H_
+
+#include <stdint.h>
+
+//---------------------------------------------------------------------------------------------------
+// Constants
+//---------------------------------------------------------------------------------------------------
+
+/// The buffer and the number of characters already written
+typedef struct {
+	char *Buffer;
+	uint16_t Size;
+	uint16_t Length;
+} TextBuffer;
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function starts a new (empty) text in the buffer
+void initializeTextBuffer( TextBuffer *TextPtr, char *Buffer, uint16_t Size );
+
+/// @brief This function appends a character
+void appendCharacter( TextBuffer *TextPtr, char Character );
+
+/// @brief This function appends a string
+void appendText( TextBuffer *TextPtr, const char *Text );
+
+/// @brief This function appends an unsigned decimal number, e.g. "4800"
+void appendUnsigned( TextBuffer *TextPtr, uint32_t Value );
+
+/// @brief This function appends a signed decimal number, e.g. "-12"
+void appendSigned( TextBuffer *TextPtr, int32_t Value );
+
+/// @brief This function appends an unsigned decimal number right-aligned in a field of a given width
+/// @param Padding the character used to fill the field (' ' or '0')
+void appendPaddedUnsigned( TextBuffer *TextPtr, uint32_t Value, uint8_t Width, char Padding );
+
+/// @brief This function appends a hexadecimal number (upper case)
+/// @param Digits minimal number of digits (leading zeros); 0 means no leading zeros
+void appendHexadecimal( TextBuffer *TextPtr, uint32_t Value, uint8_t Digits );
+
+/// @brief This function appends a fixed-point value (in micro-units) as a decimal number, e.g. "-1.25"
+/// @param Decimals number of decimal places (the value is rounded); 0 means an integer
+void appendMicroUnits( TextBuffer *TextPtr, int32_t MicroUnits, uint8_t Decimals );
+
+/// @brief This function appends the time in seconds with milliseconds, right-aligned, e.g. "    12.345"
+void appendTimestamp( TextBuffer *TextPtr, uint32_t Microseconds );
+
+#endif // SOURCE_TEXT_FORMAT_H_
@@ -0,0 +1,245 @@
+/// @file trip_monitor.c
+
+#include "pico/stdlib.h"
+
+#include "trip_monitor.h"
+#include "psu_talks.h"
+#include "adc_inputs.h"
+#include "conversions.h"
+#include "debugging.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+/// The current monitor output of the PSU: 1 V at the ADC input is assumed to correspond to 1 A (not confirmed yet;
+/// a gain error of a channel up to a factor of 2 can be corrected by its ADC calibration, see the CAG command)
+#define MICROAMPERES_PER_MICROVOLT		1
+
+/// The deviation is checked only if the value written to the DAC has not changed for this time
+/// (the ADC measurement is an average of about 1 s)
+#define SETTLING_TIME_IN_MICROSECONDS	1200000
+
+/// Only the channels with their own ADC input can be monitored
+#if NUMBER_OF_INSTALLED_PSU < NUMBER_OF_ADC_INPUTS
+#define NUMBER_OF_MONITORED_CHANNELS	NUMBER_OF_INSTALLED_PSU
+#else
+#define NUMBER_OF_MONITORED_CHANNELS	NUMBER_OF_ADC_INPUTS
+#endif
+
+//---------------------------------------------------------------------------------------------------
+// Local variables
+//---------------------------------------------------------------------------------------------------
+
+static atomic_int_fast32_t TripTolerance;
+
+static atomic_uint_fast32_t TripTimeInMilliseconds;
+
+/// Latched fault; takes values TRIP_FAULT_...
+static atomic_uint_fast16_t FaultCode;
+
+static atomic_uint_fast16_t FaultChannel;
+
+static atomic_int_fast32_t FaultMeasurement;
+
+static atomic_uint_fast32_t FaultLatency;
+
+static atomic_uint_fast32_t FaultViolationLatency;
+
+/// Request for fast zeroing; it is taken by the state machine in psu_talks.c
+static atomic_bool TripRequest;
+
+// These variables are used only in the timer interrupt
+
+static bool IsViolation[NUMBER_OF_MONITORED_CHANNELS];
+
+static uint32_t ViolationStartTime[NUMBER_OF_MONITORED_CHANNELS];
+
+static uint32_t SettledSinceTime[NUMBER_OF_MONITORED_CHANNELS];
+
+static uint16_t LastWrittenToDacValue[NUMBER_OF_MONITORED_CHANNELS];
+
+static uint32_t TripTime;
+
+/// The start of the violation that has latched the fault
+static uint32_t TripViolationStartTime;
+
+static bool IsLatencyMeasurementPending;
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function initializes the module variables
+void initializeTripMonitor(void){
+	atomic_store_explicit( &TripTolerance, TRIP_DEFAULT_TOLERANCE_IN_MICROAMPERES, memory_order_release );
+	atomic_store_explicit( &TripTimeInMilliseconds, TRIP_DEFAULT_TIME_IN_MILLISECONDS, memory_order_release );
+	atomic_store_explicit( &TripRequest, false, memory_order_release );
+	atomic_store_explicit( &FaultLatency, 0, memory_order_release );
+	atomic_store_explicit( &FaultViolationLatency, 0, memory_order_release );
+	atomic_store_explicit( &FaultMeasurement, 0, memory_order_release );
+	atomic_store_explicit( &FaultChannel, 0, memory_order_release );
+	atomic_store_explicit( &FaultCode, TRIP_FAULT_NONE, memory_order_release );
+	IsLatencyMeasurementPending = false;
+	for (uint8_t J = 0; J < NUMBER_OF_MONITORED_CHANNELS; J++){
+		IsViolation[J] = false;
+	}
+}
+
+/// @brief This function checks the measured currents of all monitored channels; it is to be called by timer interrupt
+void monitorChannelCurrents(void){
+#if ENABLE_TRIP_MONITOR == 1
+	uint32_t Now = time_us_32();
+	uint16_t TemporaryPsuState = atomic_load_explicit( &PsuState, memory_order_acquire );
+
+	if (((PSU_RUNNING != TemporaryPsuState) && (PSU_SHUTTING_DOWN_ZEROING != TemporaryPsuState)) ||
+			(TRIP_FAULT_NONE != atomic_load_explicit( &FaultCode, memory_order_acquire )))
+	{
+		for (uint8_t J = 0; J < NUMBER_OF_MONITORED_CHANNELS; J++){
+			IsViolation[J] = false;
+			SettledSinceTime[J] = Now;
+		}
+		return;
+	}
+
+	int32_t Tolerance = atomic_load_explicit( &TripTolerance, memory_order_acquire );
+	uint32_t TimeLimit = 1000 * atomic_load_explicit( &TripTimeInMilliseconds, memory_order_acquire );
+
+	for (uint8_t J = 0; J < NUMBER_OF_MONITORED_CHANNELS; J++){
+		uint16_t TemporaryWrittenValue = WrittenToDacValue[J];
+		if ((TemporaryWrittenValue != LastWrittenToDacValue[J]) ||
+				(TemporaryWrittenValue != atomic_load_explicit( &UserSetpointDacValue[J], memory_order_acquire )))
+		{
+			// the ramp is running
+			LastWrittenToDacValue[J] = TemporaryWrittenValue;
+			SettledSinceTime[J] = Now;
+		}
+
+		int32_t Measured = getVoltage( J ) * MICROAMPERES_PER_MICROVOLT;
+		int32_t Setpoint = convertDacValueToMicroAmperes( J, TemporaryWrittenValue );
+		int32_t Deviation = Measured - Setpoint;
+		uint16_t Fault = TRIP_FAULT_NONE;
+
+		// the measurement cannot exceed the ADC range, so the limit is near its end (see trip_monitor.h)
+		if (((Measured > TRIP_OVERCURRENT_LIMIT_IN_MICROAMPERES) || (Measured < -TRIP_OVERCURRENT_LIMIT_IN_MICROAMPERES)) &&
+				(Setpoint <= TRIP_OVERCURRENT_LIMIT_IN_MICROAMPERES) && (Setpoint >= -TRIP_OVERCURRENT_LIMIT_IN_MICROAMPERES))
+		{
+			Fault = TRIP_FAULT_OVERCURRENT;
+		}
+		else if ((0 != Tolerance) && (Now - SettledSinceTime[J] >= SETTLING_TIME_IN_MICROSECONDS) &&
+				((Deviation > Tolerance) || (Deviation < -Tolerance)))
+		{
+			Fault = TRIP_FAULT_DEVIATION;
+		}
+
+		if (TRIP_FAULT_NONE == Fault){
+			IsViolation[J] = false;
+			continue;
+		}
+		if (!IsViolation[J]){
+			IsViolation[J] = true;
+			ViolationStartTime[J] = Now;
+		}
+		if (Now - ViolationStartTime[J] >= TimeLimit){
+			// latch the fault
+			TripTime = Now;
+			TripViolationStartTime = ViolationStartTime[J];
+			IsLatencyMeasurementPending = true;
+			atomic_store_explicit( &FaultLatency, 0, memory_order_release );
+			atomic_store_explicit( &FaultViolationLatency, 0, memory_order_release );
+			atomic_store_explicit( &FaultMeasurement, Measured, memory_order_release );
+			atomic_store_explicit( &FaultChannel, J, memory_order_release );
+			atomic_store_explicit( &FaultCode, Fault, memory_order_release );
+			atomic_store_explicit( &TripRequest, true, memory_order_release );
+
+			char DebugLine[DEBUG_LINE_LENGTH];
+			TextBuffer Line;
+			initializeTextBuffer( &Line, DebugLine, sizeof(DebugLine) );
+			appendTimeForDebugging( &Line );
+			appendText( &Line, "\ttrip\t" );
+			appendUnsigned( &Line, (uint32_t)J+1 );
+			appendText( &Line, "\tF=" );
+			appendUnsigned( &Line, Fault );
+			appendCharacter( &Line, '\t' );
+			appendSigned( &Line, Measured );
+			appendCharacter( &Line, '\t' );
+			appendSigned( &Line, Deviation );
+			appendText( &Line, "\n" );
+			printDebugText( DebugLine );
+			return;
+		}
+	}
+#endif
+}
+
+/// @brief This function takes the request for fast zeroing (it is to be called by the state machine in psu_talks.c)
+/// @param ChannelPtr the channel that tripped is stored here
+/// @return true if a new fault has been latched since the previous call
+bool takeTripRequest( uint16_t *ChannelPtr ){
+	if (!atomic_exchange_explicit( &TripRequest, false, memory_order_acq_rel )){
+		return false;
+	}
+	*ChannelPtr = atomic_load_explicit( &FaultChannel, memory_order_acquire );
+	return true;
+}
+
+/// @brief This function is called by the timer interrupt after each write to a DAC; it measures the trip latencies
+void registerDacWrite( uint16_t Channel ){
+	if (IsLatencyMeasurementPending &&
+			(Channel == atomic_load_explicit( &FaultChannel, memory_order_acquire )) &&
+			(getDacZeroOffset( Channel ) == WrittenToDacValue[Channel]))
+	{
+		uint32_t Now = time_us_32();
+		IsLatencyMeasurementPending = false;
+		atomic_store_explicit( &FaultLatency, Now - TripTime, memory_order_release );
+		// rounded up, so that a measured latency is never reported as 0 (not yet)
+		atomic_store_explicit( &FaultViolationLatency, (Now - TripViolationStartTime + 999) / 1000, memory_order_release );
+	}
+}
+
+/// @brief This function returns true if a fault is latched
+bool isTripLatched(void){
+	return TRIP_FAULT_NONE != atomic_load_explicit( &FaultCode, memory_order_acquire );
+}
+
+/// @brief This function copies the information on the latched fault
+void getTripReport( TripReport *ReportPtr ){
+	ReportPtr->FaultCode = atomic_load_explicit( &FaultCode, memory_order_acquire );
+	ReportPtr->Channel = atomic_load_explicit( &FaultChannel, memory_order_acquire );
+	ReportPtr->MeasuredMicroAmperes = atomic_load_explicit( &FaultMeasurement, memory_order_acquire );
+	ReportPtr->ViolationToZeroingInMilliseconds = atomic_load_explicit( &FaultViolationLatency, memory_order_acquire );
+	ReportPtr->LatchToZeroingInMicroseconds = atomic_load_explicit( &FaultLatency, memory_order_acquire );
+}
+
+/// @brief This function clears the latched fault
+void resetTripMonitor(void){
+	atomic_store_explicit( &FaultCode, TRIP_FAULT_NONE, memory_order_release );
+}
+
+/// @brief This function sets the tolerance of the deviation from the setpoint (0 disables the deviation check)
+bool setTripTolerance( int32_t MicroAmperes ){
+	if ((MicroAmperes < 0) || (MicroAmperes > TRIP_OVERCURRENT_LIMIT_IN_MICROAMPERES)){
+		return false;
+	}
+	atomic_store_explicit( &TripTolerance, MicroAmperes, memory_order_release );
+	return true;
+}
+
+/// @brief This function returns the tolerance of the deviation from the setpoint
+int32_t getTripTolerance(void){
+	return atomic_load_explicit( &TripTolerance, memory_order_acquire );
+}
+
+/// @brief This function sets the time for which a violation must last to trip
+bool setTripTime( uint32_t Milliseconds ){
+	if (Milliseconds > TRIP_MAX_TIME_IN_MILLISECONDS){
+		return false;
+	}
+	atomic_store_explicit( &TripTimeInMilliseconds, Milliseconds, memory_order_release );
+	return true;
+}
+
+/// @brief This function returns the time for which a violation must last to trip
+uint32_t getTripTime(void){
+	return atomic_load_explicit( &TripTimeInMilliseconds, memory_order_acquire );
+}
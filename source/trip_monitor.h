@@ -0,0 +1,97 @@
+/// @file trip_monitor.h
+/// @brief This module compares the measured currents with the values written to the DACs
+///
+/// The monitor is called by the timer interrupt handler after each ADC sampling.
+/// If the averaged measurement of a channel deviates from its setpoint by more than the tolerance for longer than
+/// the trip time (or if it exceeds the overcurrent limit for that time), a fault is latched and the higher-level
+/// state machine (psu_talks.c) zeroes all the DACs immediately, without the ramp, and switches the contactor off.
+/// The fault stays latched (and blocks powering up) until it is reset by the RE command.
+/// Only the channels with their own ADC input (the first NUMBER_OF_ADC_INPUTS channels) are monitored.
+/// The nominal ADC range is -10 V ... +9.995 V (1 uA per uV), so no measurement exceeds 10 A: the overcurrent check
+/// detects a measurement near the end of the range (TRIP_OVERCURRENT_LIMIT_IN_MICROAMPERES, reached by a railed ADC,
+/// the typical signature of a runaway channel) while the setpoint is below the limit; a channel set above the limit
+/// is not checked for overcurrent (the ADC cannot tell it from a normal output).
+/// The scale of the current monitor output (1 V = 1 A) has not been confirmed, so the deviation check is off
+/// by default (the tolerance is 0); it is enabled by the TRIPTOL command once the scale is known to be right.
+/// Thus, with the defaults, only the overcurrent check is active.
+/// Two latencies are reported: from the start of the violation (the first averaged measurement out of the limits)
+/// to zeroing the DAC, which includes the trip time, and from latching the fault to zeroing the DAC. The averaged
+/// measurement itself follows a change of the current with a delay of up to the averaging window (about 1 s).
+
+#ifndef SOURCE_TRIP_MONITOR_H_
+#define SOURCE_TRIP_MONITOR_H_
+
+#include <stdatomic.h>
+#include "pico/stdlib.h"
+#include "config.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+#define TRIP_FAULT_NONE					0
+#define TRIP_FAULT_DEVIATION			1	// measured current differs from the setpoint
+#define TRIP_FAULT_OVERCURRENT			2	// measured current exceeds TRIP_OVERCURRENT_LIMIT_IN_MICROAMPERES
+
+/// 99% of the nominal ADC range; a railed ADC input reads beyond it (unless its gain is calibrated below 0.99)
+#define TRIP_OVERCURRENT_LIMIT_IN_MICROAMPERES	9900000
+
+#define TRIP_DEFAULT_TOLERANCE_IN_MICROAMPERES	0	// the deviation check is off
+#define TRIP_DEFAULT_TIME_IN_MILLISECONDS		1000
+#define TRIP_MAX_TIME_IN_MILLISECONDS			60000
+
+//---------------------------------------------------------------------------------------------------
+// Global constants
+//---------------------------------------------------------------------------------------------------
+
+/// Information on the latched fault
+typedef struct {
+	uint16_t FaultCode;						// takes values TRIP_FAULT_...
+	uint16_t Channel;						// index of the channel that tripped
+	int32_t MeasuredMicroAmperes;			// measurement at the moment of the trip
+	uint32_t ViolationToZeroingInMilliseconds;	// time from the start of the violation to zeroing the DAC (0 = not yet)
+	uint32_t LatchToZeroingInMicroseconds;		// time from latching the fault to zeroing the DAC (0 = not yet)
+} TripReport;
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function initializes the module variables
+void initializeTripMonitor(void);
+
+/// @brief This function checks the measured currents of all monitored channels; it is to be called by timer interrupt
+void monitorChannelCurrents(void);
+
+/// @brief This function takes the request for fast zeroing (it is to be called by the state machine in psu_talks.c)
+/// @param ChannelPtr the channel that tripped is stored here
+/// @return true if a new fault has been latched since the previous call
+bool takeTripRequest( uint16_t *ChannelPtr );
+
+/// @brief This function is called by the timer interrupt after each write to a DAC; it measures the trip latencies
+void registerDacWrite( uint16_t Channel );
+
+/// @brief This function returns true if a fault is latched
+bool isTripLatched(void);
+
+/// @brief This function copies the information on the latched fault
+void getTripReport( TripReport *ReportPtr );
+
+/// @brief This function clears the latched fault
+void resetTripMonitor(void);
+
+/// @brief This function sets the tolerance of the deviation from the setpoint (0 disables the deviation check)
+/// @return false if the argument is out of range
+bool setTripTolerance( int32_t MicroAmperes );
+
+/// @brief This function returns the tolerance of the deviation from the setpoint
+int32_t getTripTolerance(void);
+
+/// @brief This function sets the time for which a violation must last to trip
+/// @return false if the argument is out of range
+bool setTripTime( uint32_t Milliseconds );
+
+/// @brief This function returns the time for which a violation must last to trip
+uint32_t getTripTime(void);
+
+#endif // SOURCE_TRIP_MONITOR_H_
@@ -7,13 +7,14 @@
 #include "hardware/regs/uart.h"
 #include "hardware/irq.h"
 #include "hardware/gpio.h"
+#include "hardware/dma.h"
 
 #include "uart_talks.h"
-#include "rstl_protocol.h"
-#include "ring_spsc.h"
+#include "line_store.h"
 #include "debugging.h"
+#include "metrics.h"
 
-#include <stdio.h>		// just for debugging
+#include <string.h>
 #include <assert.h>
 
 //---------------------------------------------------------------------------------------------------
@@ -21,22 +22,57 @@
 //---------------------------------------------------------------------------------------------------
 
 #define UART_ID				uart0
-#define UART_BAUD_RATE		4800
+#define UART_BAUD_RATE		4800		// default rate
 #define GPIO_FOR_UART_TX 	0
 #define GPIO_FOR_UART_RX 	1
 #define UART_IRQ			UART0_IRQ
 #define UART_DATA_BITS		8
 #define UART_PARITY			UART_PARITY_NONE
 
-#define UART_INPUT_BUFFER_SIZE				32			// buffer size (must be power-of-two)
-#define UART_OUTPUT_BUFFER_SIZE				128			// buffer size (must be power-of-two)
-#define SILENCE_DETECTION_IN_MICROSECONDS	6250		// 3 bytes for the given baud rate
+#define UART_OUTPUT_BUFFER_SIZE_BITS		9
+#define UART_OUTPUT_BUFFER_SIZE				(1u << UART_OUTPUT_BUFFER_SIZE_BITS)	// the DMA read address wraps at this size
+#define TRANSMIT_QUEUE_LENGTH				8			// number of messages (must be power-of-two)
+#define UART_BITS_PER_CHARACTER				10			// start bit, 8 data bits, stop bit
+#define SILENCE_DETECTION_IN_CHARACTERS		3
 #define REPLACEMENT_FOR_UNPRINTABLE			'~'
 
-#define UART_ERROR_INPUT_BUFFER_OVERFLOW		0x01
-#define UART_WARNING_INCOMING_WHILE_OUTGOING	0x02
+/// The PL011 FIFOs are 32 bytes deep; RX interrupt at 1/2 full (16 bytes); the TX FIFO is fed by DMA.
+/// The rest of a frame (below the RX level) is received after the receive timeout (32 bit periods of silence).
+#define UART_RX_FIFO_LEVEL_HALF				2
+#define UART_TX_DMA_IRQ						DMA_IRQ_0
+
+/// The new baud rate must be confirmed by a proper command received at this rate within this time
+#define BAUD_RATE_CONFIRMATION_TIMEOUT_IN_MICROSECONDS	3000000
+
+/// Auto-baud: the measurement ends after this number of low pulses or after the timeout
+#define AUTO_BAUD_LOW_PULSES				16
+#define AUTO_BAUD_TIMEOUT_IN_MICROSECONDS	3000000
 
 static_assert( LONGEST_RESPONSE_LENGTH < UART_OUTPUT_BUFFER_SIZE, "static_assert LONGEST_RESPONSE_LENGTH < UART_OUTPUT_BUFFER_SIZE" );
+static_assert( LONGEST_BATCH_RESPONSE_LENGTH < UART_OUTPUT_BUFFER_SIZE, "static_assert LONGEST_BATCH_RESPONSE_LENGTH < UART_OUTPUT_BUFFER_SIZE" );
+static_assert( 0 == (TRANSMIT_QUEUE_LENGTH & (TRANSMIT_QUEUE_LENGTH-1)), "static_assert TRANSMIT_QUEUE_LENGTH is a power of two" );
+
+typedef enum{
+	BAUD_RATE_STABLE,
+	BAUD_RATE_SWITCH_PENDING,			// the switch waits until the response has been sent
+	BAUD_RATE_AWAITING_CONFIRMATION		// the new rate is set; the old one is restored after the timeout
+}BaudRateStates;
+
+/// A message waiting for transmission (or being transmitted)
+typedef struct {
+	const uint8_t *DataPtr;
+	uint16_t Length;
+	bool IsInOutputBuffer;				// true: the data has been copied to UartOutputBuffer; false: static data
+	bool IsAbortable;					// true: the transmission is stopped when a byte is received (telemetry)
+	TransmitCallback Callback;			// called in the DMA interrupt when the message has been written to the TX FIFO
+}TransmitDescriptor;
+
+//---------------------------------------------------------------------------------------------------
+// Global constants
+//---------------------------------------------------------------------------------------------------
+
+/// Baud rates accepted by setSerialPortBaudRate and detected by the auto-baud
+static const uint32_t StandardBaudRates[] = { 4800, 9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600 };
 
 //---------------------------------------------------------------------------------------------------
 // Global variables
@@ -45,22 +81,92 @@ static_assert( LONGEST_RESPONSE_LENGTH < UART_OUTPUT_BUFFER_SIZE, "static_assert
 /// @brief This variable is used in UART interrupt handler
 atomic_uint_fast16_t UartError;
 
+/// @brief Number of messages rejected because the transmit queue or the output buffer was full
+atomic_uint_fast32_t TransmitOverflows;
+
 //---------------------------------------------------------------------------------------------------
 // Local variables
 //---------------------------------------------------------------------------------------------------
 
-/// @brief This variable is used in UART interrupt handler
-static char UartInputBuffer[UART_INPUT_BUFFER_SIZE];
+/// The frames are assembled in place by the UART interrupt handler; the main loop interprets the previous frame
+/// in the other buffer
+static char LineBuffers[2][LINE_BUFFER_SIZE];
+
+static line_store_t LineStore;
 
-static ring_spsc_t InputRingBuffer;
+/// The frame given by serialPortReceiver is held until the next call (main loop only)
+static bool IsFrameTaken;
+
+/// WhenReceivedLastByte at the last check of silence (main loop only)
+static uint64_t LastSilenceCheckedReception;
 
 /// @brief This variable is used in UART interrupt handler
 static atomic_uint_fast64_t WhenReceivedLastByte;
 
-/// @brief This variable is used in UART interrupt handler
-static char UartOutputBuffer[UART_OUTPUT_BUFFER_SIZE];
+/// The copies of the messages; the DMA reads the buffer in the ring mode, so a message may wrap around its end
+static uint8_t UartOutputBuffer[UART_OUTPUT_BUFFER_SIZE] __attribute__((aligned(UART_OUTPUT_BUFFER_SIZE)));
+
+/// Number of bytes written to UartOutputBuffer (modified in the main loop only)
+static uint32_t OutputBufferHead;
+
+/// Number of bytes released from UartOutputBuffer (modified in the DMA interrupt only)
+static atomic_uint_fast32_t OutputBufferTail;
+
+static TransmitDescriptor TransmitQueue[TRANSMIT_QUEUE_LENGTH];
+
+/// Number of messages put into the queue (modified in the main loop only)
+static atomic_uint_fast32_t TransmitQueueHead;
+
+/// Number of messages sent; the message at this position is being sent (modified in the DMA interrupt only)
+static atomic_uint_fast32_t TransmitQueueTail;
+
+static atomic_bool IsDmaTransmitting;
+
+/// The last message has been passed to the TX FIFO, but it may still be in the FIFO
+static atomic_bool IsResponseTailInFifo;
+
+/// The same for an unsolicited (abortable) message: its tail is stopped like the message itself
+static atomic_bool IsUnsolicitedTailInFifo;
+
+/// The transmitter has been stopped by the abort of an unsolicited message (the rest of it is still in the TX FIFO);
+/// no message is started until the master has finished sending and the FIFO has been flushed (releaseTransmitter)
+static atomic_bool IsTransmitterHeld;
+
+static uint TxDmaChannel;
+
+static dma_channel_config TxDmaConfigForOutputBuffer;
+
+static dma_channel_config TxDmaConfigForStaticData;
+
+// These variables are used in the main loop only
+
+static uint32_t BaudRate;
+
+static uint32_t PreviousBaudRate;
+
+static BaudRateStates BaudRateState;
 
-static ring_spsc_t OutputRingBuffer;
+static uint64_t BaudRateDeadline;
+
+/// The rate-dependent timings
+static uint32_t CharacterTimeInMicroseconds;
+
+static uint32_t SilenceDetectionInMicroseconds;
+
+static uint64_t LastForcedDrainTime;
+
+// These variables are used by the frame assemblers in the UART interrupt handler
+// (and in the main loop with the UART interrupt disabled)
+
+static char PreviousByte;
+
+static bool IsFrameTooLong;
+
+/// The binary mode; the variable is modified in the main loop and read in the UART interrupt handler (no echo)
+static atomic_bool IsBinaryMode;
+
+/// The received bytes are echoed (text mode only); the variable is modified in the main loop and read in the UART interrupt handler
+static atomic_bool IsEchoEnabled;
 
 //---------------------------------------------------------------------------------------------------
 // Local function prototypes
@@ -71,8 +177,71 @@ static ring_spsc_t OutputRingBuffer;
 /// @callergraph
 static void serialPortInterruptHandler( void );
 
-/// Function that checks whether TX IRQ is enabled
-static inline bool is_tx_irq_enabled(uart_inst_t *uart);
+/// @brief This function forces the UART interrupt if there are bytes in the RX FIFO (below its interrupt level)
+/// The receive timeout lasts 32 bit periods; the forced interrupt makes the bytes available at once.
+static void forceReceiveFifoDrain( uint64_t Now );
+
+/// @brief This function assembles the binary frame according to the length byte (called in the UART interrupt handler)
+/// The frame is passed to the main loop when it is complete (the CRC is not checked here).
+static void assembleBinaryFrame( uint8_t NewByte );
+
+/// @brief This function assembles the text frame byte by byte (called in the UART interrupt handler)
+/// With COMMAND_FRAMING_BY_TERMINATOR, the frame is passed to the main loop as soon as "\r\n" is received.
+static void assembleTextFrame( char NewByte );
+
+/// @brief This function passes the text frame to the main loop (a frame that is too long is dropped)
+static void completeTextFrame(void);
+
+/// @brief This function completes (text mode) or drops (binary mode) the frame after a period of silence
+static void closeFrameAfterSilence( uint64_t Now );
+
+/// @brief This function drops the frame being assembled; the UART interrupt is disabled meanwhile
+static void resetFrameAssembly(void);
+
+/// @brief This function drives the baud rate switching (the handshake with the master)
+static void driveBaudRateSwitching(void);
+
+/// @brief This function prints a debug line about the baud rate switching
+static void printBaudRateEvent( const char *Event );
+
+/// @brief This function sets the baud rate and the timings that depend on it
+static void applyBaudRate( uint32_t NewBaudRate );
+
+#if UART_AUTO_BAUD_AT_BOOT == 1
+/// @brief This function measures the shortest low pulse on the RX line (one bit) and finds the nearest standard baud rate
+/// @return the detected baud rate or UART_BAUD_RATE if nothing has been received
+static uint32_t detectBaudRate(void);
+#endif
+
+/// @brief This is an interrupt handler of the DMA channel that feeds the TX FIFO; it starts the next message
+static void transmitDmaInterruptHandler( void );
+
+/// @brief This function puts a message into the transmit queue
+static int8_t enqueueMessage( const uint8_t *DataPtr, size_t Length, bool IsCopied, bool IsAbortable, TransmitCallback Callback );
+
+/// @brief This function starts the DMA transfer of the message at the tail of the transmit queue
+static void startNextMessage(void);
+
+/// @brief This function releases the message that has been sent (or aborted) and starts the next one
+/// The function is called only in the interrupt handlers.
+static void completeMessage(void);
+
+/// @brief This function stops the transmission of an abortable message (called in the UART interrupt handler)
+/// The transmitter is disabled, so only the character being sent goes out; the rest of the message stays
+/// in the TX FIFO until releaseTransmitter.
+/// @return true if the message has been aborted
+static bool abortUnsolicitedMessage(void);
+
+/// @brief This function flushes the TX FIFO and enables the transmitter after an abort (main loop only)
+/// It waits until the master has stopped sending: the PL011 flushes both FIFOs at once, with the UART disabled.
+static void releaseTransmitter( uint64_t Now );
+
+/// Function that checks whether a response is being sent (the last bytes may still be in the TX FIFO)
+static inline bool isResponseBeingSent(void);
+
+/// Function that enables the RX interrupts (FIFO level and receive timeout);
+/// uart_set_irq_enables is not used because it changes the FIFO levels
+static inline void setUartInterrupts(uart_inst_t *uart);
 
 //---------------------------------------------------------------------------------------------------
 // Function definitions
@@ -81,137 +250,651 @@ static inline bool is_tx_irq_enabled(uart_inst_t *uart);
 /// @brief This function initializes hardware port (UART) and initializes state machines for serial communication
 void serialPortInitialization(void){
 
-	ringSpscInit( &InputRingBuffer, (uint8_t*)UartInputBuffer, UART_INPUT_BUFFER_SIZE );
-	ringSpscInit( &OutputRingBuffer, (uint8_t*)UartOutputBuffer, UART_OUTPUT_BUFFER_SIZE );
-
+	lineStoreInit( &LineStore, LineBuffers[0], LineBuffers[1], LINE_BUFFER_SIZE );
+	IsFrameTaken = false;
+	LastSilenceCheckedReception = 0;
+
+	OutputBufferHead = 0;
+	atomic_store_explicit( &OutputBufferTail, 0, memory_order_relaxed );
+	atomic_store_explicit( &TransmitQueueHead, 0, memory_order_relaxed );
+	atomic_store_explicit( &TransmitQueueTail, 0, memory_order_relaxed );
+	atomic_store_explicit( &IsDmaTransmitting, false, memory_order_relaxed );
+	atomic_store_explicit( &IsResponseTailInFifo, false, memory_order_relaxed );
+	atomic_store_explicit( &IsUnsolicitedTailInFifo, false, memory_order_relaxed );
+	atomic_store_explicit( &IsTransmitterHeld, false, memory_order_relaxed );
+	atomic_store_explicit( &TransmitOverflows, 0, memory_order_relaxed );
 	atomic_store_explicit( &UartError, 0, memory_order_relaxed );
 	atomic_store_explicit( &WhenReceivedLastByte, 0, memory_order_relaxed );
+	atomic_store_explicit( &IsBinaryMode, false, memory_order_relaxed );
+	atomic_store_explicit( &IsEchoEnabled, true, memory_order_relaxed );
+
+#if UART_AUTO_BAUD_AT_BOOT == 1
+	BaudRate = detectBaudRate();
+#else
+	BaudRate = UART_BAUD_RATE;
+#endif
+	BaudRateState = BAUD_RATE_STABLE;
 
-	uart_init(UART_ID, UART_BAUD_RATE);
+	uart_init(UART_ID, BaudRate);
     gpio_set_function(GPIO_FOR_UART_TX, UART_FUNCSEL_NUM(UART_ID, GPIO_FOR_UART_TX));
     gpio_set_function(GPIO_FOR_UART_RX, UART_FUNCSEL_NUM(UART_ID, GPIO_FOR_UART_RX));
-    uart_set_baudrate( UART_ID, UART_BAUD_RATE );
+    applyBaudRate( BaudRate );
     uart_set_hw_flow(UART_ID, false, false);
     uart_set_format( UART_ID, UART_DATA_BITS, 1, UART_PARITY );
-    uart_set_fifo_enabled(UART_ID, false);
+    uart_set_fifo_enabled(UART_ID, true);
+    hw_write_masked( &uart_get_hw(UART_ID)->ifls, UART_RX_FIFO_LEVEL_HALF << UART_UARTIFLS_RXIFLSEL_LSB,
+			UART_UARTIFLS_RXIFLSEL_BITS );
+
+    // DMA channel feeding the TX FIFO; two configurations: for UartOutputBuffer (ring) and for static data
+    TxDmaChannel = (uint)dma_claim_unused_channel( true );
+    TxDmaConfigForStaticData = dma_channel_get_default_config( TxDmaChannel );
+    channel_config_set_transfer_data_size( &TxDmaConfigForStaticData, DMA_SIZE_8 );
+    channel_config_set_read_increment( &TxDmaConfigForStaticData, true );
+    channel_config_set_write_increment( &TxDmaConfigForStaticData, false );
+    channel_config_set_dreq( &TxDmaConfigForStaticData, uart_get_dreq( UART_ID, true ));
+    TxDmaConfigForOutputBuffer = TxDmaConfigForStaticData;
+    channel_config_set_ring( &TxDmaConfigForOutputBuffer, false, UART_OUTPUT_BUFFER_SIZE_BITS );
+    dma_channel_configure( TxDmaChannel, &TxDmaConfigForStaticData, &uart_get_hw(UART_ID)->dr, NULL, 0, false );
+    dma_channel_set_irq0_enabled( TxDmaChannel, true );
+    irq_set_exclusive_handler( UART_TX_DMA_IRQ, transmitDmaInterruptHandler );
+    irq_set_enabled( UART_TX_DMA_IRQ, true );
 
 	irq_set_exclusive_handler(UART_IRQ, serialPortInterruptHandler);
     irq_set_enabled(UART_IRQ, true);
-    uart_set_irq_enables( UART_ID, true, false );
-}
-
-/// @brief This function drives the state machine that receives frames via serial port
-/// @return true if a new command has been received correctly via UART
-/// @return false if there is no new command or there is an incorrect command
-bool serialPortReceiver(void){
-	bool Result = false;
-
-	if (!ringSpscIsEmpty( &InputRingBuffer )){
-		// The input buffer is not empty
-
-		uint64_t Now = time_us_64();
-		if (atomic_load_explicit( &WhenReceivedLastByte, memory_order_relaxed ) + SILENCE_DETECTION_IN_MICROSECONDS < Now){
-			// silence detected in receiver
-
-			bool ReceivedData = true;
-			int16_t Index = 0;
-			Result = true;
-			while (!ringSpscIsEmpty( &InputRingBuffer )){
-				ReceivedData = ringSpscPop( &InputRingBuffer, (uint8_t*)&NewCommand[Index] );
-				if (!ReceivedData){
-					break; // should never happen
-				}
-				Index++;
-				if (Index > LONGEST_COMMAND_LENGTH){
-					Result = false;
-					break;
-				}
-				if (Index >= COMMAND_BUFFER_LENGTH-1){
-					Result = false;
-					break;
-				}
+    setUartInterrupts( UART_ID );
+}
+
+/// @brief This function gives the main loop the frame received via serial port
+/// The frame stays in place (in the line store) until the next call of this function.
+/// @return true if a new frame has been received
+/// @return false if there is no new frame
+bool serialPortReceiver( const char **FramePtr, uint16_t *LengthPtr ){
+	if (IsFrameTaken){
+		// the previous frame has been interpreted; its buffer is returned to the interrupt handler
+		lineStoreRelease( &LineStore );
+		IsFrameTaken = false;
+	}
+	driveBaudRateSwitching();
+	uint64_t Now = time_us_64();
+	releaseTransmitter( Now );
+	forceReceiveFifoDrain( Now );
+	closeFrameAfterSilence( Now );
+	IsFrameTaken = lineStoreTake( &LineStore, FramePtr, LengthPtr );
+	return IsFrameTaken;
+}
+
+/// @brief This function switches between the text (RSTL) mode and the binary mode
+void setSerialPortBinaryMode( bool IsBinary ){
+	atomic_store_explicit( &IsBinaryMode, IsBinary, memory_order_relaxed );
+	resetFrameAssembly();
+}
+
+/// @brief This function returns true if the serial port works in the binary mode
+bool isSerialPortInBinaryMode(void){
+	return atomic_load_explicit( &IsBinaryMode, memory_order_relaxed );
+}
+
+/// @brief This function turns the echo of the received bytes on or off
+void setSerialPortEcho( bool IsEnabled ){
+	atomic_store_explicit( &IsEchoEnabled, IsEnabled, memory_order_relaxed );
+}
+
+/// @brief This function returns true if the received bytes are echoed
+bool isSerialPortEchoEnabled(void){
+	return atomic_load_explicit( &IsEchoEnabled, memory_order_relaxed );
+}
+
+static void forceReceiveFifoDrain( uint64_t Now ){
+	// The last bytes of a frame wait in the RX FIFO (below its interrupt level) for the receive timeout,
+	// which lasts 32 bit periods; the interrupt is forced instead, so that the end of the frame is seen at once
+	if (uart_is_readable( UART_ID ) && (LastForcedDrainTime + CharacterTimeInMicroseconds <= Now)){
+		LastForcedDrainTime = Now;
+		irq_set_pending( UART_IRQ );
+	}
+}
+
+static void assembleBinaryFrame( uint8_t NewByte ){
+	uint16_t Length = lineStoreLength( &LineStore );
+	if ((0 == Length) && (BINARY_FRAME_SYNC != NewByte)){
+		// garbage between frames is skipped
+		atomic_fetch_or_explicit( &UartError, UART_ERROR_BINARY_FRAME, memory_order_relaxed );
+		return;
+	}
+	lineStoreAppend( &LineStore, (char)NewByte );	// the length byte is checked, so the frame fits in the buffer
+	Length++;
+	if ((2 == Length) && ((NewByte < BINARY_FRAME_MIN_CONTENT) || (NewByte+BINARY_FRAME_OVERHEAD > LINE_BUFFER_SIZE))){
+		// improper length; the search for the sync byte starts again
+		atomic_fetch_or_explicit( &UartError, UART_ERROR_BINARY_FRAME, memory_order_relaxed );
+		lineStoreDiscard( &LineStore );
+	}
+	else if ((Length > 2) && (Length == (uint8_t)lineStoreByte( &LineStore, 1 )+BINARY_FRAME_OVERHEAD)){
+		// the next frame starts in the other buffer
+		if (lineStoreComplete( &LineStore )){
+			incrementMetric( METRIC_UART_FRAMES_IN );
+		}
+		else{
+			atomic_fetch_or_explicit( &UartError, UART_ERROR_INPUT_BUFFER_OVERFLOW, memory_order_relaxed );
+			incrementMetric( METRIC_UART_OVERFLOWS );
+		}
+	}
+}
+
+static void assembleTextFrame( char NewByte ){
+	if ((lineStoreLength( &LineStore ) >= LONGEST_COMMAND_LENGTH) || !lineStoreAppend( &LineStore, NewByte )){
+		IsFrameTooLong = true;	// the rest of the frame is dropped
+	}
+#if COMMAND_FRAMING_BY_TERMINATOR == 1
+	if (('\n' == NewByte) && ('\r' == PreviousByte)){
+		// terminator detected; the next frame starts in the other buffer
+		completeTextFrame();
+		return;
+	}
+	PreviousByte = NewByte;
+#endif
+}
+
+static void completeTextFrame(void){
+	if (IsFrameTooLong){
+		lineStoreDiscard( &LineStore );
+	}
+	else if (lineStoreComplete( &LineStore )){
+		incrementMetric( METRIC_UART_FRAMES_IN );
+	}
+	else{
+		// the main loop has not interpreted the previous frame yet
+		atomic_fetch_or_explicit( &UartError, UART_ERROR_INPUT_BUFFER_OVERFLOW, memory_order_relaxed );
+		incrementMetric( METRIC_UART_OVERFLOWS );
+	}
+	PreviousByte = 0;
+	IsFrameTooLong = false;
+}
+
+static void closeFrameAfterSilence( uint64_t Now ){
+	// Bytes waiting in the RX FIFO (below the interrupt level) mean that the transmission is still going on
+	uint64_t LastReception = atomic_load_explicit( &WhenReceivedLastByte, memory_order_relaxed );
+	if ((LastReception == LastSilenceCheckedReception) || (LastReception + SilenceDetectionInMicroseconds >= Now) ||
+			uart_is_readable( UART_ID ))
+	{
+		return;
+	}
+	LastSilenceCheckedReception = LastReception;
+
+	irq_set_enabled( UART_IRQ, false );
+	if ((0 != lineStoreLength( &LineStore )) || IsFrameTooLong){
+		if (atomic_load_explicit( &IsBinaryMode, memory_order_relaxed )){
+			// an incomplete binary frame is dropped
+			atomic_fetch_or_explicit( &UartError, UART_ERROR_BINARY_FRAME, memory_order_relaxed );
+			lineStoreDiscard( &LineStore );
+		}
+		else{
+			// a frame without the terminator (or garbage) is passed on
+			completeTextFrame();
+		}
+	}
+	irq_set_enabled( UART_IRQ, true );
+}
+
+static void resetFrameAssembly(void){
+	bool IsInterruptEnabled = irq_is_enabled( UART_IRQ );
+	irq_set_enabled( UART_IRQ, false );
+	lineStoreDiscard( &LineStore );
+	PreviousByte = 0;
+	IsFrameTooLong = false;
+	if (IsInterruptEnabled){
+		irq_set_enabled( UART_IRQ, true );
+	}
+}
+
+/// @brief This function requests the change of the baud rate
+/// The new rate is set after the response to the present command has been sent. If no proper command
+/// is received at the new rate within BAUD_RATE_CONFIRMATION_TIMEOUT_IN_MICROSECONDS, the old rate is restored.
+/// @return false if the rate is not one of StandardBaudRates or the previous change is not completed
+bool setSerialPortBaudRate( uint32_t NewBaudRate ){
+	if (BAUD_RATE_STABLE != BaudRateState){
+		return false;
+	}
+	for (uint8_t J = 0; J < sizeof(StandardBaudRates)/sizeof(StandardBaudRates[0]); J++){
+		if (StandardBaudRates[J] == NewBaudRate){
+			PreviousBaudRate = BaudRate;
+			BaudRate = NewBaudRate;
+			BaudRateState = BAUD_RATE_SWITCH_PENDING;
+			return true;
+		}
+	}
+	return false;
+}
+
+/// @brief This function returns the baud rate in use (or the one that is going to be set)
+uint32_t getSerialPortBaudRate(void){
+	return BaudRate;
+}
+
+/// @brief This function is called after a proper command has been received; it confirms the new baud rate
+void confirmSerialPortBaudRate(void){
+	if (BAUD_RATE_AWAITING_CONFIRMATION == BaudRateState){
+		BaudRateState = BAUD_RATE_STABLE;
+		printBaudRateEvent( " confirmed\n" );
+	}
+}
+
+static void printBaudRateEvent( const char *Event ){
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	initializeTextBuffer( &Line, DebugLine, sizeof(DebugLine) );
+	appendTimeForDebugging( &Line );
+	appendText( &Line, "\tbaud rate " );
+	appendUnsigned( &Line, BaudRate );
+	appendText( &Line, Event );
+	printDebugText( DebugLine );
+}
+
+static void driveBaudRateSwitching(void){
+	if (BAUD_RATE_SWITCH_PENDING == BaudRateState){
+		uint32_t Flags = uart_get_hw(UART_ID)->fr;
+		if ((atomic_load_explicit( &TransmitQueueHead, memory_order_acquire ) == atomic_load_explicit( &TransmitQueueTail, memory_order_acquire )) &&
+				(0 != (Flags & UART_UARTFR_TXFE_BITS)) && (0 == (Flags & UART_UARTFR_BUSY_BITS)))
+		{
+			// the response has been sent at the old rate
+			applyBaudRate( BaudRate );
+			BaudRateDeadline = time_us_64() + BAUD_RATE_CONFIRMATION_TIMEOUT_IN_MICROSECONDS;
+			BaudRateState = BAUD_RATE_AWAITING_CONFIRMATION;
+		}
+	}
+	else if (BAUD_RATE_AWAITING_CONFIRMATION == BaudRateState){
+		if (time_us_64() > BaudRateDeadline){
+			// the master cannot talk at the new rate
+			printBaudRateEvent( " not confirmed\n" );
+			BaudRate = PreviousBaudRate;
+			applyBaudRate( BaudRate );
+			BaudRateState = BAUD_RATE_STABLE;
+		}
+	}
+}
+
+static void applyBaudRate( uint32_t NewBaudRate ){
+	uart_set_baudrate( UART_ID, NewBaudRate );
+	CharacterTimeInMicroseconds = (UART_BITS_PER_CHARACTER * 1000000 + NewBaudRate - 1) / NewBaudRate;
+	SilenceDetectionInMicroseconds = SILENCE_DETECTION_IN_CHARACTERS * CharacterTimeInMicroseconds;
+	setMetric( METRIC_UART_BAUD_RATE, NewBaudRate );
+
+	// whatever has been received during the change is dropped; the assembler starts again
+	resetFrameAssembly();
+	if (!IsFrameTaken){
+		lineStoreRelease( &LineStore );
+	}
+}
+
+#if UART_AUTO_BAUD_AT_BOOT == 1
+static uint32_t detectBaudRate(void){
+	gpio_init( GPIO_FOR_UART_RX );
+	gpio_set_dir( GPIO_FOR_UART_RX, GPIO_IN );
+	gpio_pull_up( GPIO_FOR_UART_RX );
+
+	uint32_t ShortestLowPulse = UINT32_MAX;
+	uint8_t LowPulses = 0;
+	uint32_t StartTime = time_us_32();
+	while ((LowPulses < AUTO_BAUD_LOW_PULSES) && (time_us_32() - StartTime < AUTO_BAUD_TIMEOUT_IN_MICROSECONDS)){
+		if (!gpio_get( GPIO_FOR_UART_RX )){
+			uint32_t FallingEdgeTime = time_us_32();
+			while (!gpio_get( GPIO_FOR_UART_RX ) && (time_us_32() - FallingEdgeTime < AUTO_BAUD_TIMEOUT_IN_MICROSECONDS)){
 			}
-			NewCommand[Index] = 0;
+			uint32_t PulseLength = time_us_32() - FallingEdgeTime;
+			if (PulseLength < ShortestLowPulse){
+				ShortestLowPulse = PulseLength;
+			}
+			LowPulses++;
 		}
 	}
+	if (0 == LowPulses){
+		return UART_BAUD_RATE;
+	}
 
+	// the nearest bit time; the resolution of the measurement (1 us) is sufficient up to 115200 Bd
+	uint32_t Result = UART_BAUD_RATE;
+	uint32_t SmallestError = UINT32_MAX;
+	for (uint8_t J = 0; J < sizeof(StandardBaudRates)/sizeof(StandardBaudRates[0]); J++){
+		uint32_t BitTime = 1000000 / StandardBaudRates[J];
+		uint32_t Error = (BitTime > ShortestLowPulse)? BitTime - ShortestLowPulse : ShortestLowPulse - BitTime;
+		if (Error < SmallestError){
+			SmallestError = Error;
+			Result = StandardBaudRates[J];
+		}
+	}
+	char DebugLine[DEBUG_LINE_LENGTH];
+	TextBuffer Line;
+	initializeTextBuffer( &Line, DebugLine, sizeof(DebugLine) );
+	appendText( &Line, "auto-baud: low pulse " );
+	appendUnsigned( &Line, ShortestLowPulse );
+	appendText( &Line, " us -> " );
+	appendUnsigned( &Line, Result );
+	appendText( &Line, " Bd\n" );
+	printDebugText( DebugLine );
 	return Result;
 }
+#endif
 
-/// @brief This function starts sending the data stored in TextToBeSent
-/// The function writes the first byte to UART (FIFO input buffer of UART),
-/// and copies the next bytes from TextToBeSent to UartOutputBuffer.
-/// See the assumptions specified in the module description.
+/// @brief This function puts a copy of the text into the transmit queue
+/// The text is copied to UartOutputBuffer, so the caller may reuse its buffer at once.
 /// @param TextToBeSent pointer to a string (character with code zero cannot be sent)
 /// @return 0 on success
-/// @return -1 on failure
+/// @return -1 on failure (improper argument or the queue is full)
 int8_t transmitViaSerialPort( const char* TextToBeSent ){
-	bool Result = true;
 	if (NULL == TextToBeSent){
 		return -1; // improper value of the argument
 	}
-	char FirstCharacter = TextToBeSent[0];
-	if (0 == FirstCharacter){
-		return -1; // incorrect value pointed to by argument
+	return enqueueMessage( (const uint8_t*)TextToBeSent, strlen( TextToBeSent ), true, false, NULL );
+}
+
+/// @brief This function puts the text into the transmit queue without copying it
+/// @param TextToBeSent pointer to a string that stays unchanged until it has been sent (e.g. a string literal)
+/// @param Callback function called in the DMA interrupt when the text has been written to the TX FIFO (may be NULL)
+/// @return 0 on success
+/// @return -1 on failure (improper argument or the queue is full)
+int8_t transmitStaticViaSerialPort( const char* TextToBeSent, TransmitCallback Callback ){
+	if (NULL == TextToBeSent){
+		return -1; // improper value of the argument
 	}
+	return enqueueMessage( (const uint8_t*)TextToBeSent, strlen( TextToBeSent ), false, false, Callback );
+}
 
-	if (!ringSpscIsEmpty( &OutputRingBuffer )){
-		return -1; // The output buffer is not empty
+/// @brief This function puts a copy of the data (e.g. a binary frame) into the transmit queue
+int8_t transmitBytesViaSerialPort( const uint8_t *DataPtr, uint16_t Length ){
+	if (NULL == DataPtr){
+		return -1; // improper value of the argument
 	}
+	return enqueueMessage( DataPtr, Length, true, false, NULL );
+}
 
-	if (is_tx_irq_enabled(UART_ID) || !uart_is_writable( UART_ID )){
-		// TX UART interrupt is active (the UART is transmitting now)
-    	return -1;	// writing to the buffer during transmission should not occur
+/// @brief This function puts a copy of an unsolicited message (e.g. telemetry) into the transmit queue
+/// The transmission of the message is stopped as soon as a byte is received, so the master may start
+/// a command at any time; the message is then truncated.
+int8_t transmitUnsolicitedViaSerialPort( const char* TextToBeSent ){
+	if (NULL == TextToBeSent){
+		return -1; // improper value of the argument
 	}
-	// TX UART interrupt is not active now (the UART is not transmitting now)
-	// Prepare data in the UartOutputBuffer (beginning from the 2nd byte of TextToBeSent)
-	uint8_t Index = 1;
-	while (Result && (0 != TextToBeSent[Index])){ // The terminating character (zero) should not be sent
-		Result = ringSpscPush( &OutputRingBuffer, TextToBeSent[Index] );
-		Index++;
+	return enqueueMessage( (const uint8_t*)TextToBeSent, strlen( TextToBeSent ), true, true, NULL );
+}
+
+/// @brief This function returns true if nothing is being received or transmitted
+bool isSerialPortIdle(void){
+	if (!lineStoreIsEmpty( &LineStore ) || uart_is_readable( UART_ID )){
+		return false;		// a frame has been received or is being received
+	}
+	if (time_us_64() - atomic_load_explicit( &WhenReceivedLastByte, memory_order_relaxed ) < SilenceDetectionInMicroseconds){
+		return false;		// the master may be sending
 	}
-	uart_putc_raw( UART_ID, FirstCharacter ); 		// uart_putc is not good due to its CRLF support
-	uart_set_irq_enables( UART_ID, true, true );	// the next bytes will be sent in the interrupt handler
+	return !atomic_load_explicit( &IsDmaTransmitting, memory_order_acquire );
+}
 
-	return 0;
+// The operations of UartTransport; the serial port is the only link of this module, so LinkPtr is not used
+
+static bool receiveUartFrame( void *LinkPtr, const char **FramePtr, uint16_t *LengthPtr ){
+	(void)LinkPtr;
+	return serialPortReceiver( FramePtr, LengthPtr );
 }
 
-static void serialPortInterruptHandler( void ){
-//	changeDebugPin1(true);
+static int8_t transmitViaUart( void *LinkPtr, const uint8_t *DataPtr, uint16_t Length ){
+	(void)LinkPtr;
+	return transmitBytesViaSerialPort( DataPtr, Length );
+}
 
-	uint16_t UartErrorTemporary = 0;
-	if (uart_is_readable(UART_ID)){
-		char IncomingCharacter = uart_getc(UART_ID);
-		bool Result = ringSpscPush( &InputRingBuffer, IncomingCharacter );
-		if( !Result){
-			UartErrorTemporary |= UART_ERROR_INPUT_BUFFER_OVERFLOW;
+static int8_t transmitUnsolicitedViaUart( void *LinkPtr, const char *Text ){
+	(void)LinkPtr;
+	return transmitUnsolicitedViaSerialPort( Text );
+}
+
+static bool isUartIdle( void *LinkPtr ){
+	(void)LinkPtr;
+	return isSerialPortIdle();
+}
+
+static void setUartBinaryMode( void *LinkPtr, bool IsBinary ){
+	(void)LinkPtr;
+	setSerialPortBinaryMode( IsBinary );
+}
+
+static bool isUartInBinaryMode( void *LinkPtr ){
+	(void)LinkPtr;
+	return isSerialPortInBinaryMode();
+}
+
+static void setUartEcho( void *LinkPtr, bool IsEnabled ){
+	(void)LinkPtr;
+	setSerialPortEcho( IsEnabled );
+}
+
+static bool isUartEchoEnabled( void *LinkPtr ){
+	(void)LinkPtr;
+	return isSerialPortEchoEnabled();
+}
+
+static void reportUartFrameError( void *LinkPtr ){
+	(void)LinkPtr;
+	atomic_fetch_or_explicit( &UartError, UART_ERROR_BINARY_FRAME, memory_order_relaxed );
+}
+
+static bool setUartBaudRate( void *LinkPtr, uint32_t NewBaudRate ){
+	(void)LinkPtr;
+	return setSerialPortBaudRate( NewBaudRate );
+}
+
+static uint32_t getUartBaudRate( void *LinkPtr ){
+	(void)LinkPtr;
+	return getSerialPortBaudRate();
+}
+
+static void confirmUartBaudRate( void *LinkPtr ){
+	(void)LinkPtr;
+	confirmSerialPortBaudRate();
+}
+
+/// The operations of the serial port used by the RSTL session
+const SessionTransport UartTransport = {
+	.receiveFrame = receiveUartFrame,
+	.transmit = transmitViaUart,
+	.transmitUnsolicited = transmitUnsolicitedViaUart,
+	.isIdle = isUartIdle,
+	.setBinaryMode = setUartBinaryMode,
+	.isBinaryMode = isUartInBinaryMode,
+	.setEcho = setUartEcho,
+	.isEchoEnabled = isUartEchoEnabled,
+	.reportFrameError = reportUartFrameError,
+	.setBaudRate = setUartBaudRate,
+	.getBaudRate = getUartBaudRate,
+	.confirmBaudRate = confirmUartBaudRate,
+};
+
+static int8_t enqueueMessage( const uint8_t *DataPtr, size_t Length, bool IsCopied, bool IsAbortable, TransmitCallback Callback ){
+	if ((0 == Length) || (Length > UART_OUTPUT_BUFFER_SIZE)){
+		return -1; // incorrect value pointed to by argument
+	}
+
+	uint32_t QueueHead = atomic_load_explicit( &TransmitQueueHead, memory_order_relaxed );
+	if (QueueHead - atomic_load_explicit( &TransmitQueueTail, memory_order_acquire ) >= TRANSMIT_QUEUE_LENGTH){
+		atomic_fetch_add_explicit( &TransmitOverflows, 1, memory_order_relaxed );
+		atomic_fetch_or_explicit( &UartError, UART_ERROR_TRANSMIT_QUEUE_OVERFLOW, memory_order_relaxed );
+		incrementMetric( METRIC_UART_DROPPED_RESPONSES );
+		return -1;
+	}
+	TransmitDescriptor *DescriptorPtr = &TransmitQueue[QueueHead & (TRANSMIT_QUEUE_LENGTH-1)];
+
+	if (IsCopied){
+		uint32_t UsedBytes = OutputBufferHead - atomic_load_explicit( &OutputBufferTail, memory_order_acquire );
+		if (Length > UART_OUTPUT_BUFFER_SIZE - UsedBytes){
+			atomic_fetch_add_explicit( &TransmitOverflows, 1, memory_order_relaxed );
+			atomic_fetch_or_explicit( &UartError, UART_ERROR_TRANSMIT_QUEUE_OVERFLOW, memory_order_relaxed );
+			incrementMetric( METRIC_UART_DROPPED_RESPONSES );
+			return -1;
 		}
-		if (uart_is_writable( UART_ID )){
-			uart_putc_raw( UART_ID, IncomingCharacter ); // send echo
+		DescriptorPtr->DataPtr = &UartOutputBuffer[OutputBufferHead & (UART_OUTPUT_BUFFER_SIZE-1)];
+		for (size_t J = 0; J < Length; J++){
+			UartOutputBuffer[(OutputBufferHead + J) & (UART_OUTPUT_BUFFER_SIZE-1)] = DataPtr[J];
 		}
-		atomic_store_explicit( &WhenReceivedLastByte, time_us_64(), memory_order_relaxed ); // to check how long the silence lasts in the incoming transmission
+		OutputBufferHead += Length;
+	}
+	else{
+		DescriptorPtr->DataPtr = DataPtr;
+	}
+	DescriptorPtr->Length = (uint16_t)Length;
+	DescriptorPtr->IsInOutputBuffer = IsCopied;
+	DescriptorPtr->IsAbortable = IsAbortable;
+	DescriptorPtr->Callback = Callback;
+	atomic_store_explicit( &TransmitQueueHead, QueueHead+1, memory_order_release );
+	incrementMetric( METRIC_UART_FRAMES_OUT );
+
+	// If the DMA is idle, its interrupt cannot occur until the transfer is started here
+	// (after an abort, the message waits for releaseTransmitter)
+	if (!atomic_load_explicit( &IsDmaTransmitting, memory_order_acquire ) &&
+			!atomic_load_explicit( &IsTransmitterHeld, memory_order_acquire ))
+	{
+		startNextMessage();
+	}
+	return 0;
+}
 
-		// Check if there is any outgoing transmission
-		if (is_tx_irq_enabled(UART_ID) || !uart_is_writable( UART_ID ) || (!ringSpscIsEmpty( &OutputRingBuffer ))){
-			UartErrorTemporary |= UART_WARNING_INCOMING_WHILE_OUTGOING;
-		}
+static void startNextMessage(void){
+	const TransmitDescriptor *DescriptorPtr =
+			&TransmitQueue[atomic_load_explicit( &TransmitQueueTail, memory_order_relaxed ) & (TRANSMIT_QUEUE_LENGTH-1)];
+	atomic_store_explicit( &IsDmaTransmitting, true, memory_order_release );
+	atomic_store_explicit( &IsResponseTailInFifo, false, memory_order_release );
+	atomic_store_explicit( &IsUnsolicitedTailInFifo, false, memory_order_release );
+	dma_channel_set_config( TxDmaChannel,
+			DescriptorPtr->IsInOutputBuffer? &TxDmaConfigForOutputBuffer : &TxDmaConfigForStaticData, false );
+	dma_channel_set_read_addr( TxDmaChannel, DescriptorPtr->DataPtr, false );
+	dma_channel_set_trans_count( TxDmaChannel, DescriptorPtr->Length, true );
+}
+
+static void transmitDmaInterruptHandler( void ){
+	if (!dma_channel_get_irq0_status( TxDmaChannel )){
+		return;
+	}
+	dma_channel_acknowledge_irq0( TxDmaChannel );
+	completeMessage();
+}
+
+static void completeMessage(void){
+	uint32_t QueueTail = atomic_load_explicit( &TransmitQueueTail, memory_order_relaxed );
+	const TransmitDescriptor *DescriptorPtr = &TransmitQueue[QueueTail & (TRANSMIT_QUEUE_LENGTH-1)];
+	TransmitCallback Callback = DescriptorPtr->Callback;
+	bool IsAbortable = DescriptorPtr->IsAbortable;
+	if (DescriptorPtr->IsInOutputBuffer){
+		atomic_fetch_add_explicit( &OutputBufferTail, DescriptorPtr->Length, memory_order_release );
+	}
+	QueueTail++;
+	atomic_store_explicit( &TransmitQueueTail, QueueTail, memory_order_release );
+	if (NULL != Callback){
+		Callback();
+	}
+
+	if ((QueueTail != atomic_load_explicit( &TransmitQueueHead, memory_order_acquire )) &&
+			!atomic_load_explicit( &IsTransmitterHeld, memory_order_acquire ))
+	{
+		startNextMessage();
 	}
 	else{
-		if((!ringSpscIsEmpty( &OutputRingBuffer )) && uart_is_writable( UART_ID )){
-			uint8_t OutgoingData;
-			ringSpscPop( &OutputRingBuffer, &OutgoingData );
-			uart_putc_raw( UART_ID, OutgoingData );			// uart_putc is not good due to its CRLF support
+		atomic_store_explicit( &IsDmaTransmitting, false, memory_order_release );
+		// the tail of an unsolicited message is not a response; the master may interrupt it (it is aborted as well)
+		atomic_store_explicit( &IsResponseTailInFifo, !IsAbortable, memory_order_release );
+		atomic_store_explicit( &IsUnsolicitedTailInFifo, IsAbortable, memory_order_release );
+	}
+}
+
+static bool abortUnsolicitedMessage(void){
+	bool IsDmaActive = atomic_load_explicit( &IsDmaTransmitting, memory_order_acquire );
+	if (IsDmaActive){
+		const TransmitDescriptor *DescriptorPtr =
+				&TransmitQueue[atomic_load_explicit( &TransmitQueueTail, memory_order_relaxed ) & (TRANSMIT_QUEUE_LENGTH-1)];
+		if (!DescriptorPtr->IsAbortable){
+			return false;
 		}
-		if (ringSpscIsEmpty( &OutputRingBuffer )){
-			uart_set_irq_enables( UART_ID, true, false );	// there is nothing more to send so stop interrupts from the sender
+	}
+	else if (!atomic_load_explicit( &IsUnsolicitedTailInFifo, memory_order_acquire ) ||
+			(0 != (uart_get_hw(UART_ID)->fr & UART_UARTFR_TXFE_BITS)))
+	{
+		return false;	// nothing of an unsolicited message is left to send
+	}
+	// The DMA fills the TX FIFO (32 bytes), so stopping the DMA is not enough: the transmitter is disabled
+	// and finishes the character being sent; the FIFO is flushed when the master has finished (releaseTransmitter)
+	hw_clear_bits( &uart_get_hw(UART_ID)->cr, UART_UARTCR_TXE_BITS );
+	atomic_store_explicit( &IsTransmitterHeld, true, memory_order_release );
+	atomic_store_explicit( &IsUnsolicitedTailInFifo, false, memory_order_release );
+	if (IsDmaActive){
+		// RP2040-E13: the completion interrupt may be raised by the abort, so it is disabled and cleared
+		// (the DMA interrupt has the same priority, so it cannot preempt this handler)
+		dma_channel_set_irq0_enabled( TxDmaChannel, false );
+		dma_channel_abort( TxDmaChannel );
+		dma_channel_acknowledge_irq0( TxDmaChannel );
+		dma_channel_set_irq0_enabled( TxDmaChannel, true );
+		completeMessage();	// the next message is not started while the transmitter is held
+		atomic_store_explicit( &IsUnsolicitedTailInFifo, false, memory_order_release );
+	}
+	return true;
+}
+
+static void releaseTransmitter( uint64_t Now ){
+	if (!atomic_load_explicit( &IsTransmitterHeld, memory_order_acquire ) || uart_is_readable( UART_ID ) ||
+			(Now - atomic_load_explicit( &WhenReceivedLastByte, memory_order_relaxed ) < SilenceDetectionInMicroseconds))
+	{
+		return;		// the master may be sending
+	}
+	// the SDK function disables the UART for the change (the control register, with TXE cleared, is restored)
+	uart_set_fifo_enabled( UART_ID, false );
+	uart_set_fifo_enabled( UART_ID, true );
+	hw_set_bits( &uart_get_hw(UART_ID)->cr, UART_UARTCR_TXE_BITS );
+	atomic_store_explicit( &IsTransmitterHeld, false, memory_order_release );
+	// the DMA is idle: the messages queued meanwhile (e.g. the response) are started here
+	if (atomic_load_explicit( &TransmitQueueHead, memory_order_acquire ) != atomic_load_explicit( &TransmitQueueTail, memory_order_acquire )){
+		startNextMessage();
+	}
+}
+
+static void serialPortInterruptHandler( void ){
+//	changeDebugPin1(true);
+
+	uint16_t UartErrorTemporary = 0;
+
+	if (uart_is_readable(UART_ID)){
+		bool IsBinary = atomic_load_explicit( &IsBinaryMode, memory_order_relaxed );
+		bool IsEchoed = atomic_load_explicit( &IsEchoEnabled, memory_order_relaxed ) && !IsBinary;
+		// Check if there is any outgoing transmission (before the echo is written to the TX FIFO);
+		// an unsolicited message is stopped, since the master may send a command at any time
+		if (!abortUnsolicitedMessage() && isResponseBeingSent()){
+			UartErrorTemporary |= UART_WARNING_INCOMING_WHILE_OUTGOING;
 		}
+		// drain the RX FIFO (this also clears the RX level and receive timeout interrupts)
+		do{
+			char IncomingCharacter = uart_getc(UART_ID);
+			if (IsBinary){
+				assembleBinaryFrame( (uint8_t)IncomingCharacter );
+			}
+			else{
+				assembleTextFrame( IncomingCharacter );
+			}
+			if (IsEchoed && uart_is_writable( UART_ID ) && !atomic_load_explicit( &IsTransmitterHeld, memory_order_relaxed )){
+				uart_putc_raw( UART_ID, IncomingCharacter ); // send echo (if enabled; not in the binary mode; not after an abort)
+			}
+		}while (uart_is_readable(UART_ID));
+		atomic_store_explicit( &WhenReceivedLastByte, time_us_64(), memory_order_relaxed ); // to check how long the silence lasts in the incoming transmission
 	}
+
 	atomic_fetch_or_explicit( &UartError, UartErrorTemporary, memory_order_relaxed );
 
-//	changeDebugPin1(false); // measured duration 1...7 us
+//	changeDebugPin1(false);
 }
 
-static inline bool is_tx_irq_enabled(uart_inst_t *uart) {
-	return (uart_get_hw(uart)->imsc & UART_UARTIMSC_TXIM_BITS) != 0;
+static inline bool isResponseBeingSent(void) {
+	if (atomic_load_explicit( &IsDmaTransmitting, memory_order_acquire )){
+		return true;
+	}
+	if (atomic_load_explicit( &IsResponseTailInFifo, memory_order_acquire )){
+		if (0 == (uart_get_hw(UART_ID)->fr & UART_UARTFR_TXFE_BITS)){
+			return true;
+		}
+		atomic_store_explicit( &IsResponseTailInFifo, false, memory_order_release );	// the echo must not be taken for a response
+	}
+	return false;
 }
 
+static inline void setUartInterrupts(uart_inst_t *uart) {
+	uart_get_hw(uart)->imsc = UART_UARTIMSC_RXIM_BITS | UART_UARTIMSC_RTIM_BITS;
+}
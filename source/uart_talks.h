@@ -6,20 +6,36 @@
 /// and that incoming and outgoing transmission takes place alternately.
 /// If data is received on the UART during an outgoing transmission, the outgoing data transmission
 /// should be stopped immediately (the master should never start sending a new command until the previous command has been completed).
+/// An unsolicited message (telemetry) is stopped by disabling the transmitter, so at most the character being sent
+/// goes out after the master has started; the rest of the message is flushed from the TX FIFO when the master has
+/// finished, before the response is sent. A response is never stopped: if the master sends during a response,
+/// UART_WARNING_INCOMING_WHILE_OUTGOING is set.
 
 #ifndef SOURCE_UART_TALKS_H_
 #define SOURCE_UART_TALKS_H_
 
 #include <stdatomic.h>
 #include "pico/stdlib.h"
+#include "rstl_session.h"	// the frame sizes and the transport operations
 
 //---------------------------------------------------------------------------------------------------
 // Macro directives
 //---------------------------------------------------------------------------------------------------
 
-#define LONGEST_COMMAND_LENGTH				28			// ???
+#define UART_ERROR_INPUT_BUFFER_OVERFLOW		0x01	// a frame has been dropped: the previous one was not interpreted yet
+#define UART_WARNING_INCOMING_WHILE_OUTGOING	0x02	// a byte has been received while a response was being sent
+#define UART_ERROR_TRANSMIT_QUEUE_OVERFLOW		0x04
+#define UART_ERROR_BINARY_FRAME					0x08	// a binary frame is incomplete, too long or its CRC is wrong
 
-#define LONGEST_RESPONSE_LENGTH				60
+//---------------------------------------------------------------------------------------------------
+// Global constants
+//---------------------------------------------------------------------------------------------------
+
+/// Function called (in the DMA interrupt) when a message has been written to the TX FIFO
+typedef void (*TransmitCallback)(void);
+
+/// The operations of the serial port used by the RSTL session (the link pointer is not used)
+extern const SessionTransport UartTransport;
 
 //---------------------------------------------------------------------------------------------------
 // Global variables
@@ -28,6 +44,9 @@
 /// @brief This variable is used in UART interrupt handler
 extern atomic_uint_fast16_t UartError;
 
+/// @brief Number of messages rejected because the transmit queue or the output buffer was full
+extern atomic_uint_fast32_t TransmitOverflows;
+
 //---------------------------------------------------------------------------------------------------
 // Function prototypes
 //---------------------------------------------------------------------------------------------------
@@ -35,18 +54,70 @@ extern atomic_uint_fast16_t UartError;
 /// @brief This function initializes hardware port (UART) and initializes state machines for serial communication
 void serialPortInitialization(void);
 
-/// @brief This function drives the state machine that receives frames via serial port
-/// @return true if a new command has been received via UART
-/// @return false if there is no new command
-bool serialPortReceiver(void);
+/// @brief This function gives the main loop the frame received via serial port
+/// The frames are assembled in place by the UART interrupt handler in a double-buffered line store; the frame
+/// given here stays valid (and unchanged) until the next call, while the next frame is received into the other buffer.
+/// A text frame ends with "\r\n" (unless it has been passed on after a period of silence); a binary frame holds
+/// everything from the sync byte to the CRC. The frame is not terminated by 0.
+/// @param FramePtr the beginning of the frame is stored here
+/// @param LengthPtr the length of the frame is stored here
+/// @return true if a new frame has been received via UART
+/// @return false if there is no new frame
+bool serialPortReceiver( const char **FramePtr, uint16_t *LengthPtr );
+
+/// @brief This function switches between the text (RSTL) mode and the binary mode
+/// In the binary mode the incoming bytes are not echoed and the frames are assembled according to their length.
+void setSerialPortBinaryMode( bool IsBinary );
+
+/// @brief This function returns true if the serial port works in the binary mode
+bool isSerialPortInBinaryMode(void);
+
+/// @brief This function turns the echo of the received bytes on or off (text mode; the echo is on after reset)
+/// An automated master may turn the echo off to save the line time and the interrupt work.
+void setSerialPortEcho( bool IsEnabled );
+
+/// @brief This function returns true if the received bytes are echoed
+bool isSerialPortEchoEnabled(void);
+
+/// @brief This function requests the change of the baud rate
+/// The new rate is set after the response to the present command has been sent. If no proper command
+/// is received at the new rate within a timeout, the old rate is restored.
+/// @return false if the rate is not a standard one (4800 ... 921600) or the previous change is not completed
+bool setSerialPortBaudRate( uint32_t NewBaudRate );
 
-/// @brief This function starts sending the data stored in TextToBeSent
-/// The function writes the first byte to UART (FIFO input buffer of UART),
-/// and copies the next bytes from TextToBeSent to UartOutputBuffer.
-/// See the assumptions specified in the module description.
+/// @brief This function returns the baud rate in use (or the one that is going to be set)
+uint32_t getSerialPortBaudRate(void);
+
+/// @brief This function is called after a proper command has been received; it confirms the new baud rate
+void confirmSerialPortBaudRate(void);
+
+/// @brief This function puts a copy of the text into the transmit queue
+/// The messages are sent one after another by DMA; the text is copied, so the caller may reuse its buffer at once.
 /// @param TextToBeSent pointer to a string (character with code zero cannot be sent)
 /// @return 0 on success
-/// @return -1 on failure
+/// @return -1 on failure (improper argument or the queue is full)
 int8_t transmitViaSerialPort( const char* TextToBeSent );
 
+/// @brief This function puts the text into the transmit queue without copying it
+/// @param TextToBeSent pointer to a string that stays unchanged until it has been sent (e.g. a string literal)
+/// @param Callback function called in the DMA interrupt when the text has been written to the TX FIFO (may be NULL)
+/// @return 0 on success
+/// @return -1 on failure (improper argument or the queue is full)
+int8_t transmitStaticViaSerialPort( const char* TextToBeSent, TransmitCallback Callback );
+
+/// @brief This function puts a copy of the data (e.g. a binary frame) into the transmit queue
+/// @return 0 on success
+/// @return -1 on failure (improper argument or the queue is full)
+int8_t transmitBytesViaSerialPort( const uint8_t *DataPtr, uint16_t Length );
+
+/// @brief This function puts a copy of an unsolicited message (e.g. telemetry) into the transmit queue
+/// The transmission is stopped as soon as a byte is received, so the half-duplex rule holds for the master's commands.
+/// @return 0 on success
+/// @return -1 on failure (improper argument or the queue is full)
+int8_t transmitUnsolicitedViaSerialPort( const char* TextToBeSent );
+
+/// @brief This function returns true if no frame is being received and nothing is being transmitted
+/// An unsolicited message should be sent only when the port is idle.
+bool isSerialPortIdle(void);
+
 #endif // SOURCE_UART_TALKS_H_
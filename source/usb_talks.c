@@ -0,0 +1,65 @@
+/// @file usb_talks.c
+
+#include <assert.h>
+#include "pico/stdlib.h"
+#include "tusb.h"
+
+#include "usb_talks.h"
+#include "metrics.h"
+
+static_assert( LONGEST_BATCH_RESPONSE_LENGTH <= CFG_TUD_CDC_TX_BUFSIZE, "static_assert LONGEST_BATCH_RESPONSE_LENGTH <= CFG_TUD_CDC_TX_BUFSIZE" );
+
+//---------------------------------------------------------------------------------------------------
+// Global variables
+//---------------------------------------------------------------------------------------------------
+
+/// @brief The link of the USB session (used with StreamTransport)
+StreamLink UsbLink;
+
+//---------------------------------------------------------------------------------------------------
+// Local function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function returns the next byte received via USB or -1 if there is none (it does not wait)
+static int readUsbByte( void *ContextPtr );
+
+/// @brief This function puts the data into the transmit FIFO of the CDC driver (it does not wait)
+/// @return -1 if no host is connected or the FIFO has no room for the whole data (the data is dropped)
+static int8_t writeUsbBytes( void *ContextPtr, const uint8_t *DataPtr, uint16_t Length );
+
+static uint64_t readUsbTime( void );
+
+//---------------------------------------------------------------------------------------------------
+// Function definitions
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function initializes the link of the USB session
+void usbPortInitialization(void){
+	initializeStreamLink( &UsbLink, readUsbByte, writeUsbBytes, readUsbTime, NULL, USB_SILENCE_DETECTION_IN_MICROSECONDS );
+}
+
+static int readUsbByte( void *ContextPtr ){
+	(void)ContextPtr;
+	int NewByte = getchar_timeout_us( 0 );
+	return (PICO_ERROR_TIMEOUT == NewByte)? -1 : NewByte;
+}
+
+static int8_t writeUsbBytes( void *ContextPtr, const uint8_t *DataPtr, uint16_t Length ){
+	(void)ContextPtr;
+	if (!tud_cdc_connected()){
+		return -1;
+	}
+	// putchar_raw would wait for room (up to PICO_STDIO_USB_STDOUT_TIMEOUT_US) when the host does not read;
+	// a message is dropped as a whole, so the host never gets a part of it
+	if (tud_cdc_write_available() < Length){
+		incrementMetric( METRIC_USB_DROPPED_MESSAGES );
+		return -1;
+	}
+	tud_cdc_write( DataPtr, Length );
+	tud_cdc_write_flush();
+	return 0;
+}
+
+static uint64_t readUsbTime( void ){
+	return time_us_64();
+}
@@ -0,0 +1,38 @@
+/// @file usb_talks.h
+/// @brief This module implements the link of the second RSTL session via the USB CDC port
+///
+/// The USB port carries the same commands as the serial port (UART0), at the full USB speed, so that maintenance
+/// tools do not disturb the production serial link. The port is served by the stdio driver of the SDK (pico_stdio_usb);
+/// the received bytes are polled in the main loop and the frames are assembled by the stream link (rstl_session.h).
+/// The debug output (DBG command) uses the same port, so it is off unless it is requested.
+/// The responses are put into the transmit FIFO of the TinyUSB CDC driver without waiting: if a host keeps the port
+/// open but does not read, a message that does not fit is dropped and counted (metric "usbd"), so the main loop
+/// (and the serial session) is never stalled by the USB port.
+
+#ifndef SOURCE_USB_TALKS_H_
+#define SOURCE_USB_TALKS_H_
+
+#include "rstl_session.h"
+
+//---------------------------------------------------------------------------------------------------
+// Macro directives
+//---------------------------------------------------------------------------------------------------
+
+/// A text frame without the terminator "\r\n" is passed on after this period of silence
+#define USB_SILENCE_DETECTION_IN_MICROSECONDS	50000
+
+//---------------------------------------------------------------------------------------------------
+// Global variables
+//---------------------------------------------------------------------------------------------------
+
+/// @brief The link of the USB session (used with StreamTransport)
+extern StreamLink UsbLink;
+
+//---------------------------------------------------------------------------------------------------
+// Function prototypes
+//---------------------------------------------------------------------------------------------------
+
+/// @brief This function initializes the link of the USB session (stdio must be initialized before)
+void usbPortInitialization(void);
+
+#endif // SOURCE_USB_TALKS_H_
@@ -1,12 +1,14 @@
 /// @file writing_to_dac.c
 
-#include <stdio.h>
 #include <inttypes.h>
 #include <assert.h>
 #include "i2c_outputs.h"
 #include "writing_to_dac.h"
 #include "psu_talks.h"
+#include "conversions.h"
+#include "trip_monitor.h"
 #include "debugging.h"
+#include "metrics.h"
 
 
 //---------------------------------------------------------------------------------------------------
@@ -186,6 +188,7 @@ void writeToDacStateMachine(void){
 		if (!atomic_load_explicit( &IsMainContactorStateOn, memory_order_acquire ) &&
 				WriteToDacDataReady[WritingToDac_Channel])
 		{
+			atomic_store_explicit( &Sig2PresentReading[WritingToDac_Channel], getLogicFeedbackFromPsu(), memory_order_release );
 			if (0 == WrittenToDacValue[WritingToDac_Channel]){
 				atomic_store_explicit( &Sig2LastReadings[WritingToDac_Channel][SIG2_FOR_0_DAC_SETTING], getLogicFeedbackFromPsu(), memory_order_release );
 			}
@@ -212,6 +215,7 @@ void writeToDacStateMachine(void){
 	case WRITING_TO_DAC_SEND_1ST_BYTE:
 		if (WriteToDacDataReady[WritingToDac_Channel]){
 			IsI2cSuccess = i2cWrite( PCF8574_ADDRESS_2, (uint8_t)WorkingDataForTwoPcf8574 );
+			incrementMetric( METRIC_I2C_TRANSACTIONS );
 			if (IsI2cSuccess){
 				atomic_store_explicit( &I2cConsecutiveErrors, 0, memory_order_release );
 				WritingToDac_State = WRITING_TO_DAC_SEND_2ND_BYTE;
@@ -225,6 +229,7 @@ void writeToDacStateMachine(void){
 			}
 		}
 		else{
+			incrementMetric( METRIC_I2C_SKIPPED_BYTES );
 			WritingToDac_State = WRITING_TO_DAC_SEND_2ND_BYTE;
 		}
 		break;
@@ -232,6 +237,7 @@ void writeToDacStateMachine(void){
 	case WRITING_TO_DAC_SEND_2ND_BYTE:
 		if (WriteToDacDataReady[WritingToDac_Channel]){
 			IsI2cSuccess = i2cWrite( PCF8574_ADDRESS_1, (uint8_t)(WorkingDataForTwoPcf8574 >> 8) );
+			incrementMetric( METRIC_I2C_TRANSACTIONS );
 			if (IsI2cSuccess){
 				atomic_store_explicit( &I2cConsecutiveErrors, 0, memory_order_release );
 				WritingToDac_State = WRITING_TO_DAC_LATCH_DATA;
@@ -245,6 +251,7 @@ void writeToDacStateMachine(void){
 			}
 		}
 		else{
+			incrementMetric( METRIC_I2C_SKIPPED_BYTES );
 			WritingToDac_State = WRITING_TO_DAC_LATCH_DATA;
 		}
 		break;
@@ -254,21 +261,29 @@ void writeToDacStateMachine(void){
 			// writing to ADC (signal /WR)
 			gpio_put( GPIO_FOR_NOT_WR_OUTPUT, false );
 			WrittenToDacValue[WritingToDac_Channel] = InstantaneousSetpointDacValue[WritingToDac_Channel];
+#if ENABLE_TRIP_MONITOR == 1
+			registerDacWrite( WritingToDac_Channel );
+#endif
 
 #if 1
 			changeDebugPin1(true);
 			uint32_t DacAddress = decodeDataSentToPcf8574s( &DebugValueWrittenToDac[0], DebugValueWrittenToPCFs ); // just for debugging
-			printf( "%s\ti2c\t%d\t%d\t%d\t%d\t%d\n",
-					timeTextForDebugging(),
-					WritingToDac_Channel+1,
-					WrittenToDacValue[0]-OFFSET_IN_DAC_UNITS,
-					WrittenToDacValue[1]-OFFSET_IN_DAC_UNITS,
-					WrittenToDacValue[2]-OFFSET_IN_DAC_UNITS,
-					WrittenToDacValue[3]-OFFSET_IN_DAC_UNITS );
+			char DebugLine[DEBUG_LINE_LENGTH];
+			TextBuffer Line;
+			initializeTextBuffer( &Line, DebugLine, sizeof(DebugLine) );
+			appendTimeForDebugging( &Line );
+			appendText( &Line, "\ti2c\t" );
+			appendUnsigned( &Line, (uint32_t)WritingToDac_Channel+1 );
+			for (uint8_t J = 0; J < NUMBER_OF_POWER_SUPPLIES; J++){
+				appendCharacter( &Line, '\t' );
+				appendSigned( &Line, (int32_t)WrittenToDacValue[J]-getDacZeroOffset( J ) );
+			}
+			appendText( &Line, "\n" );
+			printDebugText( DebugLine );
 			if ((WritingToDac_Channel != DacAddress) ||
 					(InstantaneousSetpointDacValue[WritingToDac_Channel] != DebugValueWrittenToDac[DacAddress]))
 			{
-				printf( "\t INCONSISTENCY INCONSISTENCY INCONSISTENCY!!!\n" );
+				printDebugText( "\t INCONSISTENCY INCONSISTENCY INCONSISTENCY!!!\n" );
 			}
 			changeDebugPin1(false);		// measured time = 100...145 us  (2025-12-02); pulse frequency in the case of ramp execution: 11.7Hz
 #endif
@@ -287,11 +302,18 @@ void writeToDacStateMachine(void){
 		}
 
 #if 1
-		printf( "%s\tI2C ERR=%u\t%u\n",
-				timeTextForDebugging(),
-				(unsigned)TemporaryI2cErrors,
-				(unsigned)atomic_load_explicit( &I2cMaxConsecutiveErrors, memory_order_acquire ));
+		char DebugLine[DEBUG_LINE_LENGTH];
+		TextBuffer Line;
+		initializeTextBuffer( &Line, DebugLine, sizeof(DebugLine) );
+		appendTimeForDebugging( &Line );
+		appendText( &Line, "\tI2C ERR=" );
+		appendUnsigned( &Line, TemporaryI2cErrors );
+		appendCharacter( &Line, '\t' );
+		appendUnsigned( &Line, atomic_load_explicit( &I2cMaxConsecutiveErrors, memory_order_acquire ));
+		appendText( &Line, "\n" );
+		printDebugText( DebugLine );
 #endif
+		incrementMetric( METRIC_I2C_RETRIES );	// the write starts again from the first byte
 		WritingToDac_State = WRITING_TO_DAC_SEND_1ST_BYTE;
 		break;
 
@@ -0,0 +1,104 @@
+// Host-side benchmark of the command lookup (source/command_trie.c) compared with a chain of strstr calls.
+// The lookup time is measured for every command of the RSTL table, first with the real command set and then
+// with additional dummy commands, to show that the trie lookup does not depend on the number of commands.
+// Build and run: gcc -O2 -I../source -o benchmark-command-trie benchmark-command-trie.c && ./benchmark-command-trie
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define COMMAND_TRIE_MAX_NODES	256	// room for the dummy commands
+#include "../source/command_trie.c"
+
+#define REPETITIONS		1000000
+#define MAX_COMMANDS	120
+
+static const char *RstlCommands[] = {
+	"PC", "?PC", "Z", "?Z", "POWER", "?POWER", "?ETA", "MC", "BAUD", "?BAUD", "VERSION", "ST", "RE",
+	"CDZ", "CDG", "CAZ", "CAG", "CALZ", "?CALZ", "?CAL", "CSAVE", "TRIPTOL", "TRIPTIME", "?TRIP"
+};
+
+#define RSTL_COMMANDS	(sizeof(RstlCommands)/sizeof(RstlCommands[0]))
+
+static char DummyNames[MAX_COMMANDS][8];
+static const char *Names[MAX_COMMANDS];
+static unsigned NamesNumber;
+
+static double nowInNanoseconds(void){
+	struct timespec Time;
+	clock_gettime( CLOCK_MONOTONIC, &Time );
+	return 1e9 * (double)Time.tv_sec + (double)Time.tv_nsec;
+}
+
+// The dispatcher before the trie: the first name that is a prefix of the text
+static int findByStrstr( const char *Text ){
+	for (unsigned J = 0; J < NamesNumber; J++){
+		if (strstr( Text, Names[J] ) == Text){
+			return (int)J;
+		}
+	}
+	return -1;
+}
+
+static void buildCommandSet( unsigned DummyCommands ){
+	NamesNumber = 0;
+	clearCommandTrie();
+	// the dummy commands are placed first, which is the worst case for the strstr chain
+	for (unsigned J = 0; J < DummyCommands; J++){
+		snprintf( DummyNames[J], sizeof(DummyNames[J]), "X%02uQ", J );
+		Names[NamesNumber] = DummyNames[J];
+		addCommandToTrie( Names[NamesNumber], (uint8_t)NamesNumber );
+		NamesNumber++;
+	}
+	for (unsigned J = 0; J < RSTL_COMMANDS; J++){
+		Names[NamesNumber] = RstlCommands[J];
+		if (!addCommandToTrie( Names[NamesNumber], (uint8_t)NamesNumber )){
+			printf( "cannot add %s\n", Names[NamesNumber] );
+		}
+		NamesNumber++;
+	}
+}
+
+static void measure( unsigned DummyCommands ){
+	char Text[32];
+	double TrieTime = 0.0, StrstrTime = 0.0, WorstTrieTime = 0.0;
+	volatile unsigned Sink = 0;
+
+	buildCommandSet( DummyCommands );
+	for (unsigned J = 0; J < RSTL_COMMANDS; J++){
+		uint16_t TextLength = (uint16_t)snprintf( Text, sizeof(Text), "%s 1\r\n", RstlCommands[J] );
+		uint8_t NameLength;
+		uint8_t Index = findCommandInTrie( Text, TextLength, &NameLength );
+		if ((COMMAND_TRIE_NO_COMMAND == Index) || (0 != strcmp( Names[Index], RstlCommands[J] ))){
+			printf( "wrong result for %s\n", RstlCommands[J] );
+		}
+
+		double Start = nowInNanoseconds();
+		for (unsigned K = 0; K < REPETITIONS; K++){
+			Sink += findCommandInTrie( Text, TextLength, &NameLength );
+		}
+		double Time = (nowInNanoseconds() - Start) / REPETITIONS;
+		TrieTime += Time;
+		if (Time > WorstTrieTime){
+			WorstTrieTime = Time;
+		}
+
+		Start = nowInNanoseconds();
+		for (unsigned K = 0; K < REPETITIONS; K++){
+			Sink += (unsigned)findByStrstr( Text );
+		}
+		StrstrTime += (nowInNanoseconds() - Start) / REPETITIONS;
+	}
+	printf( "%3u commands, %3u nodes: trie mean %6.1f ns, worst %6.1f ns; strstr chain mean %6.1f ns\n",
+			NamesNumber, (unsigned)getCommandTrieSize(),
+			TrieTime / RSTL_COMMANDS, WorstTrieTime, StrstrTime / RSTL_COMMANDS );
+	(void)Sink;
+}
+
+int main(void){
+	measure( 0 );
+	measure( 24 );
+	measure( 48 );
+	measure( 72 );
+	return 0;
+}
@@ -0,0 +1,97 @@
+// Host-side benchmark of the SPSC ring (source/ring_spsc.h): a 60-byte response is passed through the ring
+// byte by byte (ringSpscPush / ringSpscPop), as a block (ringSpscPushBulk / ringSpscPopBulk) and through the spans
+// (memcpy into the write span, memcpy out of the read span, as a DMA transfer would do). The producer and the
+// consumer run alternately in one thread, so the time is the cost of the calls, not of the cache traffic.
+// Build and run: gcc -O2 -I../source -o benchmark-ring-spsc benchmark-ring-spsc.c && ./benchmark-ring-spsc
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../source/ring_spsc.h"
+
+#define REPETITIONS		2000000
+#define MESSAGE_LENGTH	60				// LONGEST_RESPONSE_LENGTH
+#define RING_SIZE		512				// like the UART output buffer
+
+static uint8_t Storage[RING_SIZE];
+
+static ring_spsc_t Ring;
+
+static uint8_t Message[MESSAGE_LENGTH];
+
+static uint8_t Received[MESSAGE_LENGTH];
+
+static volatile uint32_t Sink;
+
+static double nowInNanoseconds(void){
+	struct timespec Time;
+	clock_gettime( CLOCK_MONOTONIC, &Time );
+	return 1e9 * (double)Time.tv_sec + (double)Time.tv_nsec;
+}
+
+static void passByteByByte( void ){
+	for (int J = 0; J < MESSAGE_LENGTH; J++){
+		ringSpscPush( &Ring, Message[J] );
+	}
+	for (int J = 0; J < MESSAGE_LENGTH; J++){
+		ringSpscPop( &Ring, &Received[J] );
+	}
+}
+
+static void passBlock( void ){
+	ringSpscPushBulk( &Ring, Message, MESSAGE_LENGTH );
+	ringSpscPopBulk( &Ring, Received, MESSAGE_LENGTH );
+}
+
+static void passSpans( void ){
+	uint8_t *WriteSpanPtr;
+	size_t Count = ringSpscWriteSpan( &Ring, &WriteSpanPtr );
+	if (Count > MESSAGE_LENGTH){
+		Count = MESSAGE_LENGTH;
+	}
+	memcpy( WriteSpanPtr, Message, Count );
+	ringSpscWriteCommit( &Ring, Count );
+	if (Count < MESSAGE_LENGTH){
+		// the message wraps around the end of the storage
+		ringSpscWriteSpan( &Ring, &WriteSpanPtr );
+		memcpy( WriteSpanPtr, Message + Count, MESSAGE_LENGTH - Count );
+		ringSpscWriteCommit( &Ring, MESSAGE_LENGTH - Count );
+	}
+
+	size_t Done = 0;
+	while (Done < MESSAGE_LENGTH){
+		const uint8_t *ReadSpanPtr;
+		size_t Available = ringSpscReadSpan( &Ring, &ReadSpanPtr );
+		memcpy( Received + Done, ReadSpanPtr, Available );
+		ringSpscReadCommit( &Ring, Available );
+		Done += Available;
+	}
+}
+
+static double measure( const char *Name, void (*pass)( void ) ){
+	ringSpscInit( &Ring, Storage, RING_SIZE );
+	memset( Received, 0, sizeof(Received) );
+	double Start = nowInNanoseconds();
+	for (int J = 0; J < REPETITIONS; J++){
+		Message[0] = (uint8_t)J;
+		pass();
+		Sink += Received[0];
+	}
+	double Time = (nowInNanoseconds() - Start) / REPETITIONS;
+	if (0 != memcmp( Message, Received, MESSAGE_LENGTH )){
+		printf( "%s: wrong data\n", Name );
+	}
+	printf( "%-14s %8.1f ns per message %8.1f MB/s\n", Name, Time, MESSAGE_LENGTH * 1e3 / Time );
+	return Time;
+}
+
+int main(void){
+	for (int J = 0; J < MESSAGE_LENGTH; J++){
+		Message[J] = (uint8_t)('A' + J % 26);
+	}
+	double ByteTime = measure( "byte by byte", passByteByByte );
+	double BlockTime = measure( "block", passBlock );
+	double SpanTime = measure( "spans", passSpans );
+	printf( "speed-up: block %.1fx, spans %.1fx\n", ByteTime / BlockTime, ByteTime / SpanTime );
+	return 0;
+}
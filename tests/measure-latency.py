@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+# Host-side harness: measures the command round-trip time of the RSTL interface
+# (from writing the command to receiving the prompt '>' that ends the response).
+# Usage: ./measure-latency.py [port] [baud] [repetitions] [command]
+# Requires pyserial.
+
+import statistics
+import sys
+import time
+
+import serial
+
+PORT = sys.argv[1] if len(sys.argv) > 1 else "/dev/ttyUSB0"
+BAUD = int(sys.argv[2]) if len(sys.argv) > 2 else 4800
+REPETITIONS = int(sys.argv[3]) if len(sys.argv) > 3 else 100
+COMMAND = (sys.argv[4] if len(sys.argv) > 4 else "?Z") + "\r\n"
+
+def main():
+    port = serial.Serial(PORT, BAUD, timeout=1.0)
+    time.sleep(0.1)
+    port.reset_input_buffer()
+    times = []
+    for _ in range(REPETITIONS):
+        start = time.perf_counter()
+        port.write(COMMAND.encode("ascii"))
+        response = port.read_until(b">")
+        stop = time.perf_counter()
+        if not response.endswith(b">"):
+            print("timeout; received:", response)
+            continue
+        times.append(1000.0 * (stop - start))
+        time.sleep(0.02)
+    port.close()
+    if times:
+        print("%s at %d Bd: n=%d  min=%.2f ms  median=%.2f ms  max=%.2f ms" % (
+            COMMAND.strip(), BAUD, len(times), min(times), statistics.median(times), max(times)))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+# Host-side reference client of the binary RSTL mode (see source/rstl_binary.h) and a throughput benchmark:
+# the state of all the channels is read with text commands (Z n, ?PC, MC, ?ETA for each channel and ST)
+# and with one GET_ALL frame; the number of complete snapshots per second is printed for both ways.
+# Usage: ./rstl-binary-client.py [port] [baud] [repetitions]
+#        ./rstl-binary-client.py --self-test   (checks the CRC and the frame coding without a device)
+# Requires pyserial.
+
+import struct
+import sys
+import time
+
+SYNC = 0xA5
+OP_GET_ALL = 0x01
+OP_SET_CURRENTS = 0x02
+OP_POWER = 0x03
+OP_RESET_ERRORS = 0x04
+OP_LEAVE = 0x7F
+RESPONSE_FLAG = 0x80
+NUMBER_OF_CHANNELS = 4
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+def build_frame(sequence, opcode, payload=b""):
+    content = bytes([len(payload) + 2, sequence & 0xFF, opcode]) + payload
+    return bytes([SYNC]) + content + struct.pack(">H", crc16(content))
+
+def set_currents_payload(currents):
+    """currents: {channel (1..4): micro-amperes}"""
+    mask = 0
+    values = b""
+    for channel in sorted(currents):
+        mask |= 1 << (channel - 1)
+        values += struct.pack("<i", currents[channel])
+    return bytes([mask]) + values
+
+def parse_response(frame):
+    """returns (sequence, opcode, status, data) or raises ValueError"""
+    if len(frame) < 7 or frame[0] != SYNC or frame[1] + 4 != len(frame):
+        raise ValueError("incomplete frame")
+    if crc16(frame[1:-2]) != struct.unpack(">H", frame[-2:])[0]:
+        raise ValueError("wrong CRC")
+    return frame[2], frame[3] & ~RESPONSE_FLAG, frame[4], frame[5:-2]
+
+def parse_get_all(data):
+    state, power, uart_error, i2c_errors, trip = data[:5]
+    channels = [struct.unpack_from("<iiH", data, 5 + 10 * j) for j in range(NUMBER_OF_CHANNELS)]
+    return {"state": state, "power": power, "uart": uart_error, "i2c": i2c_errors, "trip": trip,
+            "channels": [{"setpoint_uA": c[0], "measured_uV": c[1], "eta_ms": c[2]} for c in channels]}
+
+class BinaryClient:
+    def __init__(self, port):
+        self.port = port
+        self.sequence = 0
+
+    def enter(self):
+        self.port.write(b"BIN\r\n")
+        response = self.port.read_until(b">")
+        if not response.endswith(b">"):
+            raise RuntimeError("no response to BIN: %r" % response)
+
+    def request(self, opcode, payload=b"", retries=3):
+        for _ in range(retries):
+            self.sequence = (self.sequence + 1) & 0xFF
+            self.port.write(build_frame(self.sequence, opcode, payload))
+            header = self.port.read(2)
+            if len(header) == 2 and header[0] == SYNC:
+                frame = header + self.port.read(header[1] + 2)
+                try:
+                    sequence, response_opcode, status, data = parse_response(frame)
+                except ValueError:
+                    continue
+                if sequence == self.sequence and response_opcode == opcode:
+                    return status, data
+            self.port.reset_input_buffer()
+        raise RuntimeError("no valid response to opcode 0x%02X" % opcode)
+
+    def leave(self):
+        return self.request(OP_LEAVE)
+
+def self_test():
+    assert crc16(b"123456789") == 0x29B1     # the check value of CRC-16/CCITT-FALSE
+    frame = build_frame(7, OP_SET_CURRENTS, set_currents_payload({1: 1250000, 3: -500000}))
+    assert frame[0] == SYNC and frame[1] == 2 + 1 + 8 and frame[4] == 0b101
+    response = bytes([SYNC, 3, 7, OP_SET_CURRENTS | RESPONSE_FLAG, 0])
+    response += struct.pack(">H", crc16(response[1:]))
+    assert parse_response(response) == (7, OP_SET_CURRENTS, 0, b"")
+    print("self-test passed")
+
+def text_command(port, command):
+    port.write(command.encode("ascii") + b"\r\n")
+    response = port.read_until(b">")
+    if not response.endswith(b">"):
+        raise RuntimeError("timeout: %s" % command)
+    return response
+
+def main():
+    if len(sys.argv) > 1 and sys.argv[1] == "--self-test":
+        self_test()
+        return
+    import serial
+    port_name = sys.argv[1] if len(sys.argv) > 1 else "/dev/ttyUSB0"
+    baud = int(sys.argv[2]) if len(sys.argv) > 2 else 4800
+    repetitions = int(sys.argv[3]) if len(sys.argv) > 3 else 20
+    port = serial.Serial(port_name, baud, timeout=1.0)
+    time.sleep(0.1)
+    port.reset_input_buffer()
+
+    start = time.perf_counter()
+    for _ in range(repetitions):
+        for channel in range(1, NUMBER_OF_CHANNELS + 1):
+            for command in ("Z %d" % channel, "?PC", "MC", "?ETA"):
+                text_command(port, command)
+        text_command(port, "ST")
+    text_time = time.perf_counter() - start
+
+    client = BinaryClient(port)
+    client.enter()
+    start = time.perf_counter()
+    for _ in range(repetitions):
+        status, data = client.request(OP_GET_ALL)
+    binary_time = time.perf_counter() - start
+    print(parse_get_all(data) if status == 0 else "GET_ALL status %d" % status)
+    client.leave()
+    port.close()
+
+    print("all channels at %d Bd: text %.1f snapshots/s, binary %.1f snapshots/s" % (
+        baud, repetitions / text_time, repetitions / binary_time))
+
+if __name__ == "__main__":
+    main()
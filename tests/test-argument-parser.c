@@ -0,0 +1,300 @@
+// Host-side test of the decimal argument parser (source/argument_parser.c).
+// The single-pass parser is compared with the previous implementation (validation followed by a separate
+// conversion) over all the texts built from the classes of characters, and over random texts; then the speed of
+// both of them and of the original version based on atof is measured. Integer arguments (including values far out of
+// the range of the commands) are checked against their exact values.
+// Build and run: gcc -O2 -I../source -o test-argument-parser test-argument-parser.c && ./test-argument-parser
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "../source/argument_parser.c"
+
+#define MAX_TEXT_LENGTH		10		// longer than DECIMAL_ARGUMENT_MAX_LENGTH, so the length error is tested too
+#define RANDOM_TEXTS		20000000
+#define REPETITIONS			2000000
+
+static const char CharacterClasses[] = { ' ', '+', '-', '.', '0', 'x' };	// '0' stands for any digit
+
+#define CHARACTER_CLASSES	(sizeof(CharacterClasses)/sizeof(CharacterClasses[0]))
+
+static const char RandomCharacters[] = " +-.0123456789";
+
+static unsigned long Failures;
+
+static uint32_t RandomState = 12345;
+
+// The previous implementation, copied without changes (except for the names and the saturation of the integer part,
+// which overflowed int32_t in the original code)
+
+static int32_t referenceConvertToMicroUnits( const char *TextPtr, char EndMark );
+
+static int32_t referenceParseArgument( int32_t *Result, char *TextPtr, char EndMark ){
+	uint8_t CharacterIndex = 0;
+	uint8_t Spaces = 0;
+	uint8_t Pluses = 0;
+	uint8_t Minuses = 0;
+	uint8_t Points = 0;
+	uint8_t DecimalDigits = 0;
+
+	while( CharacterIndex < DECIMAL_ARGUMENT_MAX_LENGTH ){
+		if (EndMark == TextPtr[CharacterIndex]){
+			if (0 == DecimalDigits){
+				// no digit
+				return -12;
+			}
+			*Result = referenceConvertToMicroUnits( &TextPtr[Spaces], EndMark );
+			return CharacterIndex;
+		}
+		else if (' ' == TextPtr[CharacterIndex]){
+			Spaces++;
+			if (Spaces > 1){
+				// too many spaces
+				return -11;
+			}
+			if ((Pluses != 0) || (Minuses != 0) || (DecimalDigits != 0)){
+				// improper position of space
+				return -10;
+			}
+		}
+		else if ('+' == TextPtr[CharacterIndex]){
+			Pluses++;
+			if (Pluses > 1){
+				// too many pluses
+				return -9;
+			}
+			if ((Minuses != 0) || (DecimalDigits != 0)){
+				// improper position of plus
+				return -8;
+			}
+		}
+		else if ('-' == TextPtr[CharacterIndex]){
+			Minuses++;
+			if (Minuses > 1){
+				// too many minuses
+				return -7;
+			}
+			if ((Pluses != 0) || (DecimalDigits != 0)){
+				// improper position of minus
+				return -6;
+			}
+		}
+		else if ('.' == TextPtr[CharacterIndex]){
+			Points++;
+			if (Points > 1){
+				// too many points
+				return -5;
+			}
+			if (0 == DecimalDigits){
+				// improper position of point
+				return -4;
+			}
+		}
+		else if (('0' <= TextPtr[CharacterIndex]) && ('9' >= TextPtr[CharacterIndex])){
+			DecimalDigits++;
+			if (DecimalDigits > DECIMAL_ARGUMENT_DIGITS_LIMIT){
+				// too many digits
+				return -3;
+			}
+		}
+		else{
+			// improper character
+			return -2;
+		}
+		CharacterIndex++;
+	}
+	// improper length
+	return -1;
+}
+
+static int32_t referenceConvertToMicroUnits( const char *TextPtr, char EndMark ){
+	bool IsNegative = false;
+	int32_t IntegerPart = 0;
+	int32_t FractionalPart = 0;
+	int32_t FractionalWeight = MICRO_UNITS_IN_ONE;
+	bool IsFractionalPart = false;
+
+	for (uint8_t J = 0; EndMark != TextPtr[J]; J++){
+		char Character = TextPtr[J];
+		if ('-' == Character){
+			IsNegative = true;
+		}
+		else if ('.' == Character){
+			IsFractionalPart = true;
+		}
+		else if (('0' <= Character) && ('9' >= Character)){
+			if (IsFractionalPart){
+				FractionalWeight /= 10;
+				FractionalPart += (Character - '0') * FractionalWeight;
+			}
+			else{
+				IntegerPart = 10 * IntegerPart + (Character - '0');
+				if (IntegerPart > DECIMAL_ARGUMENT_INTEGER_SATURATION){
+					IntegerPart = DECIMAL_ARGUMENT_INTEGER_SATURATION;
+				}
+			}
+		}
+	}
+	int32_t MicroUnits = IntegerPart * MICRO_UNITS_IN_ONE + FractionalPart;
+	return IsNegative? -MicroUnits : MicroUnits;
+}
+
+// The original implementation: the same validation followed by atof
+static int32_t atofParseArgument( float *Result, char *TextPtr, char EndMark ){
+	int32_t Dummy;
+	int32_t ParsingResult = referenceParseArgument( &Dummy, TextPtr, EndMark );
+	if (ParsingResult >= 0){
+		*Result = atof( TextPtr );
+	}
+	return ParsingResult;
+}
+
+static uint32_t nextRandom(void){
+	RandomState = RandomState * 1103515245u + 12345u;
+	return RandomState >> 8;
+}
+
+static double nowInNanoseconds(void){
+	struct timespec Time;
+	clock_gettime( CLOCK_MONOTONIC, &Time );
+	return 1e9 * (double)Time.tv_sec + (double)Time.tv_nsec;
+}
+
+static void compare( char *Text ){
+	int32_t Expected = 0x55555555, Actual = 0x55555555;
+	int32_t ExpectedResult = referenceParseArgument( &Expected, Text, '\r' );
+	// the argument ends at EndPtr; a digit is put there, so a parser that reads past the end gives another result
+	char *EndPtr = strchr( Text, '\r' );
+	*EndPtr = '7';
+	int32_t ActualResult = parseDecimalArgument( &Actual, Text, EndPtr );
+	*EndPtr = '\r';
+	if ((ExpectedResult != ActualResult) || (Expected != Actual)){
+		if (Failures < 20){
+			printf( "\"" );
+			for (int J = 0; '\r' != Text[J]; J++){
+				printf( "%c", Text[J] );
+			}
+			printf( "\": expected %d %d, actual %d %d\n", ExpectedResult, Expected, ActualResult, Actual );
+		}
+		Failures++;
+	}
+}
+
+// All the texts of a given length built from the classes of characters (digits are chosen at random)
+static unsigned long testAllTexts( uint8_t Length ){
+	uint8_t Classes[MAX_TEXT_LENGTH] = { 0 };
+	char Text[MAX_TEXT_LENGTH+2];
+	unsigned long Texts = 0;
+
+	while (true){
+		for (uint8_t J = 0; J < Length; J++){
+			Text[J] = CharacterClasses[Classes[J]];
+			if ('0' == Text[J]){
+				Text[J] = (char)('0' + nextRandom() % 10);
+			}
+		}
+		Text[Length] = '\r';
+		Text[Length+1] = 0;
+		compare( Text );
+		Texts++;
+
+		uint8_t J = 0;
+		while ((J < Length) && (++Classes[J] == CHARACTER_CLASSES)){
+			Classes[J] = 0;
+			J++;
+		}
+		if (J == Length){
+			return Texts;
+		}
+	}
+}
+
+static void testRandomTexts(void){
+	char Text[MAX_TEXT_LENGTH+2];
+	for (unsigned long K = 0; K < RANDOM_TEXTS; K++){
+		uint8_t Length = (uint8_t)(nextRandom() % (DECIMAL_ARGUMENT_MAX_LENGTH+1));
+		for (uint8_t J = 0; J < Length; J++){
+			Text[J] = RandomCharacters[nextRandom() % (sizeof(RandomCharacters)-1)];
+		}
+		Text[Length] = '\r';
+		Text[Length+1] = 0;
+		compare( Text );
+	}
+}
+
+// Integer arguments are checked against their values computed in 64 bits (independently of the reference);
+// a value above the range of the commands must stay above it, i.e. it must not wrap around
+static void testIntegers(void){
+	static const char *OutOfRange[] = { " 11", " 2148", " 4295", " 99999", "-4295", " 999999" };
+	char Text[MAX_TEXT_LENGTH+2];
+	for (uint8_t J = 0; J < sizeof(OutOfRange)/sizeof(OutOfRange[0]); J++){
+		int32_t Value = 0;
+		int32_t Length = parseDecimalArgument( &Value, OutOfRange[J], OutOfRange[J] + strlen( OutOfRange[J] ));
+		if ((Length < 0) || (Value > -10*MICRO_UNITS_IN_ONE && Value < 10*MICRO_UNITS_IN_ONE)){
+			printf( "\"%s\" parsed as %d (%d), expected a value out of range\n", OutOfRange[J], Value, Length );
+			Failures++;
+		}
+	}
+	for (int32_t Integer = -999999; Integer <= 999999; Integer++){
+		int Length = snprintf( Text, sizeof(Text), "%d", Integer );
+		int64_t Expected = (int64_t)Integer * MICRO_UNITS_IN_ONE;
+		int64_t Saturation = (int64_t)DECIMAL_ARGUMENT_INTEGER_SATURATION * MICRO_UNITS_IN_ONE;
+		Expected = (Expected > Saturation)? Saturation : ((Expected < -Saturation)? -Saturation : Expected);
+		int32_t Value = 0;
+		if ((parseDecimalArgument( &Value, Text, Text + Length ) != Length) || (Value != Expected)){
+			if (Failures < 20){
+				printf( "\"%s\" parsed as %d, expected %lld\n", Text, Value, (long long)Expected );
+			}
+			Failures++;
+		}
+	}
+}
+
+static void measure( char *Text ){
+	volatile int32_t Sink = 0;
+	int32_t Value;
+	float FloatValue;
+	const char *EndPtr = strchr( Text, '\r' );
+
+	double Start = nowInNanoseconds();
+	for (unsigned K = 0; K < REPETITIONS; K++){
+		Sink += atofParseArgument( &FloatValue, Text, '\r' );
+	}
+	double AtofTime = (nowInNanoseconds() - Start) / REPETITIONS;
+
+	Start = nowInNanoseconds();
+	for (unsigned K = 0; K < REPETITIONS; K++){
+		Sink += referenceParseArgument( &Value, Text, '\r' );
+	}
+	double TwoPassTime = (nowInNanoseconds() - Start) / REPETITIONS;
+
+	Start = nowInNanoseconds();
+	for (unsigned K = 0; K < REPETITIONS; K++){
+		Sink += parseDecimalArgument( &Value, Text, EndPtr );
+	}
+	double SinglePassTime = (nowInNanoseconds() - Start) / REPETITIONS;
+
+	Text[strcspn( Text, "\r" )] = 0;
+	printf( "%-10s atof %6.1f ns, two passes %6.1f ns, single pass %6.1f ns\n",
+			Text, AtofTime, TwoPassTime, SinglePassTime );
+	(void)Sink;
+}
+
+int main(void){
+	unsigned long Texts = 0;
+	for (uint8_t Length = 0; Length <= MAX_TEXT_LENGTH; Length++){
+		Texts += testAllTexts( Length );
+	}
+	testRandomTexts();
+	testIntegers();
+	printf( "%lu + %u texts, %lu failures\n", Texts, RANDOM_TEXTS, Failures );
+
+	char Texts1[] = " 1\r", Texts2[] = " -9.12345\r", Texts3[] = "+0.5\r", Texts4[] = " 1.2.3\r";
+	measure( Texts1 );
+	measure( Texts2 );
+	measure( Texts3 );
+	measure( Texts4 );
+	return (0 == Failures)? 0 : 1;
+}
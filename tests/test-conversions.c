@@ -0,0 +1,165 @@
+// Host-side test of the fixed-point conversions (source/conversions.c) with the nominal calibration.
+// Every 12-bit DAC code must survive the DAC -> uA -> DAC round trip unchanged. Then every PC argument with five
+// decimal places (-9.99999 ... 9.99999, the longest arguments accepted) is converted to text, parsed
+// (source/argument_parser.c) and converted to a DAC value; the result must be equal to round(x * 204.8) + 2048
+// (clamped), computed in double precision. Arguments with up to 4 digits in the integer part must be out of the range
+// of the setpoints (they are rejected by the PC command).
+// The previous code parsed the argument to a float with atof, so it is compared as well (the differences are
+// only reported: the float cannot represent every argument). At the end the time of a conversion with floats
+// and with the fixed-point functions is measured.
+// Build and run: gcc -O2 -I../source -o test-conversions test-conversions.c -lm && ./test-conversions
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../source/conversions.c"
+#include "../source/argument_parser.c"
+
+/// The arguments are multiples of 10 uA (five decimal places)
+#define ARGUMENT_STEP_IN_MICROAMPERES	10
+#define ARGUMENT_LIMIT_IN_MICROAMPERES	9999990
+#define REPETITIONS						20000000
+
+static unsigned long Failures;
+
+static volatile int32_t Sink;
+
+static double nowInNanoseconds(void){
+	struct timespec Time;
+	clock_gettime( CLOCK_MONOTONIC, &Time );
+	return 1e9 * (double)Time.tv_sec + (double)Time.tv_nsec;
+}
+
+static int32_t clampDacValue( double Value ){
+	int32_t DacValue = (int32_t)Value + OFFSET_IN_DAC_UNITS;
+	if (DacValue < 0){
+		return 0;
+	}
+	return (DacValue > FULL_SCALE_IN_DAC_UNITS)? FULL_SCALE_IN_DAC_UNITS : DacValue;
+}
+
+static void testRoundTrip(void){
+	for (uint16_t DacValue = 0; DacValue <= FULL_SCALE_IN_DAC_UNITS; DacValue++){
+		int32_t MicroAmperes = convertDacValueToMicroAmperes( 0, DacValue );
+		uint16_t Result = convertMicroAmperesToDacValue( 0, MicroAmperes );
+		if (Result != DacValue){
+			printf( "round trip failed: %u -> %d uA -> %u\n", DacValue, MicroAmperes, Result );
+			Failures++;
+		}
+		// the old formula: (setpoint - 2048) * 20/4096 A
+		double Reference = ((double)DacValue - OFFSET_IN_DAC_UNITS) * (20.0 / 4096.0) * 1e6;
+		if (fabs( Reference - MicroAmperes ) > 0.5){
+			printf( "DAC %u: %d uA instead of %.3f uA\n", DacValue, MicroAmperes, Reference );
+			Failures++;
+		}
+	}
+}
+
+static void testArguments(void){
+	char Text[16];
+	unsigned long FloatDifferences = 0;
+	for (int32_t Argument = -ARGUMENT_LIMIT_IN_MICROAMPERES; Argument <= ARGUMENT_LIMIT_IN_MICROAMPERES;
+			Argument += ARGUMENT_STEP_IN_MICROAMPERES){
+		int32_t TensOfMicroAmperes = Argument / ARGUMENT_STEP_IN_MICROAMPERES;
+		snprintf( Text, sizeof(Text), "%s%d.%05d\r", (TensOfMicroAmperes < 0)? "-" : "", abs( TensOfMicroAmperes ) / 100000,
+				abs( TensOfMicroAmperes ) % 100000 );
+		int32_t MicroAmperes = 0;
+		int32_t Length = parseDecimalArgument( &MicroAmperes, Text, strchr( Text, '\r' ));
+		if ((Length < 0) || (MicroAmperes != Argument)){
+			printf( "\"%s\" parsed as %d uA (%d)\n", Text, MicroAmperes, Length );
+			Failures++;
+			continue;
+		}
+		uint16_t DacValue = convertMicroAmperesToDacValue( 0, MicroAmperes );
+		int32_t Reference = clampDacValue( round( (double)Argument / 1e6 * 204.8 ));
+		if (DacValue != Reference){
+			printf( "\"%s\": DAC value %u instead of %d\n", Text, DacValue, Reference );
+			Failures++;
+		}
+		float FloatArgument = (float)atof( Text );
+		if (DacValue != clampDacValue( round( FloatArgument * (4096.0 / 20.0) ))){
+			FloatDifferences++;
+		}
+	}
+	printf( "%d arguments checked, %lu differ from the float (atof) path\n",
+			2 * ARGUMENT_LIMIT_IN_MICROAMPERES / ARGUMENT_STEP_IN_MICROAMPERES + 1, FloatDifferences );
+}
+
+// Arguments with a large integer part (up to 4 digits) must stay out of the range of the setpoints,
+// so that the PC command rejects them; the integer part must not wrap around in the conversion to micro-units
+static void testLargeArguments(void){
+	static const char *Arguments[] = { "10.0001", "11", "2148", "4295", "-4295", "9999.9", "-9999" };
+	for (uint8_t J = 0; J < sizeof(Arguments)/sizeof(Arguments[0]); J++){
+		int32_t MicroAmperes = 0;
+		int32_t Length = parseDecimalArgument( &MicroAmperes, Arguments[J], Arguments[J] + strlen( Arguments[J] ));
+		bool IsNegative = ('-' == Arguments[J][0]);
+		if ((Length < 0) || (IsNegative? (MicroAmperes >= -SETPOINT_LIMIT_IN_MICROAMPERES) :
+				(MicroAmperes <= SETPOINT_LIMIT_IN_MICROAMPERES)))
+		{
+			printf( "\"%s\" parsed as %d uA (%d), expected a value out of range\n", Arguments[J], MicroAmperes, Length );
+			Failures++;
+		}
+	}
+}
+
+static void measureTime(void){
+	// the arguments are taken from a table, so that the compiler cannot fold the conversions
+	static int32_t MicroAmperes[4096];
+	static float Amperes[4096];
+	for (uint16_t J = 0; J < 4096; J++){
+		MicroAmperes[J] = (int32_t)(J * 4883) - ARGUMENT_LIMIT_IN_MICROAMPERES;
+		Amperes[J] = (float)MicroAmperes[J] / 1e6f;
+	}
+
+	double Start = nowInNanoseconds();
+	for (uint32_t J = 0; J < REPETITIONS; J++){
+		int32_t Value = (int32_t)roundf( Amperes[J & 4095] * (4096.0f / 20.0f) ) + OFFSET_IN_DAC_UNITS;
+		Sink = (Value < 0)? 0 : ((Value > FULL_SCALE_IN_DAC_UNITS)? FULL_SCALE_IN_DAC_UNITS : Value);
+	}
+	double FloatTime = (nowInNanoseconds() - Start) / REPETITIONS;
+
+	Start = nowInNanoseconds();
+	for (uint32_t J = 0; J < REPETITIONS; J++){
+		Sink = convertMicroAmperesToDacValue( 0, MicroAmperes[J & 4095] );
+	}
+	double FixedPointTime = (nowInNanoseconds() - Start) / REPETITIONS;
+
+	Start = nowInNanoseconds();
+	for (uint32_t J = 0; J < REPETITIONS; J++){
+		float Value = (float)((int32_t)(J & 4095) - OFFSET_IN_DAC_UNITS) * (20.0f / 4096.0f);
+		Sink = (int32_t)roundf( Value * 1e6f );
+	}
+	double FloatInverseTime = (nowInNanoseconds() - Start) / REPETITIONS;
+
+	Start = nowInNanoseconds();
+	for (uint32_t J = 0; J < REPETITIONS; J++){
+		Sink = convertDacValueToMicroAmperes( 0, (uint16_t)(J & 4095) );
+	}
+	double FixedPointInverseTime = (nowInNanoseconds() - Start) / REPETITIONS;
+
+	// on the host both are fast (the FPU does the work); the RP2040 has no FPU, so the float path calls
+	// the software floating-point routines there
+	printf( "A -> DAC: float %.2f ns, fixed-point %.2f ns\n", FloatTime, FixedPointTime );
+	printf( "DAC -> A: float %.2f ns, fixed-point %.2f ns\n", FloatInverseTime, FixedPointInverseTime );
+}
+
+int main(void){
+	const ChannelCalibration Nominal = {
+		.DacZeroOffset = OFFSET_IN_DAC_UNITS,
+		.DacGain = CALIBRATION_NOMINAL_GAIN,
+		.AdcOffset = 0,
+		.AdcGain = CALIBRATION_NOMINAL_GAIN,
+	};
+	updateConversionFactors( 0, &Nominal );
+
+	testRoundTrip();
+	testArguments();
+	testLargeArguments();
+	measureTime();
+
+	printf( "%lu failures\n", Failures );
+	return (0 == Failures)? 0 : 1;
+}
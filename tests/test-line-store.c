@@ -0,0 +1,93 @@
+// Host-side test of the double-buffered line store (source/line_store.h).
+// A filler thread (the UART interrupt) assembles numbered lines of various lengths byte by byte; the reader (the main
+// loop) takes them in place, checks their contents and releases them. Each line must be either received intact or
+// counted as dropped, and the lines must come in order.
+// Build and run: gcc -O2 -pthread -I../source -o test-line-store test-line-store.c && ./test-line-store
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "../source/line_store.h"
+
+#define NUMBER_OF_LINES		2000000u
+#define LINE_BUFFER_SIZE	126
+
+static char Buffers[2][LINE_BUFFER_SIZE];
+
+static line_store_t Store;
+
+static atomic_bool IsFinished;
+
+static unsigned long Failures;
+
+// The line number N: "N:" followed by N%90 letters and "\r\n"
+static uint16_t formatLine( char *Text, uint32_t Number ){
+	int Length = sprintf( Text, "%lu:", (unsigned long)Number );
+	for (uint32_t J = 0; J < Number % 90; J++){
+		Text[Length++] = (char)('a' + (Number + J) % 26);
+	}
+	Text[Length++] = '\r';
+	Text[Length++] = '\n';
+	return (uint16_t)Length;
+}
+
+static void *fill( void *Argument ){
+	(void)Argument;
+	char Text[LINE_BUFFER_SIZE];
+	for (uint32_t Number = 1; Number <= NUMBER_OF_LINES; Number++){
+		uint16_t Length = formatLine( Text, Number );
+		for (uint16_t J = 0; J < Length; J++){
+			lineStoreAppend( &Store, Text[J] );
+		}
+		lineStoreComplete( &Store );
+		if (0 != Number % 4){
+			sched_yield();	// the host may have a single processor; every 4th line comes at once (it may be dropped)
+		}
+	}
+	atomic_store_explicit( &IsFinished, true, memory_order_release );
+	return NULL;
+}
+
+int main(void){
+	lineStoreInit( &Store, Buffers[0], Buffers[1], LINE_BUFFER_SIZE );
+	pthread_t Filler;
+	pthread_create( &Filler, NULL, fill, NULL );
+
+	unsigned long Received = 0;
+	uint32_t LastNumber = 0;
+	char Expected[LINE_BUFFER_SIZE];
+	for (;;){
+		bool IsFinishedBefore = atomic_load_explicit( &IsFinished, memory_order_acquire );
+		const char *Text;
+		uint16_t Length;
+		if (!lineStoreTake( &Store, &Text, &Length )){
+			if (IsFinishedBefore){
+				break;
+			}
+			sched_yield();
+			continue;
+		}
+		uint32_t Number = (uint32_t)strtoul( Text, NULL, 10 );
+		uint16_t ExpectedLength = formatLine( Expected, Number );
+		if ((Number <= LastNumber) || (Length != ExpectedLength) || (0 != memcmp( Text, Expected, Length ))){
+			if (Failures < 10){
+				printf( "wrong line %lu after %lu (length %u)\n", (unsigned long)Number, (unsigned long)LastNumber, Length );
+			}
+			Failures++;
+		}
+		LastNumber = Number;
+		Received++;
+		lineStoreRelease( &Store );
+	}
+	pthread_join( Filler, NULL );
+
+	unsigned long Dropped = lineStoreDropped( &Store );
+	if (Received + Dropped != NUMBER_OF_LINES){
+		printf( "%lu lines lost\n", NUMBER_OF_LINES - Received - Dropped );
+		Failures++;
+	}
+	printf( "%u lines: %lu received, %lu dropped, %lu failures\n", NUMBER_OF_LINES, Received, Dropped, Failures );
+	return (0 == Failures)? 0 : 1;
+}
@@ -0,0 +1,148 @@
+// Host-side test of the metrics registry (source/metrics.c).
+// The layout generated from METRICS_TABLE is checked first, then the counters, the gauges, the reset (also when a
+// counter wraps around) and the buckets of the latency histograms. At the end a writer thread (an interrupt handler)
+// increments a counter while the reader (the main loop) resets and reads it: no increment may be lost or counted
+// twice, so every value read must lie within the bounds given by the numbers of increments published by the writer.
+// Build and run: gcc -O2 -pthread -I../source -o test-metrics test-metrics.c && ./test-metrics
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "../source/metrics.c"
+
+#define NUMBER_OF_INCREMENTS	20000000u
+
+static unsigned long Failures;
+
+static atomic_uint_least32_t Increments;
+
+static void check( bool Condition, const char *Description ){
+	if (!Condition){
+		printf( "failed: %s\n", Description );
+		Failures++;
+	}
+}
+
+static void testLayout( void ){
+	uint16_t NextIndex = 0;
+	for (uint8_t J = 0; J < NumberOfMetrics; J++){
+		check( MetricTable[J].Index == NextIndex, "the metrics follow one another" );
+		check( MetricTable[J].Length > 0, "a metric has at least one value" );
+		NextIndex += MetricTable[J].Length;
+		for (uint8_t K = 0; K < J; K++){
+			check( 0 != strcmp( MetricTable[J].Name, MetricTable[K].Name ), "the names are unique" );
+		}
+	}
+	check( METRICS_NUMBER_OF_VALUES == NextIndex, "all the values belong to the metrics" );
+	check( METRIC_RAMP_STEPS_LAST - METRIC_RAMP_STEPS + 1 == NUMBER_OF_POWER_SUPPLIES, "a ramp counter per channel" );
+}
+
+static void testCountersAndGauges( void ){
+	initializeMetrics();
+	incrementMetric( METRIC_I2C_TRANSACTIONS );
+	incrementMetric( METRIC_I2C_TRANSACTIONS );
+	addToMetric( METRIC_UART_FRAMES_IN, 7 );
+	incrementMetric( METRIC_RAMP_STEPS + 2 );
+	setMetric( METRIC_UART_BAUD_RATE, 115200 );
+	check( 2 == getMetric( METRIC_I2C_TRANSACTIONS ), "increment" );
+	check( 7 == getMetric( METRIC_UART_FRAMES_IN ), "add" );
+	check( (0 == getMetric( METRIC_RAMP_STEPS + 1 )) && (1 == getMetric( METRIC_RAMP_STEPS + 2 )), "array element" );
+	check( 115200 == getMetric( METRIC_UART_BAUD_RATE ), "gauge" );
+
+	resetMetrics();
+	check( 0 == getMetric( METRIC_I2C_TRANSACTIONS ), "counter after reset" );
+	check( 0 == getMetric( METRIC_RAMP_STEPS + 2 ), "array element after reset" );
+	check( 115200 == getMetric( METRIC_UART_BAUD_RATE ), "gauge kept by reset" );
+	incrementMetric( METRIC_I2C_TRANSACTIONS );
+	check( 1 == getMetric( METRIC_I2C_TRANSACTIONS ), "counter counts from the reset" );
+
+	// the counter wraps around after the reset
+	addToMetric( METRIC_UART_FRAMES_OUT, UINT32_MAX - 1 );
+	resetMetrics();
+	for (int J = 0; J < 5; J++){
+		incrementMetric( METRIC_UART_FRAMES_OUT );
+	}
+	check( 5 == getMetric( METRIC_UART_FRAMES_OUT ), "counter wrapping around" );
+}
+
+static void testLatencyHistogram( void ){
+	static const struct {
+		uint32_t Duration;
+		uint8_t Bucket;
+	} Cases[] = { { 0, 0 }, { 20, 0 }, { 21, 1 }, { 50, 1 }, { 51, 2 }, { 100, 2 }, { 101, 3 }, { 500, 3 },
+			{ 501, 4 }, { 2000, 4 }, { 2001, 5 }, { 1000000, 5 } };
+	initializeMetrics();
+	for (uint8_t J = 0; J < sizeof(Cases)/sizeof(Cases[0]); J++){
+		uint8_t Command = (uint8_t)(J % 3);
+		uint16_t Index = METRIC_COMMAND_LATENCY + Command*METRICS_LATENCY_BUCKETS + Cases[J].Bucket;
+		uint32_t Before = getMetric( Index );
+		recordCommand( Command, Cases[J].Duration );
+		if (getMetric( Index ) != Before + 1){
+			printf( "failed: %lu us not in bucket %u\n", (unsigned long)Cases[J].Duration, Cases[J].Bucket );
+			Failures++;
+		}
+	}
+	check( 4 == getMetric( METRIC_COMMANDS + 0 ), "command counter" );
+	check( 0 == getMetric( METRIC_COMMANDS + 3 ), "command not executed" );
+	recordCommand( METRICS_COMMAND_TYPES - 1, 10 );
+	check( 1 == getMetric( METRIC_COMMAND_LATENCY_LAST - (METRICS_LATENCY_BUCKETS - 1) ), "the last histogram" );
+}
+
+static void *incrementCounter( void *Argument ){
+	(void)Argument;
+	for (uint32_t J = 1; J <= NUMBER_OF_INCREMENTS; J++){
+		incrementMetric( METRIC_UART_FRAMES_IN );
+		atomic_store_explicit( &Increments, J, memory_order_release );
+		if (0 == J % 4096){
+			sched_yield();	// the host may have a single processor
+		}
+	}
+	return NULL;
+}
+
+static void testConcurrentReset( void ){
+	initializeMetrics();
+	atomic_store( &Increments, 0 );
+	pthread_t Writer;
+	pthread_create( &Writer, NULL, incrementCounter, NULL );
+
+	unsigned long Resets = 0, Readings = 0;
+	uint32_t EarliestReset = 0, LatestReset = 0;
+	while (atomic_load_explicit( &Increments, memory_order_acquire ) < NUMBER_OF_INCREMENTS){
+		if (0 == Readings % 64){
+			EarliestReset = atomic_load_explicit( &Increments, memory_order_acquire );
+			resetMetrics();
+			LatestReset = atomic_load_explicit( &Increments, memory_order_acquire );
+			Resets++;
+		}
+		uint32_t Before = atomic_load_explicit( &Increments, memory_order_acquire );
+		uint32_t Value = getMetric( METRIC_UART_FRAMES_IN );
+		uint32_t After = atomic_load_explicit( &Increments, memory_order_acquire );
+		// the reset has seen from EarliestReset to LatestReset+1 increments, the reading from Before to After+1
+		// (the writer may have incremented the counter, but not published the number yet)
+		uint32_t Least = (Before > LatestReset + 1)? Before - LatestReset - 1 : 0;
+		uint32_t Most = After + 1 - EarliestReset;
+		if ((Value < Least) || (Value > Most)){
+			if (Failures < 10){
+				printf( "failed: %lu counted, %lu to %lu made since the reset\n", (unsigned long)Value,
+						(unsigned long)Least, (unsigned long)Most );
+			}
+			Failures++;
+		}
+		Readings++;
+		sched_yield();
+	}
+	pthread_join( Writer, NULL );
+	printf( "concurrent reset: %lu increments, %lu resets, %lu readings\n", (unsigned long)NUMBER_OF_INCREMENTS,
+			Resets, Readings );
+}
+
+int main(void){
+	testLayout();
+	testCountersAndGauges();
+	testLatencyHistogram();
+	testConcurrentReset();
+	printf( "%u metrics, %u values; %lu failures\n", NumberOfMetrics, (unsigned)METRICS_NUMBER_OF_VALUES, Failures );
+	return (0 == Failures)? 0 : 1;
+}
@@ -0,0 +1,77 @@
+// Host-side test of the order queue (source/order_queue.c).
+// A producer thread (the main loop) pushes orders with increasing channel numbers; a consumer thread (the timer
+// interrupt) takes them, checks that they come in sequence and completes them; the producer checks the statuses.
+// Build and run: gcc -O2 -pthread -I../source -o test-order-queue test-order-queue.c && ./test-order-queue
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include "../source/order_queue.c"
+
+#define NUMBER_OF_ORDERS	2000000u
+
+static unsigned long Failures;
+
+static atomic_bool IsFinished;
+
+static void *consume( void *Argument ){
+	(void)Argument;
+	uint32_t ExpectedSequence = 0;
+	PsuOrder Order;
+	while (ExpectedSequence < NUMBER_OF_ORDERS){
+		if (!peekOrder( &Order )){
+			sched_yield();
+			continue;
+		}
+		if ((Order.Sequence != ExpectedSequence) || (Order.Channel != (uint16_t)ExpectedSequence) ||
+				(Order.Code != (uint16_t)(ExpectedSequence >> 16)))
+		{
+			Failures++;
+		}
+		completeOrder( (0 == ExpectedSequence % 3)? ORDER_STATUS_REJECTED : ORDER_STATUS_EXECUTED );
+		ExpectedSequence++;
+	}
+	atomic_store( &IsFinished, true );
+	return NULL;
+}
+
+int main(void){
+	initializeOrderQueue();
+	if (ORDER_STATUS_UNKNOWN != getOrderStatus( getIssuedOrders()-1 )){
+		Failures++;
+	}
+
+	pthread_t Consumer;
+	pthread_create( &Consumer, NULL, consume, NULL );
+	uint32_t Sequence = 0;
+	uint32_t Refused = 0;
+	while (Sequence < NUMBER_OF_ORDERS){
+		if (!reserveOrderSlot()){
+			Refused++;
+			sched_yield();
+			continue;
+		}
+		uint32_t PushedSequence;
+		if (!pushOrder( (uint16_t)(Sequence >> 16), (uint16_t)Sequence, &PushedSequence ) || (PushedSequence != Sequence)){
+			Failures++;
+		}
+		// the status of an order older than the queue size is known once it has been completed
+		if (Sequence >= ORDER_QUEUE_SIZE){
+			uint32_t OldSequence = Sequence - ORDER_QUEUE_SIZE + 1;
+			OrderStatus Status = getOrderStatus( OldSequence );
+			OrderStatus Expected = (0 == OldSequence % 3)? ORDER_STATUS_REJECTED : ORDER_STATUS_EXECUTED;
+			if ((ORDER_STATUS_PENDING != Status) && (Expected != Status)){
+				Failures++;
+			}
+		}
+		Sequence++;
+	}
+	pthread_join( Consumer, NULL );
+	if (!atomic_load( &IsFinished ) || (getCompletedOrders() != NUMBER_OF_ORDERS) ||
+			(ORDER_STATUS_UNKNOWN != getOrderStatus( 0 )) || (getOrderQueueOverflows() != Refused))
+	{
+		Failures++;
+	}
+	printf( "%u orders, %u refused (queue full), %lu failures\n", NUMBER_OF_ORDERS, Refused, Failures );
+	return (0 == Failures)? 0 : 1;
+}
@@ -0,0 +1,159 @@
+// Host-side stress test of the MPSC ring (source/ring_mpsc.h).
+// Several producer threads (interrupt handlers on both cores) push numbered events into one small ring; the consumer
+// (the main loop) checks that the events of each producer come in the order of their numbers and that no event is
+// damaged. In the first pass the producers repeat a rejected push, so every event must arrive; in the second pass
+// they give up, and the events missing at the consumer must match the rejections counted by the producers
+// and by the ring. The throughput of both passes is reported.
+// Build and run: gcc -O2 -pthread -I../source -o test-ring-mpsc test-ring-mpsc.c && ./test-ring-mpsc
+
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include "../source/ring_mpsc.h"
+
+#define NUMBER_OF_PRODUCERS		8
+#define EVENTS_PER_PRODUCER		1000000u
+#define RING_SIZE				64
+
+typedef struct {
+	uint16_t Producer;
+	uint16_t Kind;
+	uint32_t Number;
+	int32_t Value;
+	uint32_t Check;
+} TestEvent;
+
+RING_MPSC_DEFINE_TYPED(eventRing, TestEvent)
+
+static eventRing_slot_t Slots[RING_SIZE];
+
+static eventRing_t Ring;
+
+static atomic_int RunningProducers;
+
+static bool IsRetrying;
+
+static unsigned long Rejected[NUMBER_OF_PRODUCERS];
+
+static unsigned long Failures;
+
+static double nowInNanoseconds(void){
+	struct timespec Time;
+	clock_gettime( CLOCK_MONOTONIC, &Time );
+	return 1e9 * (double)Time.tv_sec + (double)Time.tv_nsec;
+}
+
+static uint32_t checkOf( const TestEvent *EventPtr ){
+	return ((uint32_t)EventPtr->Producer * 2654435761u) ^ (EventPtr->Number * 40503u) ^ (uint32_t)EventPtr->Value ^ EventPtr->Kind;
+}
+
+static void *produceEvents( void *Argument ){
+	uint16_t Producer = (uint16_t)(uintptr_t)Argument;
+	uint32_t RandomState = Producer + 1u;
+	for (uint32_t Number = 0; Number < EVENTS_PER_PRODUCER; Number++){
+		TestEvent Event;
+		Event.Producer = Producer;
+		Event.Kind = (uint16_t)(Number % 5);
+		Event.Number = Number;
+		Event.Value = (int32_t)(Number * 31u) - 1000000;
+		Event.Check = checkOf( &Event );
+		while (!eventRingPush( &Ring, &Event )){
+			Rejected[Producer]++;
+			if (!IsRetrying){
+				break;
+			}
+			sched_yield();
+		}
+		RandomState = RandomState * 1664525u + 1013904223u;
+		if (0 == (RandomState >> 24) % 16){
+			sched_yield();	// the host may have a single processor
+		}
+	}
+	atomic_fetch_sub_explicit( &RunningProducers, 1, memory_order_release );
+	return NULL;
+}
+
+static void runPass( bool IsRetryingPass ){
+	eventRingInit( &Ring, Slots, RING_SIZE );
+	IsRetrying = IsRetryingPass;
+	atomic_store( &RunningProducers, NUMBER_OF_PRODUCERS );
+	for (int J = 0; J < NUMBER_OF_PRODUCERS; J++){
+		Rejected[J] = 0;
+	}
+
+	double Start = nowInNanoseconds();
+	pthread_t Producers[NUMBER_OF_PRODUCERS];
+	for (int J = 0; J < NUMBER_OF_PRODUCERS; J++){
+		pthread_create( &Producers[J], NULL, produceEvents, (void*)(uintptr_t)J );
+	}
+
+	int64_t LastNumbers[NUMBER_OF_PRODUCERS];
+	unsigned long Received[NUMBER_OF_PRODUCERS];
+	unsigned long Missing[NUMBER_OF_PRODUCERS];
+	for (int J = 0; J < NUMBER_OF_PRODUCERS; J++){
+		LastNumbers[J] = -1;
+		Received[J] = 0;
+		Missing[J] = 0;
+	}
+	unsigned long Total = 0;
+	for (;;){
+		bool IsFinishedBefore = (0 == atomic_load_explicit( &RunningProducers, memory_order_acquire ));
+		TestEvent Event;
+		if (!eventRingPop( &Ring, &Event )){
+			if (IsFinishedBefore){
+				break;
+			}
+			sched_yield();
+			continue;
+		}
+		Total++;
+		if ((Event.Producer >= NUMBER_OF_PRODUCERS) || (Event.Check != checkOf( &Event ))){
+			if (Failures < 10){
+				printf( "damaged event: producer %u, number %lu\n", Event.Producer, (unsigned long)Event.Number );
+			}
+			Failures++;
+			continue;
+		}
+		if ((int64_t)Event.Number <= LastNumbers[Event.Producer]){
+			if (Failures < 10){
+				printf( "producer %u: event %lu after %lld\n", Event.Producer, (unsigned long)Event.Number,
+						(long long)LastNumbers[Event.Producer] );
+			}
+			Failures++;
+			continue;
+		}
+		Missing[Event.Producer] += (unsigned long)((int64_t)Event.Number - LastNumbers[Event.Producer] - 1);
+		LastNumbers[Event.Producer] = Event.Number;
+		Received[Event.Producer]++;
+	}
+	double Time = nowInNanoseconds() - Start;
+	for (int J = 0; J < NUMBER_OF_PRODUCERS; J++){
+		pthread_join( Producers[J], NULL );
+	}
+
+	unsigned long TotalRejected = 0;
+	for (int J = 0; J < NUMBER_OF_PRODUCERS; J++){
+		Missing[J] += (unsigned long)(EVENTS_PER_PRODUCER - 1 - LastNumbers[J]);
+		unsigned long Lost = IsRetryingPass? 0 : Rejected[J];
+		if ((Received[J] + Lost != EVENTS_PER_PRODUCER) || (Missing[J] != Lost)){
+			printf( "producer %d: %lu received, %lu missing, %lu rejected\n", J, Received[J], Missing[J], Rejected[J] );
+			Failures++;
+		}
+		TotalRejected += Rejected[J];
+	}
+	if (eventRingDropped( &Ring ) != TotalRejected){
+		printf( "%lu drops counted by the ring, %lu by the producers\n", (unsigned long)eventRingDropped( &Ring ), TotalRejected );
+		Failures++;
+	}
+	printf( "%s: %lu events received, %lu pushes rejected, %.0f ns per event (%.2f million events/s)\n",
+			IsRetryingPass? "retrying producers" : "dropping producers", Total, TotalRejected, Time / (double)Total,
+			1e3 * (double)Total / Time );
+}
+
+int main(void){
+	runPass( true );
+	runPass( false );
+	printf( "%lu failures\n", Failures );
+	return (0 == Failures)? 0 : 1;
+}
@@ -0,0 +1,294 @@
+// Host-side test of the SPSC ring (source/ring_spsc.h).
+// A producer thread (an interrupt handler) writes a byte sequence using the byte, block and span operations in turn;
+// the consumer (the main loop) reads it with the byte, block, peek and span operations in turn and checks that every
+// byte comes in order. The producer counts its rejected pushes, which must match the overflow counter of the ring.
+// Then the same is done with a typed ring of records.
+// Build and run: gcc -O2 -pthread -I../source -o test-ring-spsc test-ring-spsc.c && ./test-ring-spsc
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define RING_SPSC_ENABLE_STATISTICS	1
+#include "../source/ring_spsc.h"
+
+#define NUMBER_OF_BYTES		10000000u
+#define NUMBER_OF_RECORDS	5000000u
+#define RING_SIZE			64
+#define RECORD_RING_SIZE	16
+#define LONGEST_BLOCK		40
+
+typedef struct {
+	uint32_t Sequence;
+	uint16_t Channel;
+	int32_t MicroAmperes;
+	uint32_t Check;
+} TestRecord;
+
+RING_SPSC_DEFINE_TYPED(recordRing, TestRecord)
+
+static uint8_t Storage[RING_SIZE];
+
+static ring_spsc_t Ring;
+
+static TestRecord RecordStorage[RECORD_RING_SIZE];
+
+static recordRing_t RecordRing;
+
+static atomic_bool IsFinished;
+
+static unsigned long Failures;
+
+static unsigned long RejectedPushes;
+
+static unsigned long RejectedRecords;
+
+// The byte number N of the sequence
+static uint8_t expectedByte( uint32_t Number ){
+	return (uint8_t)(Number * 7u + (Number >> 8));
+}
+
+// A simple generator shared by both threads (each has its own state)
+static uint32_t nextRandom( uint32_t *StatePtr ){
+	*StatePtr = *StatePtr * 1664525u + 1013904223u;
+	return *StatePtr >> 8;
+}
+
+static void *produceBytes( void *Argument ){
+	(void)Argument;
+	uint32_t RandomState = 1;
+	uint8_t Block[LONGEST_BLOCK];
+	uint32_t Number = 0;
+	while (Number < NUMBER_OF_BYTES){
+		uint32_t Length = 1 + nextRandom( &RandomState ) % LONGEST_BLOCK;
+		if (Length > NUMBER_OF_BYTES - Number){
+			Length = NUMBER_OF_BYTES - Number;
+		}
+		switch (nextRandom( &RandomState ) % 3){
+		case 0:		// single bytes
+			for (uint32_t J = 0; J < Length; J++){
+				if (!ringSpscPush( &Ring, expectedByte( Number ))){
+					RejectedPushes++;
+					break;
+				}
+				Number++;
+			}
+			break;
+
+		case 1:		// a block, all or nothing
+			for (uint32_t J = 0; J < Length; J++){
+				Block[J] = expectedByte( Number + J );
+			}
+			if (ringSpscPushBulk( &Ring, Block, Length )){
+				Number += Length;
+			}
+			else{
+				RejectedPushes++;
+			}
+			break;
+
+		default:	// in place, in the span
+			{
+				uint8_t *SpanPtr;
+				size_t Available = ringSpscWriteSpan( &Ring, &SpanPtr );
+				size_t Count = (Length < Available)? Length : Available;
+				for (size_t J = 0; J < Count; J++){
+					SpanPtr[J] = expectedByte( Number + (uint32_t)J );
+				}
+				ringSpscWriteCommit( &Ring, Count );
+				Number += (uint32_t)Count;
+			}
+			break;
+		}
+		if (0 != nextRandom( &RandomState ) % 4){
+			sched_yield();	// the host may have a single processor
+		}
+	}
+	atomic_store_explicit( &IsFinished, true, memory_order_release );
+	return NULL;
+}
+
+static void checkByte( uint8_t Byte, uint32_t *NumberPtr ){
+	if (Byte != expectedByte( *NumberPtr )){
+		if (Failures < 10){
+			printf( "byte %lu: 0x%02X instead of 0x%02X\n", (unsigned long)*NumberPtr, Byte, expectedByte( *NumberPtr ) );
+		}
+		Failures++;
+	}
+	(*NumberPtr)++;
+}
+
+static void testBytes( void ){
+	ringSpscInit( &Ring, Storage, RING_SIZE );
+	atomic_store( &IsFinished, false );
+	pthread_t Producer;
+	pthread_create( &Producer, NULL, produceBytes, NULL );
+
+	uint32_t RandomState = 2;
+	uint32_t Number = 0;
+	uint8_t Block[LONGEST_BLOCK];
+	for (;;){
+		bool IsFinishedBefore = atomic_load_explicit( &IsFinished, memory_order_acquire );
+		if (ringSpscIsEmpty( &Ring )){
+			if (IsFinishedBefore){
+				break;
+			}
+			sched_yield();
+			continue;
+		}
+		switch (nextRandom( &RandomState ) % 4){
+		case 0:		// single bytes
+			{
+				uint8_t Byte, PeekedByte;
+				if (ringSpscPeek( &Ring, &PeekedByte ) && ringSpscPop( &Ring, &Byte )){
+					if (PeekedByte != Byte){
+						Failures++;
+					}
+					checkByte( Byte, &Number );
+				}
+			}
+			break;
+
+		case 1:		// a block
+			{
+				size_t Count = ringSpscPopBulk( &Ring, Block, 1 + nextRandom( &RandomState ) % LONGEST_BLOCK );
+				for (size_t J = 0; J < Count; J++){
+					checkByte( Block[J], &Number );
+				}
+			}
+			break;
+
+		default:	// in place, in the span (a part of it may be left for later)
+			{
+				const uint8_t *SpanPtr;
+				size_t Available = ringSpscReadSpan( &Ring, &SpanPtr );
+				size_t Count = Available - nextRandom( &RandomState ) % (Available + 1) / 2;
+				for (size_t J = 0; J < Count; J++){
+					checkByte( SpanPtr[J], &Number );
+				}
+				ringSpscReadCommit( &Ring, Count );
+			}
+			break;
+		}
+	}
+	pthread_join( Producer, NULL );
+
+	if (Number != NUMBER_OF_BYTES){
+		printf( "%lu bytes received instead of %u\n", (unsigned long)Number, NUMBER_OF_BYTES );
+		Failures++;
+	}
+	if (ringSpscOverflows( &Ring ) != RejectedPushes){
+		printf( "%u overflows counted, %lu pushes rejected\n", ringSpscOverflows( &Ring ), RejectedPushes );
+		Failures++;
+	}
+	if (ringSpscHighWaterMark( &Ring ) > RING_SIZE - 1){
+		printf( "high-water mark %u above the capacity\n", ringSpscHighWaterMark( &Ring ) );
+		Failures++;
+	}
+	printf( "bytes: %u transferred, %lu pushes rejected, high-water mark %u of %u\n",
+			NUMBER_OF_BYTES, RejectedPushes, ringSpscHighWaterMark( &Ring ), RING_SIZE - 1 );
+}
+
+static void fillRecord( TestRecord *RecordPtr, uint32_t Sequence ){
+	RecordPtr->Sequence = Sequence;
+	RecordPtr->Channel = (uint16_t)(Sequence % 4);
+	RecordPtr->MicroAmperes = (int32_t)(Sequence * 13u) - 5000000;
+	RecordPtr->Check = ~Sequence;
+}
+
+static void *produceRecords( void *Argument ){
+	(void)Argument;
+	uint32_t RandomState = 3;
+	for (uint32_t Sequence = 0; Sequence < NUMBER_OF_RECORDS;){
+		if (0 == nextRandom( &RandomState ) % 2){
+			TestRecord Record;
+			fillRecord( &Record, Sequence );
+			if (recordRingPush( &RecordRing, &Record )){
+				Sequence++;
+			}
+			else{
+				RejectedRecords++;
+			}
+		}
+		else{
+			TestRecord *SlotPtr = recordRingReserve( &RecordRing );
+			if (NULL != SlotPtr){
+				fillRecord( SlotPtr, Sequence );
+				recordRingPublish( &RecordRing );
+				Sequence++;
+			}
+			else{
+				RejectedRecords++;
+			}
+		}
+		if (0 == nextRandom( &RandomState ) % 8){
+			sched_yield();
+		}
+	}
+	atomic_store_explicit( &IsFinished, true, memory_order_release );
+	return NULL;
+}
+
+static void testRecords( void ){
+	recordRingInit( &RecordRing, RecordStorage, RECORD_RING_SIZE );
+	atomic_store( &IsFinished, false );
+	pthread_t Producer;
+	pthread_create( &Producer, NULL, produceRecords, NULL );
+
+	uint32_t RandomState = 4;
+	uint32_t Expected = 0;
+	for (;;){
+		bool IsFinishedBefore = atomic_load_explicit( &IsFinished, memory_order_acquire );
+		TestRecord Record;
+		const TestRecord *RecordPtr = &Record;
+		bool IsTaken;
+		bool IsInPlace = (0 == nextRandom( &RandomState ) % 2);
+		if (IsInPlace){
+			RecordPtr = recordRingPeek( &RecordRing );
+			IsTaken = (NULL != RecordPtr);
+		}
+		else{
+			IsTaken = recordRingPop( &RecordRing, &Record );
+		}
+		if (!IsTaken){
+			if (IsFinishedBefore){
+				break;
+			}
+			sched_yield();
+			continue;
+		}
+		TestRecord ExpectedRecord;
+		fillRecord( &ExpectedRecord, Expected );
+		if ((RecordPtr->Sequence != Expected) || (RecordPtr->Channel != ExpectedRecord.Channel) ||
+				(RecordPtr->MicroAmperes != ExpectedRecord.MicroAmperes) || (RecordPtr->Check != ExpectedRecord.Check))
+		{
+			if (Failures < 10){
+				printf( "record %lu instead of %lu\n", (unsigned long)RecordPtr->Sequence, (unsigned long)Expected );
+			}
+			Failures++;
+		}
+		Expected++;
+		if (IsInPlace){
+			recordRingRelease( &RecordRing );
+		}
+	}
+	pthread_join( Producer, NULL );
+
+	if (Expected != NUMBER_OF_RECORDS){
+		printf( "%lu records received instead of %u\n", (unsigned long)Expected, NUMBER_OF_RECORDS );
+		Failures++;
+	}
+	if (atomic_load( &RecordRing.overflows ) != RejectedRecords){
+		printf( "%u record overflows counted, %lu pushes rejected\n", (unsigned)atomic_load( &RecordRing.overflows ), RejectedRecords );
+		Failures++;
+	}
+	printf( "records: %u transferred, %lu pushes rejected, high-water mark %u of %u\n",
+			NUMBER_OF_RECORDS, RejectedRecords, (unsigned)atomic_load( &RecordRing.high_water ), RECORD_RING_SIZE - 1 );
+}
+
+int main(void){
+	testBytes();
+	testRecords();
+	printf( "%lu failures\n", Failures );
+	return (0 == Failures)? 0 : 1;
+}
@@ -0,0 +1,267 @@
+// Host-side test of the RSTL sessions (source/rstl_session.c) over pseudo-terminals.
+// Two sessions run at once, each on its own pseudo-terminal (like UART0 and USB CDC); the test plays the master on the
+// other side of each terminal. A small interpreter stands in for rstl_protocol.c: it answers each command of a batch
+// with "<command>=<length>", so the framing, the batch responses, the echo, the binary mode and the independence
+// of the sessions can be checked without the hardware.
+// Build and run: gcc -O2 -I../source -o test-rstl-session test-rstl-session.c && ./test-rstl-session
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <time.h>
+#include "../source/conversions.c"
+#include "../source/text_format.c"
+#include "../source/rstl_session.c"
+
+#define SILENCE_IN_MICROSECONDS			100000
+#define REPLY_TIMEOUT_IN_MICROSECONDS	2000000
+#define QUIET_TIME_IN_MICROSECONDS		10000		// shorter than the silence, so a partial frame is not completed
+
+#define FILL_LINES					10
+#define FILL_LINE					"0123456789abcdefghijklmnopqr\r\n"
+
+/// A pseudo-terminal: the master side is used by the test, the slave side by the session
+typedef struct {
+	int MasterFd;
+	int SlaveFd;
+	StreamLink Link;
+	RstlSession Session;
+} Terminal;
+
+static Terminal Terminals[2];
+
+static unsigned long Failures;
+
+static uint64_t readTime( void ){
+	struct timespec Time;
+	clock_gettime( CLOCK_MONOTONIC, &Time );
+	return (uint64_t)Time.tv_sec * 1000000u + (uint64_t)Time.tv_nsec / 1000u;
+}
+
+static int readByte( void *ContextPtr ){
+	unsigned char NewByte;
+	return (1 == read( *(int*)ContextPtr, &NewByte, 1 ))? NewByte : -1;
+}
+
+static int8_t writeBytes( void *ContextPtr, const uint8_t *DataPtr, uint16_t Length ){
+	while (Length > 0){
+		ssize_t Written = write( *(int*)ContextPtr, DataPtr, Length );
+		if (Written <= 0){
+			return -1;
+		}
+		DataPtr += Written;
+		Length = (uint16_t)(Length - Written);
+	}
+	return 0;
+}
+
+static void openTerminal( Terminal *TerminalPtr, const char *Name ){
+	TerminalPtr->MasterFd = posix_openpt( O_RDWR | O_NOCTTY );
+	if ((TerminalPtr->MasterFd < 0) || (0 != grantpt( TerminalPtr->MasterFd )) || (0 != unlockpt( TerminalPtr->MasterFd ))){
+		perror( "posix_openpt" );
+		exit( 2 );
+	}
+	TerminalPtr->SlaveFd = open( ptsname( TerminalPtr->MasterFd ), O_RDWR | O_NOCTTY | O_NONBLOCK );
+	if (TerminalPtr->SlaveFd < 0){
+		perror( "open pts" );
+		exit( 2 );
+	}
+	// raw mode: no echo and no CR/LF translation by the terminal itself
+	struct termios Settings;
+	tcgetattr( TerminalPtr->SlaveFd, &Settings );
+	cfmakeraw( &Settings );
+	tcsetattr( TerminalPtr->SlaveFd, TCSANOW, &Settings );
+	fcntl( TerminalPtr->MasterFd, F_SETFL, O_NONBLOCK );
+
+	initializeStreamLink( &TerminalPtr->Link, readByte, writeBytes, readTime, &TerminalPtr->SlaveFd, SILENCE_IN_MICROSECONDS );
+	initializeSession( &TerminalPtr->Session, Name, &StreamTransport, &TerminalPtr->Link );
+}
+
+// The interpreter of the test: a text frame holds commands separated by ';' and ends with "\r\n" (or not, after silence);
+// a binary frame is answered with the same frame with the response flag in the operation code
+static void executeFrame( RstlSession *SessionPtr, const char *Frame, uint16_t Length ){
+	if (isSessionInBinaryMode( SessionPtr )){
+		uint8_t Response[LINE_BUFFER_SIZE];
+		memcpy( Response, Frame, Length );
+		Response[3] |= 0x80;
+		transmitSessionBytes( SessionPtr, Response, Length );
+		if (0x7F == (uint8_t)Frame[3]){
+			setSessionBinaryMode( SessionPtr, false );
+		}
+		return;
+	}
+	const char *FrameEnd = Frame + Length;
+	if ((Length >= 2) && ('\r' == FrameEnd[-2]) && ('\n' == FrameEnd[-1])){
+		FrameEnd -= 2;
+	}
+	startSessionResponse( SessionPtr );
+	for (const char *CommandPtr = Frame; CommandPtr < FrameEnd;){
+		const char *EndPtr = memchr( CommandPtr, ';', (size_t)(FrameEnd - CommandPtr) );
+		if (NULL == EndPtr){
+			EndPtr = FrameEnd;
+		}
+		uint16_t CommandLength = (uint16_t)(EndPtr - CommandPtr);
+		if ((5 == CommandLength) && (0 == memcmp( CommandPtr, "ECHO0", 5 ))){
+			setSessionEcho( SessionPtr, false );
+			appendSessionResponse( SessionPtr, ">" );
+		}
+		else if ((3 == CommandLength) && (0 == memcmp( CommandPtr, "BIN", 3 ))){
+			setSessionBinaryMode( SessionPtr, true );
+			appendSessionResponse( SessionPtr, ">" );
+		}
+		else if ((4 == CommandLength) && (0 == memcmp( CommandPtr, "FILL", 4 ))){
+			for (int J = 0; J < FILL_LINES; J++){
+				appendSessionResponse( SessionPtr, FILL_LINE );
+			}
+		}
+		else{
+			char ResponseBuffer[LONGEST_RESPONSE_LENGTH];
+			TextBuffer Response;
+			initializeTextBuffer( &Response, ResponseBuffer, sizeof(ResponseBuffer) );
+			for (uint16_t J = 0; J < CommandLength; J++){
+				appendCharacter( &Response, CommandPtr[J] );
+			}
+			appendCharacter( &Response, '=' );
+			appendUnsigned( &Response, CommandLength );
+			appendText( &Response, "\r\n>" );
+			appendSessionResponse( SessionPtr, ResponseBuffer );
+		}
+		CommandPtr = EndPtr + 1;
+	}
+	finishSessionResponse( SessionPtr );
+}
+
+// The main loop of the device: both sessions are served
+static void serveSessions( void ){
+	for (int J = 0; J < 2; J++){
+		const char *Frame;
+		uint16_t Length;
+		if (receiveSessionFrame( &Terminals[J].Session, &Frame, &Length )){
+			executeFrame( &Terminals[J].Session, Frame, Length );
+		}
+	}
+}
+
+// The master sends the data to one terminal and waits for the expected reply (the echo and the response);
+// nothing more may come afterwards
+static void exchange( const char *TestName, Terminal *TerminalPtr, const void *Data, size_t Length,
+		const void *Expected, size_t ExpectedLength )
+{
+	char Reply[1024];
+	size_t ReplyLength = 0;
+	if ((0 != Length) && (0 != writeBytes( &TerminalPtr->MasterFd, Data, (uint16_t)Length ))){
+		printf( "%s: write failed\n", TestName );
+		Failures++;
+		return;
+	}
+	uint64_t Deadline = readTime() + REPLY_TIMEOUT_IN_MICROSECONDS;
+	uint64_t QuietEnd = 0;
+	for (;;){
+		serveSessions();
+		ssize_t Received = read( TerminalPtr->MasterFd, Reply + ReplyLength, sizeof(Reply) - ReplyLength );
+		if (Received > 0){
+			ReplyLength += (size_t)Received;
+		}
+		uint64_t Now = readTime();
+		if ((ReplyLength >= ExpectedLength) && (0 == QuietEnd)){
+			QuietEnd = Now + QUIET_TIME_IN_MICROSECONDS;
+		}
+		if (((0 != QuietEnd) && (Now >= QuietEnd)) || (Now >= Deadline)){
+			break;
+		}
+		usleep( 200 );
+	}
+	if ((ReplyLength != ExpectedLength) || (0 != memcmp( Reply, Expected, ExpectedLength ))){
+		printf( "%s: %zu bytes received, %zu expected: \"", TestName, ReplyLength, ExpectedLength );
+		for (size_t J = 0; J < ReplyLength; J++){
+			printf( ((Reply[J] >= ' ') && (Reply[J] < 127))? "%c" : "\\x%02X", (unsigned char)Reply[J] );
+		}
+		printf( "\"\n" );
+		Failures++;
+	}
+}
+
+static void waitForSilence( void ){
+	uint64_t End = readTime() + 2*SILENCE_IN_MICROSECONDS;
+	while (readTime() < End){
+		serveSessions();
+		usleep( 200 );
+	}
+}
+
+static void exchangeText( const char *TestName, Terminal *TerminalPtr, const char *Text, const char *Expected ){
+	exchange( TestName, TerminalPtr, Text, strlen( Text ), Expected, strlen( Expected ) );
+}
+
+static void checkDroppedFrames( const char *TestName, Terminal *TerminalPtr, uint32_t Expected ){
+	if (TerminalPtr->Link.DroppedFrames != Expected){
+		printf( "%s: %u frames dropped, %u expected\n", TestName, TerminalPtr->Link.DroppedFrames, Expected );
+		Failures++;
+	}
+}
+
+int main(void){
+	Terminal *A = &Terminals[0];
+	Terminal *B = &Terminals[1];
+	openTerminal( A, "A" );
+	openTerminal( B, "B" );
+
+	exchangeText( "single command", A, "HELLO\r\n", "HELLO\r\nHELLO=5\r\n>" );
+	exchangeText( "batch", A, "A;BB;CCC\r\n", "A;BB;CCC\r\nA=1\r\nBB=2\r\nCCC=3\r\n>" );
+	exchangeText( "other session", B, "Q\r\n", "Q\r\nQ=1\r\n>" );
+
+	// the echo is turned off in one session only
+	exchangeText( "echo off", B, "ECHO0\r\n", "ECHO0\r\n>" );
+	exchangeText( "no echo", B, "X;YY\r\n", "X=1\r\nYY=2\r\n>" );
+	exchangeText( "echo in the other session", A, "Z\r\n", "Z\r\nZ=1\r\n>" );
+
+	// a frame of one session is being received while the other session executes its frames
+	exchangeText( "partial frame", A, "PAR", "PAR" );
+	exchangeText( "frames of the other session", B, "R1;R2\r\n", "R1=2\r\nR2=2\r\n>" );
+	exchangeText( "rest of the frame", A, "T\r\n", "T\r\nPART=4\r\n>" );
+
+	// a frame without the terminator is completed after a period of silence
+	exchangeText( "frame after silence", A, "PING", "PINGPING=4\r\n>" );
+
+	// the response longer than the batch buffer is sent in parts
+	char Expected[1024];
+	strcpy( Expected, "FILL\r\n" );
+	for (int J = 0; J < FILL_LINES; J++){
+		strcat( Expected, FILL_LINE );
+	}
+	strcat( Expected, ">" );
+	exchangeText( "long response", A, "FILL\r\n", Expected );
+
+	// a frame that is too long is dropped (it is echoed, but there is no response)
+	char LongFrame[LONGEST_COMMAND_LENGTH + 30];
+	memset( LongFrame, 'x', LONGEST_COMMAND_LENGTH + 10 );
+	strcpy( LongFrame + LONGEST_COMMAND_LENGTH + 10, "\r\n" );
+	exchangeText( "frame too long", A, LongFrame, LongFrame );
+	checkDroppedFrames( "frame too long", A, 1 );
+	exchangeText( "frame after the long one", A, "OK\r\n", "OK\r\nOK=2\r\n>" );
+
+	// the binary mode of one session; garbage before the sync byte is skipped
+	exchangeText( "enter binary mode", B, "BIN\r\n", ">" );
+	static const uint8_t Request[] = { 0x00, 0x13, BINARY_FRAME_SYNC, 3, 7, 0x10, 0x55, 0x12, 0x34 };
+	static const uint8_t Response[] = { BINARY_FRAME_SYNC, 3, 7, 0x90, 0x55, 0x12, 0x34 };
+	exchange( "binary frame", B, Request, sizeof(Request), Response, sizeof(Response) );
+	exchangeText( "text in the other session", A, "W\r\n", "W\r\nW=1\r\n>" );
+
+	// an incomplete binary frame is dropped after a period of silence
+	static const uint8_t Incomplete[] = { BINARY_FRAME_SYNC, 5, 1 };
+	exchange( "incomplete binary frame", B, Incomplete, sizeof(Incomplete), "", 0 );
+	waitForSilence();
+	checkDroppedFrames( "incomplete binary frame", B, 1 );
+
+	static const uint8_t Leave[] = { BINARY_FRAME_SYNC, 2, 8, 0x7F, 0xAB, 0xCD };
+	static const uint8_t LeaveResponse[] = { BINARY_FRAME_SYNC, 2, 8, 0xFF, 0xAB, 0xCD };
+	exchange( "leave binary mode", B, Leave, sizeof(Leave), LeaveResponse, sizeof(LeaveResponse) );
+	exchangeText( "text after binary mode", B, "Y\r\n", "Y=1\r\n>" );
+
+	printf( "%lu failures\n", Failures );
+	return (0 == Failures)? 0 : 1;
+}
@@ -0,0 +1,111 @@
+// Host-side test of the sequence lock (source/seqlock.h).
+// A writer (the timer interrupt, here a signal handler) publishes a structure shaped like PsuSnapshot, in which every field is
+// derived from one counter; the reader (the main loop) copies it and checks that all the fields match.
+// A torn copy would mix the fields of two publications.
+// Build and run: gcc -O2 -I../source -o test-seqlock test-seqlock.c && ./test-seqlock
+
+#include <stdio.h>
+#include <signal.h>
+#include <sys/time.h>
+#include "../source/seqlock.h"
+
+#define NUMBER_OF_PUBLICATIONS	50000u
+#define PUBLICATION_INTERVAL_US	50
+#define NUMBER_OF_CHANNELS		8
+
+typedef struct {
+	uint32_t Counter;
+	uint16_t State;
+	bool IsPowerOn;
+	uint16_t Errors[2];
+	uint16_t Setpoints[3][NUMBER_OF_CHANNELS];
+	int32_t MicroVolts[NUMBER_OF_CHANNELS];
+	bool Readings[NUMBER_OF_CHANNELS][3];
+	uint32_t CounterCopy;
+} TestSnapshot;
+
+static seqlock_t Lock;
+
+static TestSnapshot Published;
+
+static atomic_bool IsFinished;
+
+static unsigned long Failures;
+
+static void fillSnapshot( TestSnapshot *SnapshotPtr, uint32_t Counter ){
+	SnapshotPtr->Counter = Counter;
+	SnapshotPtr->State = (uint16_t)(Counter % 13);
+	SnapshotPtr->IsPowerOn = Counter & 1;
+	SnapshotPtr->Errors[0] = (uint16_t)Counter;
+	SnapshotPtr->Errors[1] = (uint16_t)(Counter >> 16);
+	for (int J = 0; J < NUMBER_OF_CHANNELS; J++){
+		for (int K = 0; K < 3; K++){
+			SnapshotPtr->Setpoints[K][J] = (uint16_t)(Counter + (uint32_t)(J*3 + K));
+			SnapshotPtr->Readings[J][K] = ((Counter >> K) ^ (uint32_t)J) & 1;
+		}
+		SnapshotPtr->MicroVolts[J] = (int32_t)(Counter * 7u) - J;
+	}
+	SnapshotPtr->CounterCopy = ~Counter;
+}
+
+static bool isConsistent( const TestSnapshot *SnapshotPtr ){
+	TestSnapshot Expected;
+	memset( &Expected, 0, sizeof(Expected) );
+	fillSnapshot( &Expected, SnapshotPtr->Counter );
+	return 0 == memcmp( &Expected, SnapshotPtr, sizeof(Expected) );
+}
+
+// The writer runs in a signal handler, so it interrupts the reader at arbitrary points, like the timer interrupt
+static void publish( int Signal ){
+	(void)Signal;
+	static TestSnapshot Snapshot;	// zeroed, so the padding is the same as in the expected copies
+	static uint32_t Counter;
+	if (Counter >= NUMBER_OF_PUBLICATIONS){
+		atomic_store_explicit( &IsFinished, true, memory_order_release );
+		return;
+	}
+	Counter++;
+	fillSnapshot( &Snapshot, Counter );
+	seqlockWrite( &Lock, &Published, &Snapshot, sizeof(Snapshot) );
+}
+
+int main(void){
+	TestSnapshot Snapshot;
+	memset( &Published, 0, sizeof(Published) );
+	fillSnapshot( &Published, 0 );
+	seqlockInit( &Lock );
+
+	struct sigaction Action;
+	memset( &Action, 0, sizeof(Action) );
+	Action.sa_handler = publish;
+	sigaction( SIGALRM, &Action, NULL );
+	struct itimerval Timer = { { 0, PUBLICATION_INTERVAL_US }, { 0, PUBLICATION_INTERVAL_US } };
+	setitimer( ITIMER_REAL, &Timer, NULL );
+
+	unsigned long Reads = 0, Retries = 0, UnlockedTornCopies = 0;
+	uint32_t LastCounter = 0;
+	while (!atomic_load_explicit( &IsFinished, memory_order_acquire )){
+		Retries += seqlockRead( &Lock, &Snapshot, &Published, sizeof(Snapshot) );
+		Reads++;
+		if (!isConsistent( &Snapshot ) || (Snapshot.Counter < LastCounter)){
+			if (Failures < 10){
+				printf( "torn or old copy: counter %lu after %lu\n", (unsigned long)Snapshot.Counter, (unsigned long)LastCounter );
+			}
+			Failures++;
+		}
+		LastCounter = Snapshot.Counter;
+
+		// the same copy without the lock shows that the test is able to detect torn copies
+		memcpy( &Snapshot, &Published, sizeof(Snapshot) );
+		if (!isConsistent( &Snapshot )){
+			UnlockedTornCopies++;
+		}
+	}
+	Timer.it_value.tv_usec = 0;
+	Timer.it_interval.tv_usec = 0;
+	setitimer( ITIMER_REAL, &Timer, NULL );
+
+	printf( "%u publications, %lu reads, %lu retries, %lu failures (%lu torn copies without the lock)\n",
+			NUMBER_OF_PUBLICATIONS, Reads, Retries, Failures, UnlockedTornCopies );
+	return (0 == Failures)? 0 : 1;
+}
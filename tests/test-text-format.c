@@ -0,0 +1,146 @@
+// Host-side test of the text formatter (source/text_format.c).
+// Every writer is compared with snprintf for random values; then the time of building a typical response
+// with snprintf and with the formatter is measured.
+// Build and run: gcc -O2 -I../source -o test-text-format test-text-format.c && ./test-text-format
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../source/conversions.c"
+#include "../source/text_format.c"
+
+#define RANDOM_VALUES		5000000
+#define REPETITIONS			2000000
+
+static unsigned long Failures;
+
+static uint32_t RandomState = 12345;
+
+static uint32_t nextRandom(void){
+	RandomState = RandomState * 1103515245u + 12345u;
+	return (RandomState >> 16) | (RandomState << 16);
+}
+
+static double nowInNanoseconds(void){
+	struct timespec Time;
+	clock_gettime( CLOCK_MONOTONIC, &Time );
+	return 1e9 * (double)Time.tv_sec + (double)Time.tv_nsec;
+}
+
+static void compare( const char *Name, const char *Actual, const char *Expected ){
+	if (0 != strcmp( Actual, Expected )){
+		if (Failures < 20){
+			printf( "%s: expected \"%s\", actual \"%s\"\n", Name, Expected, Actual );
+		}
+		Failures++;
+	}
+}
+
+// The previous way of printing micro-units (formatMicroUnits in rstl_protocol.c)
+static void formatMicroUnits( char *Buffer, size_t BufferSize, int32_t MicroUnits, uint8_t Decimals ){
+	int32_t Rounded = roundMicroUnits( MicroUnits, Decimals );
+	uint32_t Magnitude = (Rounded < 0)? (uint32_t)(-Rounded) : (uint32_t)Rounded;
+	uint32_t Divider = 1;
+	for (uint8_t J = 0; J < Decimals; J++){
+		Divider *= 10;
+	}
+	if (0 == Decimals){
+		snprintf( Buffer, BufferSize, "%s%lu", (Rounded < 0)? "-" : "", (unsigned long)Magnitude );
+	}
+	else{
+		snprintf( Buffer, BufferSize, "%s%lu.%0*lu", (Rounded < 0)? "-" : "",
+				(unsigned long)(Magnitude / Divider), (int)Decimals, (unsigned long)(Magnitude % Divider) );
+	}
+}
+
+static void testRandomValues(void){
+	char Actual[40], Expected[40];
+	TextBuffer Text;
+
+	for (unsigned long K = 0; K < RANDOM_VALUES; K++){
+		uint32_t Value = nextRandom();
+		int32_t SignedValue = (int32_t)Value;
+		if (0 == K % 3){
+			SignedValue %= 20000000;	// the range of currents and voltages
+		}
+
+		initializeTextBuffer( &Text, Actual, sizeof(Actual) );
+		appendUnsigned( &Text, Value );
+		snprintf( Expected, sizeof(Expected), "%lu", (unsigned long)Value );
+		compare( "unsigned", Actual, Expected );
+
+		initializeTextBuffer( &Text, Actual, sizeof(Actual) );
+		appendSigned( &Text, SignedValue );
+		snprintf( Expected, sizeof(Expected), "%ld", (long)SignedValue );
+		compare( "signed", Actual, Expected );
+
+		initializeTextBuffer( &Text, Actual, sizeof(Actual) );
+		appendPaddedUnsigned( &Text, Value % 100000, (uint8_t)(K % 9), ' ' );
+		snprintf( Expected, sizeof(Expected), "%*lu", (int)(K % 9), (unsigned long)(Value % 100000) );
+		compare( "padded", Actual, Expected );
+
+		initializeTextBuffer( &Text, Actual, sizeof(Actual) );
+		appendHexadecimal( &Text, Value, (uint8_t)(K % 9) );
+		snprintf( Expected, sizeof(Expected), "%0*lX", (int)(K % 9), (unsigned long)Value );
+		compare( "hexadecimal", Actual, Expected );
+
+		initializeTextBuffer( &Text, Actual, sizeof(Actual) );
+		appendMicroUnits( &Text, SignedValue, (uint8_t)(K % 7) );
+		formatMicroUnits( Expected, sizeof(Expected), SignedValue, (uint8_t)(K % 7) );
+		compare( "micro-units", Actual, Expected );
+	}
+
+	// truncation: the text is always terminated
+	initializeTextBuffer( &Text, Actual, 5 );
+	appendText( &Text, "abcdefgh" );
+	appendUnsigned( &Text, 123 );
+	compare( "truncation", Actual, "abcd" );
+
+	initializeTextBuffer( &Text, Actual, sizeof(Actual) );
+	appendTimestamp( &Text, 12345678 );
+	compare( "timestamp", Actual, "    12.345" );
+}
+
+// A typical response: the one of the ?TRIP command
+static void measure(void){
+	char Buffer[60];
+	TextBuffer Text;
+	volatile uint32_t Sink = 0;
+
+	double Start = nowInNanoseconds();
+	for (unsigned K = 0; K < REPETITIONS; K++){
+		size_t Length = (size_t)snprintf( Buffer, sizeof(Buffer), "F=%u CH=%u L=%lu", 1u, 2u, (unsigned long)(K & 0xFFF) );
+		formatMicroUnits( Buffer+Length, sizeof(Buffer)-Length, (int32_t)K, 3 );
+		Length = strlen( Buffer );
+		snprintf( Buffer+Length, sizeof(Buffer)-Length, " T=%lu\r\n>", 1000ul );
+		Sink += (uint8_t)Buffer[5];
+	}
+	double SnprintfTime = (nowInNanoseconds() - Start) / REPETITIONS;
+
+	Start = nowInNanoseconds();
+	for (unsigned K = 0; K < REPETITIONS; K++){
+		initializeTextBuffer( &Text, Buffer, sizeof(Buffer) );
+		appendText( &Text, "F=" );
+		appendUnsigned( &Text, 1 );
+		appendText( &Text, " CH=" );
+		appendUnsigned( &Text, 2 );
+		appendText( &Text, " L=" );
+		appendUnsigned( &Text, K & 0xFFF );
+		appendMicroUnits( &Text, (int32_t)K, 3 );
+		appendText( &Text, " T=" );
+		appendUnsigned( &Text, 1000 );
+		appendText( &Text, "\r\n>" );
+		Sink += (uint8_t)Buffer[5];
+	}
+	double FormatterTime = (nowInNanoseconds() - Start) / REPETITIONS;
+
+	printf( "?TRIP response: snprintf %6.1f ns, formatter %6.1f ns\n", SnprintfTime, FormatterTime );
+	(void)Sink;
+}
+
+int main(void){
+	testRandomValues();
+	printf( "%u values, %lu failures\n", RANDOM_VALUES, Failures );
+	measure();
+	return (0 == Failures)? 0 : 1;
+}